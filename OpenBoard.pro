@@ -40,9 +40,13 @@ QT += webkitwidgets
 QT += multimediawidgets
 QT += printsupport
 QT += core
+QT += concurrent
 
 INCLUDEPATH += src
 
+# hot path tracing (-trace argument) costs a branch per span when disabled; uncomment to compile it out
+# DEFINES += UB_NO_TRACING
+
 include(src/adaptors/adaptors.pri)
 include(src/api/api.pri)
 include(src/board/board.pri)
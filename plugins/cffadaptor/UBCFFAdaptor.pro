@@ -41,7 +41,7 @@ macx:{
 
 LIBS     += "-L$$THIRD_PARTY_PATH/quazip/lib/$$SUB_DIR" "-lquazip"
 
-QT       += xml xmlpatterns core
+QT       += xml xmlpatterns core concurrent
 QT       += gui
 QT       += svg
 
@@ -25,6 +25,7 @@
 
 #include <QtCore>
 #include <QtXml>
+#include <QtConcurrent>
 #include <QTransform>
 #include <QGraphicsItem>
 #include <QSvgRenderer>
@@ -52,26 +53,20 @@ bool UBCFFAdaptor::convertUBZToIWB(const QString &from, const QString &to)
 {
     qDebug() << "starting converion from" << from << "to" << to;
 
-    QString source = QString();
-    if (QFileInfo(from).isDir() && QFile::exists(from)) {
-        qDebug() << "File specified is dir, continuing convertion";
-        source = from;
-    } else {
-        source = uncompressZip(from);
-        if (!source.isNull()) qDebug() << "File specified is zip file. Uncompressed to tmp dir, continuing convertion";
-    }
-    if (source.isNull()) {
+    // ubz archives are read entry by entry, they are not extracted first
+    if (!QFile::exists(from)) {
         qDebug() << "File specified is not a dir or a zip file, stopping covretion";
         return false;
     }
 
-    QString tmpDestination = createNewTmpDir();
-    if (tmpDestination.isNull()) {
-        qDebug() << "can't create temp destination folder. Stopping parsing...";
-        return false;
-    }
+    QDir toDir = QFileInfo(to).dir();
+    if (!toDir.exists())
+        if (!QDir().mkpath(toDir.absolutePath())) {
+            qDebug() << "can't create destination folder to compress file";
+            return false;
+        }
 
-    UBToCFFConverter tmpConvertrer(source, tmpDestination);
+    UBToCFFConverter tmpConvertrer(from, to);
     if (!tmpConvertrer) {
         qDebug() << "The convertrer class is invalid, stopping conversion. Error message" << tmpConvertrer.lastErrStr();
         return false;
@@ -82,229 +77,13 @@ bool UBCFFAdaptor::convertUBZToIWB(const QString &from, const QString &to)
     mConversionMessages << tmpConvertrer.getMessages();
 
     if (!bParceRes) {
+        QFile::remove(to);
         return false;
     }
 
-    if (!compressZip(tmpDestination, to))
-        qDebug() << "error in compression";
-
-    //Cleanning tmp souces in filesystem
-    if (!QFileInfo(from).isDir())
-    if (!freeDir(source))
-        qDebug() << "can't delete tmp directory" << QDir(source).absolutePath() << "try to delete them manually";
-
-    if (!freeDir(tmpDestination))
-        qDebug() << "can't delete tmp directory" << QDir(tmpDestination).absolutePath() << "try to delete them manually";
-
-    return true;
-}
-
-QString UBCFFAdaptor::uncompressZip(const QString &zipFile)
-{
-    QuaZip zip(zipFile);
-
-    if(!zip.open(QuaZip::mdUnzip)) {
-        qWarning() << "Import failed. Cause zip.open(): " << zip.getZipError();
-        return QString();
-    }
-
-    zip.setFileNameCodec("UTF-8");
-    QuaZipFileInfo info;
-    QuaZipFile file(&zip);
-
-    //create unique cff document root fodler
-    QString documentRootFolder = createNewTmpDir();
-
-    if (documentRootFolder.isNull()) {
-        qDebug() << "can't create tmp directory for zip file" << zipFile;
-        return QString();
-    }
-
-    QDir rootDir(documentRootFolder);
-    QFile out;
-    char c;
-    bool allOk = true;
-    for(bool more = zip.goToFirstFile(); more; more=zip.goToNextFile()) {
-        if(!zip.getCurrentFileInfo(&info)) {
-            qWarning() << "Import failed. Cause: getCurrentFileInfo(): " << zip.getZipError();
-            allOk = false;
-            break;
-        }
-        if(!file.open(QIODevice::ReadOnly)) {
-            allOk = false;
-            break;
-        }
-        if(file.getZipError()!= UNZ_OK) {
-            qWarning() << "Import failed. Cause: file.getFileName(): " << zip.getZipError();
-            allOk = false;
-            break;
-        }
-
-        QString newFileName = documentRootFolder + "/" + file.getActualFileName();
-
-        QFileInfo newFileInfo(newFileName);
-        rootDir.mkpath(newFileInfo.absolutePath());
-
-        out.setFileName(newFileName);
-        out.open(QIODevice::WriteOnly);
-
-        while(file.getChar(&c))
-            out.putChar(c);
-
-        out.close();
-
-        if(file.getZipError()!=UNZ_OK) {
-            qWarning() << "Import failed. Cause: " << zip.getZipError();
-            allOk = false;
-            break;
-        }
-        if(!file.atEnd()) {
-            qWarning() << "Import failed. Cause: read all but not EOF";
-            allOk = false;
-            break;
-        }
-        file.close();
-
-        if(file.getZipError()!=UNZ_OK) {
-            qWarning() << "Import failed. Cause: file.close(): " <<  file.getZipError();
-            allOk = false;
-            break;
-        }
-    }
-
-    if (!allOk) {
-        out.close();
-        file.close();
-        zip.close();
-        return QString();
-    }
-
-    if(zip.getZipError()!=UNZ_OK) {
-        qWarning() << "Import failed. Cause: zip.close(): " << zip.getZipError();
-        return QString();
-    }
-
-    return documentRootFolder;
-}
-
-bool UBCFFAdaptor::compressZip(const QString &source, const QString &destination)
-{
-    QDir toDir = QFileInfo(destination).dir();
-    if (!toDir.exists())
-        if (!QDir().mkpath(toDir.absolutePath())) {
-            qDebug() << "can't create destination folder to uncompress file";
-            return false;
-        }
-
-    QuaZip zip(destination);
-    zip.setFileNameCodec("UTF-8");
-    if(!zip.open(QuaZip::mdCreate)) {
-        qDebug("Export failed. Cause: zip.open(): %d", zip.getZipError());
-        return false;
-    }
-
-    QuaZipFile outZip(&zip);
-
-    QFileInfo sourceInfo(source);
-    if (sourceInfo.isDir()) {
-        if (!compressDir(QFileInfo(source).absoluteFilePath(), "", &outZip))
-            return false;
-    } else if (sourceInfo.isFile()) {
-        if (!compressFile(QFileInfo(source).absoluteFilePath(), "", &outZip))
-            return false;
-    }
-
-    return true;
-}
-
-bool UBCFFAdaptor::compressDir(const QString &dirName, const QString &parentDir, QuaZipFile *outZip)
-{
-    QFileInfoList dirFiles = QDir(dirName).entryInfoList(QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
-    QListIterator<QFileInfo> iter(dirFiles);
-    while (iter.hasNext()) {
-        QFileInfo curFile = iter.next();
-
-        if (curFile.isDir()) {
-            if (!compressDir(curFile.absoluteFilePath(), parentDir + curFile.fileName() + "/", outZip)) {
-                qDebug() << "error at compressing dir" << curFile.absoluteFilePath();
-                return false;
-            }
-        } else if (curFile.isFile()) {
-            if (!compressFile(curFile.absoluteFilePath(), parentDir, outZip)) {
-               return false;
-            }
-        }
-    }
-
     return true;
 }
 
-bool UBCFFAdaptor::compressFile(const QString &fileName, const QString &parentDir, QuaZipFile *outZip)
-{
-    QFile sourceFile(fileName);
-
-    if(!sourceFile.open(QIODevice::ReadOnly)) {
-        qDebug() << "Compression of file" << sourceFile.fileName() << " failed. Cause: inFile.open(): " << sourceFile.errorString();
-        return false;
-    }
-
-    if(!outZip->open(QIODevice::WriteOnly, QuaZipNewInfo(parentDir + QFileInfo(fileName).fileName(), sourceFile.fileName()))) {
-        qDebug() << "Compression of file" << sourceFile.fileName() << " failed. Cause: outFile.open(): " << outZip->getZipError();
-        sourceFile.close();
-        return false;
-    }
-
-    outZip->write(sourceFile.readAll());
-    if(outZip->getZipError() != UNZ_OK) {
-        qDebug() << "Compression of file" << sourceFile.fileName() << " failed. Cause: outFile.write(): " << outZip->getZipError();
-
-        sourceFile.close();
-        outZip->close();
-        return false;
-    }
-
-    if(outZip->getZipError() != UNZ_OK)
-    {
-        qWarning() << "Compression of file" << sourceFile.fileName() << " failed. Cause: outFile.close(): " << outZip->getZipError();
-
-        sourceFile.close();
-        outZip->close();
-        return false;
-    }
-
-    outZip->close();
-    sourceFile.close();
-
-    return true;
-}
-
-QString UBCFFAdaptor::createNewTmpDir()
-{
-    int tmpNumber = 0;
-    QDir systemTmp = QDir::temp();
-
-    while (true) {
-        QString dirName = QString("CFF_adaptor_filedata_store%1.%2")
-                .arg(QDateTime::currentDateTime().toString("dd_MM_yyyy_HH-mm"))
-                .arg(tmpNumber++);
-        if (!systemTmp.exists(dirName)) {
-            if (systemTmp.mkdir(dirName)) {
-                QString result = systemTmp.absolutePath() + "/" + dirName;
-                tmpDirs.append(result);
-                return result;
-            } else {
-                qDebug() << "Can't create temporary dir maybe due to permissions";
-                return QString();
-            }
-        } else if (tmpNumber == 10) {
-            qWarning() << "Import failed. Failed to create temporary file ";
-            return QString();
-        }
-        tmpNumber++;
-    }
-
-    return QString();
-}
 bool UBCFFAdaptor::deleteDir(const QString& pDirPath) const
 {
     if (pDirPath == "" || pDirPath == "." || pDirPath == "..")
@@ -339,31 +118,18 @@ QList<QString> UBCFFAdaptor::getConversionMessages()
     return mConversionMessages;
 }
 
-bool UBCFFAdaptor::freeDir(const QString &dir)
-{
-    bool result = true;
-    if (!deleteDir(dir))
-        result = false;
-
-    tmpDirs.removeAll(QDir(dir).absolutePath());
-
-    return result;
-}
-void UBCFFAdaptor::freeTmpDirs()
-{
-    foreach (QString dir, tmpDirs)
-        freeDir(dir);
-}
-
 UBCFFAdaptor::~UBCFFAdaptor()
 {
-    freeTmpDirs();
 }
 
 UBCFFAdaptor::UBToCFFConverter::UBToCFFConverter(const QString &source, const QString &destination)
 {
     sourcePath = source;
+    mSourceIsArchive = !QFileInfo(source).isDir();
+    mSourceZip = 0;
     destinationPath = destination;
+    mDestination = QSharedPointer<Destination>(new Destination);
+    mDestination->zip = 0;
 
     errorStr = noErrorMsg;
     mDataModel = new QDomDocument;
@@ -384,6 +150,27 @@ UBCFFAdaptor::UBToCFFConverter::UBToCFFConverter(const QString &source, const QS
     iwbSVGItemsAttributes.insert(tIWBTspan, iwbSVGTspanAttributes);
 }
 
+// converter for a single page, sharing the source and the destination archive of the document
+UBCFFAdaptor::UBToCFFConverter::UBToCFFConverter(const UBToCFFConverter &documentConverter, const QRect &viewbox)
+{
+    sourcePath = documentConverter.sourcePath;
+    mSourceIsArchive = documentConverter.mSourceIsArchive;
+    mSourceZip = 0;
+    destinationPath = documentConverter.destinationPath;
+    mDestination = documentConverter.mDestination;
+
+    mSVGSize = documentConverter.mSVGSize;
+    mViewbox = viewbox;
+    iwbSVGItemsAttributes = documentConverter.iwbSVGItemsAttributes;
+
+    errorStr = noErrorMsg;
+    mDataModel = new QDomDocument;
+    mDocumentToWrite = new QDomDocument;
+    mDocumentToWrite->setContent(QString("<doc></doc>"));
+
+    mIWBContentWriter = 0;
+}
+
 bool UBCFFAdaptor::UBToCFFConverter::parse()
 {
     if(!isValid()) {
@@ -393,13 +180,20 @@ bool UBCFFAdaptor::UBToCFFConverter::parse()
 
     qDebug() << "begin parsing ubz";
 
-    QFile outFile(contentIWBFileName());
-    if (!outFile.open(QIODevice::WriteOnly| QIODevice::Text)) {
-        qDebug() << "can't open output file for writing";
+    QuaZip zip(destinationPath);
+    zip.setFileNameCodec("UTF-8");
+    if (!zip.open(QuaZip::mdCreate)) {
+        qDebug() << "can't open output file for writing. Cause: zip.open():" << zip.getZipError();
         errorStr = "createXMLOutputPatternError";
         return false;
     }
 
+    mDestination->zip = &zip;
+
+    // the content refers to every converted file, it is added to the archive last
+    QBuffer outFile;
+    outFile.open(QIODevice::WriteOnly);
+
     mIWBContentWriter->setDevice(&outFile);
 
     mIWBContentWriter->writeStartDocument();
@@ -413,37 +207,226 @@ bool UBCFFAdaptor::UBToCFFConverter::parse()
         if (errorStr == noErrorMsg)
             errorStr = "MetadataParsingError";
 
-        outFile.close();
+        mDestination->zip = 0;
+        zip.close();
         return false;
     }
 
     if (!parseContent()) {
         if (errorStr == noErrorMsg)
             errorStr = "ContentParsingError";
-        outFile.close();
+
+        mDestination->zip = 0;
+        zip.close();
         return false;
     }
 
     mIWBContentWriter->writeEndElement();
     mIWBContentWriter->writeEndDocument();
 
-    outFile.close();
+    bool bRet = writeDestinationFile(fIWBContent, outFile.data());
+
+    mDestination->zip = 0;
+    zip.close();
+
+    if (bRet && zip.getZipError() != UNZ_OK) {
+        qWarning() << "Export failed. Cause: zip.close():" << zip.getZipError();
+        bRet = false;
+    }
+
+    if (!bRet) {
+        errorStr = "createXMLOutputPatternError";
+        return false;
+    }
 
     qDebug() << "finished with success";
 
     return true;
 }
+
+QIODevice *UBCFFAdaptor::UBToCFFConverter::openSourceFile(const QString &fileName)
+{
+    QString cleanFileName = QDir::cleanPath(fileName);
+
+    if (!mSourceIsArchive) {
+        QFile *file = new QFile(sourcePath + "/" + cleanFileName);
+        if (file->open(QIODevice::ReadOnly))
+            return file;
+
+        delete file;
+        return 0;
+    }
+
+    if (!mSourceZip) {
+        mSourceZip = new QuaZip(sourcePath);
+        mSourceZip->setFileNameCodec("UTF-8");
+        if (!mSourceZip->open(QuaZip::mdUnzip)) {
+            qWarning() << "can't open" << sourcePath << "Cause zip.open():" << mSourceZip->getZipError();
+            delete mSourceZip;
+            mSourceZip = 0;
+            return 0;
+        }
+    }
+
+    if (!mSourceZip->setCurrentFile(cleanFileName))
+        return 0;
+
+    QuaZipFile *file = new QuaZipFile(mSourceZip);
+    if (file->open(QIODevice::ReadOnly))
+        return file;
+
+    delete file;
+    return 0;
+}
+
+bool UBCFFAdaptor::UBToCFFConverter::readSourceFile(const QString &fileName, QByteArray &data)
+{
+    QIODevice *file = openSourceFile(fileName);
+    if (!file)
+        return false;
+
+    data = file->readAll();
+    file->close();
+    delete file;
+
+    return true;
+}
+
+bool UBCFFAdaptor::UBToCFFConverter::sourceFileExists(const QString &fileName)
+{
+    if (!mSourceIsArchive)
+        return QFile::exists(sourcePath + "/" + fileName);
+
+    QIODevice *file = openSourceFile(fileName);
+    if (!file)
+        return false;
+
+    file->close();
+    delete file;
+
+    return true;
+}
+
+QStringList UBCFFAdaptor::UBToCFFConverter::sourcePageFileNames()
+{
+    QStringList fileFilters;
+    fileFilters << QString(pageAlias + "???." + pageFileExtentionUBZ);
+
+    if (!mSourceIsArchive)
+        return QDir(sourcePath).entryList(fileFilters, QDir::Files, QDir::Name | QDir::IgnoreCase);
+
+    QStringList pageList;
+
+    QuaZip zip(sourcePath);
+    zip.setFileNameCodec("UTF-8");
+    if (!zip.open(QuaZip::mdUnzip))
+        return pageList;
+
+    QRegExp pageFilter(fileFilters.first(), Qt::CaseInsensitive, QRegExp::Wildcard);
+    for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile()) {
+        QString fileName = zip.getCurrentFileName();
+        if (pageFilter.exactMatch(fileName))
+            pageList << fileName;
+    }
+
+    zip.close();
+
+    pageList.sort(Qt::CaseInsensitive);
+    return pageList;
+}
+
+// reads the viewbox of a page without parsing the page itself
+QRect UBCFFAdaptor::UBToCFFConverter::pageViewbox(const QString &pageFileName)
+{
+    QRect viewbox;
+
+    QIODevice *pageFile = openSourceFile(pageFileName);
+    if (!pageFile)
+        return viewbox;
+
+    QXmlStreamReader reader(pageFile);
+    while (!reader.atEnd()) {
+        if (reader.readNext() == QXmlStreamReader::StartElement) {
+            if (reader.name() == tSvg && reader.attributes().hasAttribute(aUBZViewBox))
+                viewbox = getViewboxRect(reader.attributes().value(aUBZViewBox).toString());
+            break;
+        }
+    }
+
+    pageFile->close();
+    delete pageFile;
+
+    return viewbox;
+}
+
+bool UBCFFAdaptor::UBToCFFConverter::writeDestinationFile(const QString &fileName, const QByteArray &data)
+{
+    QMutexLocker locker(&mDestination->mutex);
+
+    if (!mDestination->zip)
+        return false;
+
+    QuaZipFile outZip(mDestination->zip);
+    if (!outZip.open(QIODevice::WriteOnly, QuaZipNewInfo(fileName))) {
+        qDebug() << "Compression of file" << fileName << " failed. Cause: outFile.open(): " << outZip.getZipError();
+        return false;
+    }
+
+    outZip.write(data);
+    if (outZip.getZipError() != UNZ_OK) {
+        qDebug() << "Compression of file" << fileName << " failed. Cause: outFile.write(): " << outZip.getZipError();
+        outZip.close();
+        return false;
+    }
+
+    outZip.close();
+    if (outZip.getZipError() != UNZ_OK) {
+        qWarning() << "Compression of file" << fileName << " failed. Cause: outFile.close(): " << outZip.getZipError();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Write a converted file to the destination archive once per document.
+ * Pages converted in parallel asking for the same key wait for the first conversion and share its result.
+ * Returns the name of the file in the archive, or an empty string if the conversion failed.
+ */
+QString UBCFFAdaptor::UBToCFFConverter::convertFile(const QString &key, const QString &fileName, std::function<bool(const QString &)> convert)
+{
+    mDestination->mutex.lock();
+
+    QSharedPointer<ConvertedFile> convertedFile = mDestination->convertedFiles.value(key);
+    if (convertedFile) {
+        mDestination->mutex.unlock();
+
+        QMutexLocker locker(&convertedFile->mutex);
+        return convertedFile->fileName;
+    }
+
+    convertedFile = QSharedPointer<ConvertedFile>(new ConvertedFile);
+    mDestination->convertedFiles.insert(key, convertedFile);
+
+    QMutexLocker locker(&convertedFile->mutex);
+    mDestination->mutex.unlock();
+
+    if (convert(fileName))
+        convertedFile->fileName = fileName;
+
+    return convertedFile->fileName;
+}
 bool UBCFFAdaptor::UBToCFFConverter::parseMetadata()
 {
     int errorLine, errorColumn;
-    QFile metaDataFile(sourcePath + "/" + fMetadata);
+    QByteArray metaData;
 
-    if (!metaDataFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!readSourceFile(fMetadata, metaData)) {
         errorStr = "can't open" + QFileInfo(sourcePath + "/" + fMetadata).absoluteFilePath();
         qDebug() << errorStr;
         return false;
 
-    } else if (!mDataModel->setContent(metaDataFile.readAll(), true, &errorStr, &errorLine, &errorColumn)) {
+    } else if (!mDataModel->setContent(metaData, true, &errorStr, &errorLine, &errorColumn)) {
         qWarning() << "Error:Parseerroratline" << errorLine << ","
                    << "column" << errorColumn << ":" << errorStr;
         return false;
@@ -500,44 +483,76 @@ bool UBCFFAdaptor::UBToCFFConverter::parseMetadata()
         }
     }
 
-    metaDataFile.close();
     return true;
 }
 bool UBCFFAdaptor::UBToCFFConverter::parseContent() {
 
-    QDir sourceDir(sourcePath);
-    QStringList fileFilters;
-    fileFilters << QString(pageAlias + "???." + pageFileExtentionUBZ);
-    QStringList pageList = sourceDir.entryList(fileFilters, QDir::Files, QDir::Name | QDir::IgnoreCase);
-
-    QDomElement svgDocumentSection = mDataModel->createElementNS(svgIWBNS, ":"+tSvg);
+    QStringList pageList = pageFileNamesFromManifest();
+    if (pageList.isEmpty())
+        pageList = sourcePageFileNames();
 
     if (!pageList.count()) {
         qDebug() << "can't find any content file";
         errorStr = "ErrorContentFile";
         return false;
-    } else 
-    {
-        QDomElement pageset = parsePageset(pageList);
-        if (pageset.isNull())
-            return false;
-        else
-            svgDocumentSection.appendChild(pageset);
     }
 
-    
+    // pages are independent and converted on the global thread pool. A page background covers the viewboxes
+    // of all the pages before it, so each page converter starts with the union of those
+    QList<QFuture<PageResult> > pages;
+    QRect viewbox = mViewbox;
+    foreach (QString pageFileName, pageList) {
+        pages << QtConcurrent::run(this, &UBToCFFConverter::convertPage, pageFileName, viewbox);
+        viewbox |= pageViewbox(pageFileName);
+    }
+
+    mViewbox = viewbox;
     if (QRect() == mViewbox)
     {
         mViewbox.setRect(0,0, mSVGSize.width(), mSVGSize.height());
     }
 
+    QDomElement svgDocumentSection = mDataModel->createElementNS(svgIWBNS, ":"+tSvg);
     svgDocumentSection.setAttribute(aIWBViewBox, rectToIWBAttr(mViewbox));
     svgDocumentSection.setAttribute(aWidth, QString("%1").arg(mViewbox.width()));
     svgDocumentSection.setAttribute(aHeight, QString("%1").arg(mViewbox.height()));
 
+    writeQDomElementStartToXML(svgDocumentSection);
+    writeQDomElementStartToXML(mDocumentToWrite->createElementNS(svgIWBNS,":"+ tIWBPageSet));
+
+    // pages are written as soon as they and the pages before them are converted
+    bool bRet = true;
+    int iPageNo = 1;
+    QList<QDomDocument> pageDocuments; // owners of the extended elements, written last
+
+    for (int i = 0; i < pages.count(); i++) {
+        PageResult page = pages.at(i).result();
+
+        if (page.error != noErrorMsg)
+            errorStr = page.error;
+
+        if (!bRet)
+            continue;
+
+        mExportErrorList << page.messages;
 
-    writeQDomElementToXML(svgDocumentSection);
+        if (page.page.isNull()) {
+            bRet = false; // keep waiting for the other pages, they write to the destination archive
+            continue;
+        }
+
+        page.page.setAttribute(tId, iPageNo++);
+        writeQDomElementToXML(page.page);
 
+        mExtendedElements << page.extendedElements;
+        pageDocuments << page.document;
+    }
+
+    if (!bRet)
+        return false;
+
+    mIWBContentWriter->writeEndElement();
+    mIWBContentWriter->writeEndElement();
 
     if (!writeExtendedIwbSection()) {
         if (errorStr == noErrorMsg)
@@ -548,21 +563,38 @@ bool UBCFFAdaptor::UBToCFFConverter::parseContent() {
     return true;
 }
 
+UBCFFAdaptor::UBToCFFConverter::PageResult UBCFFAdaptor::UBToCFFConverter::convertPage(const QString &pageFileName, const QRect &viewbox) const
+{
+    UBToCFFConverter pageConverter(*this, viewbox);
+
+    PageResult result;
+    result.page = pageConverter.parsePage(pageFileName);
+
+    // keep every element written later in a single document outliving the page converter
+    result.document = *pageConverter.mDocumentToWrite;
+    foreach (QDomElement extendedElement, pageConverter.mExtendedElements)
+        result.extendedElements << result.document.importNode(extendedElement, true).toElement();
+
+    result.messages = pageConverter.getMessages();
+    result.error = pageConverter.lastErrStr();
+
+    return result;
+}
+
 QDomElement UBCFFAdaptor::UBToCFFConverter::parsePage(const QString &pageFileName)
 {
     qDebug() << "begin parsing page" + pageFileName;
     mSvgElements.clear(); //clean Svg elements map before parsing new page
 
     int errorLine, errorColumn;
+    QByteArray pageData;
 
-    QFile pageFile(sourcePath + "/" + pageFileName);
-    if (!pageFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!readSourceFile(pageFileName, pageData)) {
         qDebug() << "can't open file" << pageFileName << "for reading";
         return QDomElement();
-    } else if (!mDataModel->setContent(pageFile.readAll(), true, &errorStr, &errorLine, &errorColumn)) {
+    } else if (!mDataModel->setContent(pageData, true, &errorStr, &errorLine, &errorColumn)) {
         qWarning() << "Error:Parseerroratline" << errorLine << ","
                    << "column" << errorColumn << ":" << errorStr;
-        pageFile.close();
         return QDomElement();
     }
 
@@ -576,14 +608,12 @@ QDomElement UBCFFAdaptor::UBToCFFConverter::parsePage(const QString &pageFileNam
             page = parseSvgPageSection(nextTopElement);
             if (page.isNull()) {
                 qDebug() << "The page is empty.";
-                pageFile.close();
                 return QDomElement();
             }
         } else if (tagname == tUBZGroups) {
             group = parseGroupsPageSection(nextTopElement);
             if (group.isNull()) {
                 qDebug() << "Page doesn't contains any groups.";
-                pageFile.close();
                 return QDomElement();
             }
         }
@@ -591,46 +621,42 @@ QDomElement UBCFFAdaptor::UBToCFFConverter::parsePage(const QString &pageFileNam
         nextTopElement = nextTopElement.nextSiblingElement();
     }
 
-    pageFile.close(); 
-
     return page.hasChildNodes() ? page : QDomElement();
 }
 
-QDomElement UBCFFAdaptor::UBToCFFConverter::parsePageset(const QStringList &pageFileNames)
-{   
-    QMultiMap<int, QDomElement> pageList;
-    int iPageNo = 1;
+QStringList UBCFFAdaptor::UBToCFFConverter::pageFileNamesFromManifest()
+{
+    // documents carry an ordered page list; page file numbers don't reflect the page order
+    QStringList pageFileNames;
 
-    QStringListIterator curPage(pageFileNames);
+    QIODevice *manifestFile = openSourceFile(pageManifestUBZ);
+    if (!manifestFile)
+        return pageFileNames;
 
-    while (curPage.hasNext()) {
+    QStringList manifestPageFileNames;
 
-        QString curPageFile = curPage.next();
-        QDomElement iterElement = parsePage(curPageFile);
-        if (!iterElement.isNull())           
-        {
-            iterElement.setAttribute(tId, iPageNo);
-            addSVGElementToResultModel(iterElement, pageList, iPageNo);
-            iPageNo++; 
-        }
-        else
-            return QDomElement();
+    QXmlStreamReader reader(manifestFile);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement() && reader.name() == tPageManifestEntry)
+            manifestPageFileNames << reader.attributes().value(aPageManifestFile).toString() + "." + pageFileExtentionUBZ;
     }
 
+    if (reader.hasError()) {
+        qDebug() << "can't read page manifest" << pageManifestUBZ << reader.errorString();
+        manifestPageFileNames.clear();
+    }
 
-    if (!pageList.count())
-        return QDomElement(); 
-
-
-    QDomElement svgPagesetElement = mDocumentToWrite->createElementNS(svgIWBNS,":"+ tIWBPageSet);
+    manifestFile->close();
+    delete manifestFile;
 
-    QMapIterator<int, QDomElement> nextSVGElement(pageList);
-    nextSVGElement.toFront();
-    while (nextSVGElement.hasNext()) 
-        svgPagesetElement.appendChild(nextSVGElement.next().value());
+    foreach (QString pageFileName, manifestPageFileNames)
+        if (sourceFileExists(pageFileName))
+            pageFileNames << pageFileName;
 
-    return svgPagesetElement.hasChildNodes() ? svgPagesetElement : QDomElement();
+    return pageFileNames;
 }
+
 QDomElement UBCFFAdaptor::UBToCFFConverter::parseSvgPageSection(const QDomElement &element)
 {
     //we don't know about page number, so return QDomElement.
@@ -682,18 +708,24 @@ QDomElement UBCFFAdaptor::UBToCFFConverter::parseSvgPageSection(const QDomElemen
     return svgElementPart.hasChildNodes() ? svgElementPart : QDomElement();
 }
 
+void UBCFFAdaptor::UBToCFFConverter::writeQDomElementStartToXML(const QDomElement &element)
+{
+    mIWBContentWriter->writeStartElement(element.namespaceURI(), element.tagName());
+
+    for (int i = 0; i < element.attributes().count(); i++) {
+        QDomAttr attr =  element.attributes().item(i).toAttr();
+        mIWBContentWriter->writeAttribute(attr.name(), attr.value());
+    }
+}
+
 void UBCFFAdaptor::UBToCFFConverter::writeQDomElementToXML(const QDomNode &node)
 {
     if (!node.isNull()) {
         if (node.isText())
             mIWBContentWriter->writeCharacters(node.nodeValue());
         else {
-            mIWBContentWriter->writeStartElement(node.namespaceURI(), node.toElement().tagName());
+            writeQDomElementStartToXML(node.toElement());
 
-            for (int i = 0; i < node.toElement().attributes().count(); i++) {
-                QDomAttr attr =  node.toElement().attributes().item(i).toAttr();
-                mIWBContentWriter->writeAttribute(attr.name(), attr.value());
-            }
             QDomNode child = node.firstChild();
             while(!child.isNull()) {
                 writeQDomElementToXML(child);
@@ -1110,33 +1142,29 @@ bool UBCFFAdaptor::UBToCFFConverter::setContentFromUBZ(const QDomElement &ubzEle
         srcPath = ubzElement.attribute(aSrc);
 
     QString sSrcContentFolder = getSrcContentFolderName(srcPath);
-    QString sSrcFileName = sourcePath + "/" + srcPath ;
+    QString sSrcFileName = srcPath;
     QString fileExtention = getExtentionFromFileName(sSrcFileName);
     QString sDstContentFolder = getDstContentFolderName(ubzElement.tagName());
     QString sDstFileName(QString(QUuid::createUuid().toString()+"."+convertExtention(fileExtention)));
 
+    // assets shared by several elements or pages are written to the destination once
+    QString sDstFilePath;
 
     if (itIsSupportedFormat(fileExtention)) // format is supported and we can copy src. files without changing.
     {
-        sSrcFileName = sourcePath + "/" + sSrcContentFolder + "/" + getFileNameFromPath(srcPath); // some elements must be exported as images, so we take hes existing thumbnails.
-
-        QFile srcFile;
-        srcFile.setFileName(sSrcFileName);
-
-        QDir dstDocFolder(destinationPath);
+        sSrcFileName = sSrcContentFolder + "/" + getFileNameFromPath(srcPath); // some elements must be exported as images, so we take hes existing thumbnails.
 
-        if (!dstDocFolder.exists(sDstContentFolder))
-            bRet &= dstDocFolder.mkdir(sDstContentFolder);
-
-        if (bRet)
+        sDstFilePath = convertFile(sSrcFileName, sDstContentFolder+"/"+sDstFileName, [this, sSrcFileName](const QString &dstFilePath)
         {
-            QString dstFilePath = destinationPath+"/"+sDstContentFolder+"/"+sDstFileName;
-            bRet &= srcFile.copy(dstFilePath);
-        }
+            QByteArray data;
+            return readSourceFile(sSrcFileName, data) && writeDestinationFile(dstFilePath, data);
+        });
+
+        bRet &= !sDstFilePath.isEmpty();
 
         if (bRet)
         {
-            svgElement.setAttribute(aSVGHref, sDstContentFolder+"/"+sDstFileName);
+            svgElement.setAttribute(aSVGHref, sDstFilePath);
             // NOT by standard! Enable it later!
             // validator http://validator.imsglobal.org/iwb/index.jsp?validate=package
             //svgElement.setAttribute(aSVGRequiredExtension, svgRequiredExtensionPrefix+convertExtention(fileExtention));
@@ -1147,25 +1175,26 @@ bool UBCFFAdaptor::UBToCFFConverter::setContentFromUBZ(const QDomElement &ubzEle
     {
         if (feSvg == fileExtention)
         {
-            QDir dstDocFolder(destinationPath);
+            if (feSvg == fileExtention) // svg images must be converted to PNG.
+            {
+                // the png size depends on the element scale
+                QTransform transformation = getTransformFromUBZ(ubzElement);
+                QString key = QString("%1 %2 %3").arg(sSrcFileName).arg(transformation.m11()).arg(transformation.m22());
 
-            if (!dstDocFolder.exists(sDstContentFolder))
-                bRet &= dstDocFolder.mkdir(sDstContentFolder);
+                sDstFilePath = convertFile(key, sDstContentFolder+"/"+sDstFileName, [this, sSrcFileName, transformation](const QString &dstFilePath)
+                {
+                    QByteArray svgData;
+                    return readSourceFile(sSrcFileName, svgData) && createPngFromSvg(svgData, dstFilePath, transformation);
+                });
 
-            if (bRet)
-            {
-                if (feSvg == fileExtention) // svg images must be converted to PNG.
-                {           
-                    QString dstFilePath = destinationPath+"/"+sDstContentFolder+"/"+sDstFileName;
-                    bRet &= createPngFromSvg(sSrcFileName, dstFilePath, getTransformFromUBZ(ubzElement));
-                }
-                else
-                    bRet = false;
+                bRet &= !sDstFilePath.isEmpty();
             }
+            else
+                bRet = false;
 
             if (bRet)
             {
-                svgElement.setAttribute(aSVGHref, sDstContentFolder+"/"+sDstFileName);
+                svgElement.setAttribute(aSVGHref, sDstFilePath);
                 // NOT by standard! Enable it later!
                 // validator http://validator.imsglobal.org/iwb/index.jsp?validate=package
                 //svgElement.setAttribute(aSVGRequiredExtension, svgRequiredExtensionPrefix+fePng);
@@ -1485,19 +1514,13 @@ QString UBCFFAdaptor::UBToCFFConverter::createBackgroundImage(const QDomElement
 {
     QString sRet;
 
-    QString sDstFileName(fIWBBackground);
-
-    bool bDirExists = true;
-    QDir dstDocFolder(destinationPath);
-
-    if (!dstDocFolder.exists(cfImages))
-        bDirExists &= dstDocFolder.mkdir(cfImages);
-
-    QString dstFilePath;
-    if (bDirExists)
-        dstFilePath = destinationPath+"/"+cfImages+"/"+sDstFileName;
+    // pages are converted in parallel and may have different backgrounds. Pages with the same one share it
+    QString key = QString("%1 %2 %3 %4 %5").arg(fIWBBackground).arg(size.width()).arg(size.height())
+            .arg(element.attribute(aDarkBackground)).arg(element.attribute(aCrossedBackground));
+    QString sDstFileName = QUuid::createUuid().toString()+"."+fePng;
+    QString dstFilePath = cfImages+"/"+sDstFileName;
 
-    if (!QFile().exists(dstFilePath))
+    sRet = convertFile(key, dstFilePath, [this, element, size](const QString &dstFilePath)
     {
         QRect rect(0,0, size.width(), size.height());
 
@@ -1536,39 +1559,42 @@ QString UBCFFAdaptor::UBToCFFConverter::createBackgroundImage(const QDomElement
         
         painter->end();
         painter->save();
-        
-        if (QString() != dstFilePath)
-           if (bckImage->save(dstFilePath))
-               sRet = cfImages+"/"+sDstFileName;
+
+        QByteArray imageData;
+        QBuffer imageBuffer(&imageData);
+        imageBuffer.open(QIODevice::WriteOnly);
+
+        bool bRes = bckImage->save(&imageBuffer, "PNG") && writeDestinationFile(dstFilePath, imageData);
 
         delete bckImage;
         delete painter;
-    }
-    else 
-        sRet = cfImages+"/"+sDstFileName;
+
+        return bRes;
+    });
 
     return sRet;
 }
 
-bool UBCFFAdaptor::UBToCFFConverter::createPngFromSvg(QString &svgPath, QString &dstPath, QTransform transformation, QSize size)
+bool UBCFFAdaptor::UBToCFFConverter::createPngFromSvg(const QByteArray &svgData, const QString &dstPath, QTransform transformation, QSize size)
 {
-    if (QFile().exists(svgPath))
-    {
-        QImage i(svgPath);
+    QSvgRenderer renderer(svgData);
+    if (!renderer.isValid())
+        return false;
 
-        QSize iSize = (QSize() == size)?QSize(i.size().width()*transformation.m11(), i.size().height()*transformation.m22()):size;
+    QSize svgSize = renderer.defaultSize();
+    QSize iSize = (QSize() == size)?QSize(svgSize.width()*transformation.m11(), svgSize.height()*transformation.m22()):size;
 
-        QImage image(iSize, QImage::Format_ARGB32_Premultiplied);        
-        image.fill(0);
-        QPainter imagePainter(&image);
-        QSvgRenderer renderer(svgPath);  
-        renderer.render(&imagePainter);     
-      
-        return image.save(dstPath);
+    QImage image(iSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+    QPainter imagePainter(&image);
+    renderer.render(&imagePainter);
+    imagePainter.end();
 
-    }
-    else 
-        return false;
+    QByteArray imageData;
+    QBuffer imageBuffer(&imageData);
+    imageBuffer.open(QIODevice::WriteOnly);
+
+    return image.save(&imageBuffer, "PNG") && writeDestinationFile(dstPath, imageData);
 }
 
 
@@ -1704,19 +1730,20 @@ bool UBCFFAdaptor::UBToCFFConverter::parseUBZAudio(const QDomElement &element, Q
         QString srcAudioImageFile(sAudioElementImage);
         QString elementId = QString(QUuid::createUuid().toString());
         QString sDstAudioImageFileName = elementId+"."+fePng;
-        QString dstAudioImageFilePath = destinationPath+"/"+cfImages+"/"+sDstAudioImageFileName;
-        QString dstAudioImageRelativePath = cfImages+"/"+sDstAudioImageFileName;
+        QTransform transformation = getTransformFromUBZ(element);
 
-        QFile srcFile(srcAudioImageFile);
+        // CFF cannot show SVG images, so we need to convert it to png. Audio elements of the same size share it
+        QString dstAudioImageRelativePath = convertFile(QString("%1 %2").arg(srcAudioImageFile).arg(audioImageDimention), cfImages+"/"+sDstAudioImageFileName,
+                                                        [this, srcAudioImageFile, transformation, audioImageDimention](const QString &dstFilePath)
+        {
+            QFile srcFile(srcAudioImageFile);
+            if (!srcFile.open(QIODevice::ReadOnly))
+                return false;
 
-        //creating folder for audioImage
-        QDir dstDocFolder(destinationPath);
-        bool bRes = true;
-        if (!dstDocFolder.exists(cfImages))
-            bRes &= dstDocFolder.mkdir(cfImages);
-        
-        // CFF cannot show SVG images, so we need to convert it to png.
-        if (bRes && createPngFromSvg(srcAudioImageFile, dstAudioImageFilePath, getTransformFromUBZ(element), QSize(audioImageDimention, audioImageDimention)))
+            return createPngFromSvg(srcFile.readAll(), dstFilePath, transformation, QSize(audioImageDimention, audioImageDimention));
+        });
+
+        if (!dstAudioImageRelativePath.isEmpty())
         {
             // switch section disabled because of imcompatibility with validator http://validator.imsglobal.org/iwb/index.jsp?validate=package
             // QDomElement svgSwitchSection = doc.createElementNS(svgIWBNS,svgIWBNSPrefix + ":" + tIWBSwitch);
@@ -1974,11 +2001,12 @@ UBCFFAdaptor::UBToCFFConverter::~UBToCFFConverter()
         delete mIWBContentWriter;
     if (mDocumentToWrite)
         delete mDocumentToWrite;
+    if (mSourceZip)
+        delete mSourceZip;
 }
 bool UBCFFAdaptor::UBToCFFConverter::isValid() const
 {
     bool result = QFileInfo(sourcePath).exists()
-               && QFileInfo(sourcePath).isDir()
                && errorStr == noErrorMsg;
 
     if (!result) {
@@ -2001,10 +2029,6 @@ QString UBCFFAdaptor::UBToCFFConverter::digitFileFormat(int digit) const
 {
     return QString("%1").arg(digit, 3, 10, QLatin1Char('0'));
 }
-QString UBCFFAdaptor::UBToCFFConverter::contentIWBFileName() const
-{
-    return destinationPath + "/" + fIWBContent;
-}
 
 //setting SVG dimenitons
 QSize UBCFFAdaptor::UBToCFFConverter::getSVGDimentions(const QString &element)
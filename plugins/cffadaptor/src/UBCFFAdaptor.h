@@ -26,12 +26,12 @@
 #include "UBCFFAdaptor_global.h"
 
 #include <QtCore>
+#include <QDomDocument>
+
+#include <functional>
 
 class QTransform;
-class QDomDocument;
-class QDomElement;
-class QDomNode;
-class QuaZipFile;
+class QuaZip;
 
 class UBCFFADAPTORSHARED_EXPORT UBCFFAdaptor {
     class UBToCFFConverter;
@@ -45,17 +45,6 @@ public:
     QList<QString> getConversionMessages();
 
 private:
-    QString uncompressZip(const QString &zipFile);
-    bool compressZip(const QString &source, const QString &destination);
-    bool compressDir(const QString &dirName, const QString &parentDir, QuaZipFile *outZip);
-    bool compressFile(const QString &fileName, const QString &parentDir, QuaZipFile *outZip);
-
-    QString createNewTmpDir();
-    bool freeDir(const QString &dir);
-    void freeTmpDirs();
-
-private:
-    QStringList tmpDirs;
     QList<QString> mConversionMessages;
 
 private:
@@ -64,6 +53,31 @@ private:
 
        static const int DEFAULT_LAYER = -100000;
 
+       // content of a page converted on a worker thread
+       struct PageResult
+       {
+           QDomDocument document; // owner of the elements below
+           QDomElement page;
+           QList<QDomElement> extendedElements;
+           QList<QString> messages;
+           QString error;
+       };
+
+       // a file written to the destination archive, locked while it is being converted
+       struct ConvertedFile
+       {
+           QMutex mutex;
+           QString fileName;
+       };
+
+       // destination archive, shared by the converters of all the pages
+       struct Destination
+       {
+           QuaZip *zip;
+           QMutex mutex;
+           QHash<QString, QSharedPointer<ConvertedFile> > convertedFiles;
+       };
+
     public:
         UBToCFFConverter(const QString &source, const QString &destination);
         ~UBToCFFConverter();
@@ -73,23 +87,35 @@ private:
         QList<QString> getMessages() {return mExportErrorList;}
 
     private:
+        UBToCFFConverter(const UBToCFFConverter &documentConverter, const QRect &viewbox);
 
         void addLastExportError(QString error) {mExportErrorList.append(error);}
 
+        QIODevice *openSourceFile(const QString &fileName);
+        bool readSourceFile(const QString &fileName, QByteArray &data);
+        bool sourceFileExists(const QString &fileName);
+        QStringList sourcePageFileNames();
+        QRect pageViewbox(const QString &pageFileName);
+
+        bool writeDestinationFile(const QString &fileName, const QByteArray &data);
+        QString convertFile(const QString &key, const QString &fileName, std::function<bool(const QString &)> convert);
+        PageResult convertPage(const QString &pageFileName, const QRect &viewbox) const;
+
         void fillNamespaces();
 
         bool parseMetadata();
         bool parseContent();
-        QDomElement parsePageset(const QStringList &pageFileNames);
+        QStringList pageFileNamesFromManifest();
         QDomElement parsePage(const QString &pageFileName);
         QDomElement parseSvgPageSection(const QDomElement &element);
+        void writeQDomElementStartToXML(const QDomElement &element);
         void writeQDomElementToXML(const QDomNode &node);
         bool writeExtendedIwbSection();
         QDomElement parseGroupsPageSection(const QDomElement &groupRoot);
 
         bool createBackground(const QDomElement &element, QMultiMap<int, QDomElement> &dstSvgList);
         QString createBackgroundImage(const QDomElement &element, QSize size);
-        bool createPngFromSvg(QString &svgPath, QString &dstPath,  QTransform transformation, QSize size = QSize());
+        bool createPngFromSvg(const QByteArray &svgData, const QString &dstPath, QTransform transformation, QSize size = QSize());
 
         bool parseSVGGGroup(const QDomElement &element, QMultiMap<int, QDomElement> &dstSvgList);
         bool parseUBZImage(const QDomElement &element, QMultiMap<int, QDomElement> &dstSvgList);
@@ -144,7 +170,6 @@ private:
         inline QString rectToIWBAttr(const QRect &rect) const;
         inline QString digitFileFormat(int num) const;
         inline bool strToBool(const QString &in) const {return in == "true";}
-        QString contentIWBFileName() const;
 
     private:
         QList<QString> mExportErrorList;
@@ -153,8 +178,11 @@ private:
         QXmlStreamWriter *mIWBContentWriter; //stream to write outdata
         QSize mSVGSize; //svg page size
         QRect mViewbox; //Main viewbox parameter for CFF
-        QString sourcePath; // dir with unpacked source data (ubz)
-        QString destinationPath; //dir with unpacked destination data (iwb)
+        QString sourcePath; // dir with unpacked source data, or ubz archive
+        bool mSourceIsArchive;
+        QuaZip *mSourceZip; // opened on first read, one per converter as entries can't be read concurrently
+        QString destinationPath; // iwb archive
+        QSharedPointer<Destination> mDestination;
         QDomDocument *mDocumentToWrite; //document for saved QDomElements from mSvgElements and mExtendedElements
         QMultiMap<int, QDomElement> mSvgElements; //Saving svg elements to have a sorted by z order list of elements to write;
         QList<QDomElement> mExtendedElements; //Saving extended options of elements to be able to add them to the end of result iwb document;
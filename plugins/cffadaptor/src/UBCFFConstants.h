@@ -154,6 +154,9 @@ const QString dimensionsDelimiter1 = "x";
 const QString dimensionsDelimiter2 = " ";
 const QString pageAlias = "page";
 const QString pageFileExtentionUBZ = "svg";
+const QString pageManifestUBZ = "pages.xml";
+const QString tPageManifestEntry = "page";
+const QString aPageManifestFile = "file";
 
 //content folder names
 const QString cfImages = "images";
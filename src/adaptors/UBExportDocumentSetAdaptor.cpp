@@ -38,7 +38,6 @@
 
 #include "globals/UBGlobals.h"
 #include "core/UBPersistenceManager.h"
-#include "core/UBForeignObjectsHandler.h"
 
 #ifdef Q_OS_OSX
     #include <quazip.h>
@@ -166,17 +165,13 @@ bool UBExportDocumentSetAdaptor::addDocumentToZip(const QModelIndex &pIndex, UBD
     UBDocumentProxy *pDocumentProxy = model->proxyForIndex(parentIndex);
     if (pDocumentProxy) {
 
-//        Q_ASSERT(QFileInfo(pDocumentProxy->persistencePath()).exists());
-//        UBForeighnObjectsHandler cleaner;
-//        cleaner.cure(pDocumentProxy->persistencePath());
-
         //UniboardSankoreTransition document;
         QString documentPath(pDocumentProxy->persistencePath());
         //document.checkDocumentDirectory(documentPath);
 
         QDir documentDir = QDir(pDocumentProxy->persistencePath());
         QuaZipFile zipFile(&zip);
-        UBFileSystemUtils::compressDirInZip(documentDir, QFileInfo(documentPath).fileName() + "/", &zipFile, false);
+        UBFileSystemUtils::compressDirInZip(documentDir, QFileInfo(documentPath).fileName() + "/", &zipFile, true);
 
         if(zip.getZipError() != 0)
         {
@@ -34,6 +34,7 @@
 
 #include "core/UBDocumentManager.h"
 #include "core/UBApplication.h"
+#include "core/UBDocumentJournal.h"
 
 #include "document/UBDocumentProxy.h"
 
@@ -71,6 +72,12 @@ void UBExportWeb::persist(UBDocumentProxy* pDocumentProxy)
 
         if(UBFileSystemUtils::copyDir(pDocumentProxy->persistencePath(), dirName))
         {
+            foreach(QString fileName, QDir(dirName).entryList(QDir::Files | QDir::Hidden))
+            {
+                if (UBDocumentJournal::isJournalFile(fileName))
+                    QFile::remove(dirName + "/" + fileName);
+            }
+
             QString htmlPath = dirName + "/index.html";
 
             QFile html(":www/OpenBoard-web-player.html");
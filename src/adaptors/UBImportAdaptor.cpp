@@ -54,6 +54,15 @@ UBPageBasedImportAdaptor::UBPageBasedImportAdaptor(QObject *parent)
     // NOOP
 }
 
+bool UBPageBasedImportAdaptor::importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath)
+{
+    Q_UNUSED(document);
+    Q_UNUSED(uuid);
+    Q_UNUSED(filePath);
+
+    return false;
+}
+
 UBDocumentBasedImportAdaptor::UBDocumentBasedImportAdaptor(QObject *parent)
     :UBImportAdaptor(true, parent)
 {
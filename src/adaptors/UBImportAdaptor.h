@@ -64,6 +64,10 @@ public:
         virtual QList<UBGraphicsItem*> import(const QUuid& uuid, const QString& filePath) = 0;
         virtual void placeImportedItemToScene(UBGraphicsScene* scene, UBGraphicsItem* item) = 0;
         virtual const QString& folderToCopy() = 0;
+
+        // writes the pages of filePath at the end of document without going through a scene per page;
+        // adaptors that cannot return false and the pages are imported through import()
+        virtual bool importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath);
 };
 
 class UBDocumentBasedImportAdaptor : public UBImportAdaptor
@@ -29,10 +29,21 @@
 
 #include "UBImportPDF.h"
 
+#include <QtConcurrent>
+
 #include "document/UBDocumentProxy.h"
+#include "document/UBDocumentController.h"
+
+#include "board/UBBoardController.h"
 
 #include "core/UBApplication.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBPageManifest.h"
+#include "core/UBDocumentJournal.h"
+#include "core/UBSettings.h"
+#include "core/UBTrace.h"
+
+#include "adaptors/UBThumbnailAdaptor.h"
 
 #include "domain/UBGraphicsPDFItem.h"
 
@@ -45,12 +56,24 @@ UBImportPDF::UBImportPDF(QObject *parent)
 {
     QDesktopWidget* desktop = UBApplication::desktop();
     this->dpi = (desktop->physicalDpiX() + desktop->physicalDpiY()) / 2;
+
+    // thumbnails finishing close together are shown in one go
+    mRefreshTimer.setSingleShot(true);
+    mRefreshTimer.setInterval(250);
+    connect(&mRefreshTimer, SIGNAL(timeout()), this, SLOT(refreshRenderedThumbnails()));
 }
 
 
 UBImportPDF::~UBImportPDF()
 {
-    // NOOP
+    mCancelled.storeRelease(1);
+
+    foreach(QFutureWatcher<void>* watcher, mThumbnailWorkers.keys())
+    {
+        watcher->waitForFinished();
+        delete mThumbnailWorkers.value(watcher);
+        delete watcher;
+    }
 }
 
 
@@ -104,3 +127,185 @@ const QString& UBImportPDF::folderToCopy()
 {
     return UBPersistenceManager::objectDirectory;
 }
+
+/*
+ * Writes the pages straight from the pdf page sizes instead of building and saving a scene for
+ * each of them, so the document can be opened as soon as its pages are on disk. The thumbnails
+ * are rendered afterwards by a few workers, each with a renderer of its own, and show up in the
+ * document views as they get ready.
+ */
+bool UBImportPDF::importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath)
+{
+    UB_TRACE_SCOPE("UBImportPDF::importPages");
+
+    PDFRenderer *pdfRenderer = PDFRenderer::createUnsharedRenderer(filePath);
+
+    if (!pdfRenderer->isValid())
+    {
+        delete pdfRenderer;
+        return false;
+    }
+    pdfRenderer->setDPI(this->dpi);
+
+    QString documentPath = document->persistencePath();
+    int pdfPageCount = pdfRenderer->pageCount();
+    QList<QSizeF> pageSizes;
+
+    for(int pdfPageNumber = 1; pdfPageNumber <= pdfPageCount; pdfPageNumber++)
+    {
+        UBApplication::showMessage(tr("Importing page %1 of %2").arg(pdfPageNumber).arg(pdfPageCount), true);
+        pageSizes << pdfRenderer->pageSizeF(pdfPageNumber);
+    }
+
+    int firstPageIndex = document->pageCount();
+    QList<int> writtenPages = UBPersistenceManager::persistenceManager()->insertDocumentPdfPagesAt(document, firstPageIndex, uuid, pageSizes);
+
+    UBPageManifest* pages = UBPageManifest::manifest(documentPath);
+    QSizeF pageSize;
+    QList<ThumbnailJob> jobs;
+
+    for (int i = 0; i < writtenPages.size(); i++)
+    {
+        int pageIndex = firstPageIndex + i;
+        pageSize = pageSizes.at(writtenPages.at(i) - 1);
+
+        ThumbnailJob job;
+        job.pageId = pages->pageId(pageIndex);
+        job.pdfPageNumber = writtenPages.at(i);
+        job.thumbnailPath = pages->thumbnailFilePath(pageIndex);
+        jobs << job;
+
+        qreal width = UBSettings::maxThumbnailWidth;
+        UBThumbnailAdaptor::setPending(job.thumbnailPath, QSize(width, width * pageSize.height() / pageSize.width()));
+    }
+
+    delete pdfRenderer;
+
+    if (jobs.isEmpty())
+        return true;
+
+    document->setDefaultDocumentSize(QSize(pageSize.width(), pageSize.height()));
+
+    int workerCount = qMin(jobs.count(), qBound(1, QThread::idealThreadCount(), 4));
+
+    for (int worker = 0; worker < workerCount; worker++)
+    {
+        QList<ThumbnailJob> workerJobs;
+        for (int i = worker; i < jobs.count(); i += workerCount)
+            workerJobs << jobs.at(i);
+
+        PDFRenderer *workerRenderer = PDFRenderer::createUnsharedRenderer(filePath);
+        workerRenderer->setDPI(this->dpi);
+
+        QFutureWatcher<void>* watcher = new QFutureWatcher<void>();
+        connect(watcher, SIGNAL(finished()), this, SLOT(thumbnailWorkerFinished()));
+        mThumbnailWorkers.insert(watcher, workerRenderer);
+
+        watcher->setFuture(QtConcurrent::run(this, &UBImportPDF::renderThumbnails, workerRenderer, documentPath, workerJobs));
+    }
+
+    return true;
+}
+
+
+void UBImportPDF::renderThumbnails(PDFRenderer* renderer, const QString& documentPath, const QList<ThumbnailJob>& jobs)
+{
+    foreach(const ThumbnailJob& job, jobs)
+    {
+        if (mCancelled.loadAcquire())
+            return;
+
+        QByteArray thumbData;
+
+        // a page saved in the meantime already got its thumbnail from its scene; this is only a
+        // shortcut, the slot checks again before writing
+        if (!QFile::exists(job.thumbnailPath))
+        {
+            QSizeF pageSize = renderer->pageSizeF(job.pdfPageNumber);
+            qreal scale = UBSettings::maxThumbnailWidth / pageSize.width();
+
+            QImage thumb(UBSettings::maxThumbnailWidth, pageSize.height() * scale, QImage::Format_RGB32);
+            thumb.fill(Qt::white);
+
+            QPainter painter(&thumb);
+            painter.scale(scale, scale);
+            renderer->render(&painter, job.pdfPageNumber, false);
+            painter.end();
+
+            QBuffer thumbBuffer(&thumbData);
+            thumbBuffer.open(QIODevice::WriteOnly);
+            thumb.save(&thumbBuffer, "JPG");
+        }
+
+        QMetaObject::invokeMethod(this, "thumbnailRendered", Qt::QueuedConnection,
+                                  Q_ARG(QString, documentPath), Q_ARG(QUuid, job.pageId),
+                                  Q_ARG(QString, job.thumbnailPath), Q_ARG(QByteArray, thumbData));
+    }
+}
+
+
+// the thumbnail is only written here, on the main thread, so it can neither replace the one of a
+// page saved meanwhile nor land on a page that was deleted or whose file got reused
+void UBImportPDF::thumbnailRendered(const QString& documentPath, const QUuid& pageId, const QString& thumbnailPath, const QByteArray& thumbData)
+{
+    UBThumbnailAdaptor::clearPending(thumbnailPath);
+
+    UBPageManifest* pages = UBPageManifest::manifest(documentPath);
+    int index = pages->indexOf(pageId);
+
+    if (index < 0 || pages->thumbnailFilePath(index) != thumbnailPath)
+        return;
+
+    if (!thumbData.isEmpty() && !QFile::exists(thumbnailPath))
+    {
+        if (!UBDocumentJournal::writeFile(thumbnailPath, thumbData))
+            qWarning() << "cannot write thumbnail" << thumbnailPath;
+    }
+
+    mRenderedThumbnails[documentPath] << pageId;
+
+    if (!mRefreshTimer.isActive())
+        mRefreshTimer.start();
+}
+
+
+void UBImportPDF::refreshRenderedThumbnails()
+{
+    QList<UBDocumentContainer*> containers;
+    containers << UBApplication::boardController << UBApplication::documentController;
+
+    foreach(UBDocumentContainer* container, containers)
+    {
+        if (!container || !container->selectedDocument())
+            continue;
+
+        QString documentPath = container->selectedDocument()->persistencePath();
+        if (!mRenderedThumbnails.contains(documentPath))
+            continue;
+
+        // pages may have been moved or deleted while their thumbnail was rendered
+        UBPageManifest* pages = UBPageManifest::manifest(documentPath);
+        QList<int> indexes;
+
+        foreach(const QUuid& pageId, mRenderedThumbnails.value(documentPath))
+        {
+            int index = pages->indexOf(pageId);
+            if (index >= 0)
+                indexes << index;
+        }
+
+        if (!indexes.isEmpty())
+            container->updatePages(indexes);
+    }
+
+    mRenderedThumbnails.clear();
+}
+
+
+void UBImportPDF::thumbnailWorkerFinished()
+{
+    QFutureWatcher<void>* watcher = static_cast<QFutureWatcher<void>*>(sender());
+
+    delete mThumbnailWorkers.take(watcher);
+    watcher->deleteLater();
+}
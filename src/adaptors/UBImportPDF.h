@@ -34,6 +34,7 @@
 #include "UBImportAdaptor.h"
 
 class UBDocumentProxy;
+class PDFRenderer;
 
 class UBImportPDF : public UBPageBasedImportAdaptor
 {
@@ -50,8 +51,29 @@ class UBImportPDF : public UBPageBasedImportAdaptor
         virtual void placeImportedItemToScene(UBGraphicsScene* scene, UBGraphicsItem* item);
         virtual const QString& folderToCopy();
 
+        virtual bool importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath);
+
+    private slots:
+        void thumbnailRendered(const QString& documentPath, const QUuid& pageId, const QString& thumbnailPath, const QByteArray& thumbData);
+        void thumbnailWorkerFinished();
+        void refreshRenderedThumbnails();
+
     private:
+        struct ThumbnailJob
+        {
+            QUuid pageId;
+            int pdfPageNumber;
+            QString thumbnailPath;
+        };
+
+        void renderThumbnails(PDFRenderer* renderer, const QString& documentPath, const QList<ThumbnailJob>& jobs);
+
         int dpi;
+
+        QAtomicInt mCancelled;
+        QHash<QFutureWatcher<void>*, PDFRenderer*> mThumbnailWorkers;
+        QHash<QString, QList<QUuid> > mRenderedThumbnails;
+        QTimer mRefreshTimer;
 };
 
 #endif /* UBIMPORTPDF_H_ */
@@ -35,6 +35,7 @@
 
 #include "core/UBSettings.h"
 #include "core/UBApplication.h"
+#include "core/UBDocumentJournal.h"
 #include "board/UBBoardController.h"
 
 #include "document/UBDocumentProxy.h"
@@ -81,7 +82,7 @@ UBMetadataDcSubsetAdaptor::~UBMetadataDcSubsetAdaptor()
 }
 
 
-void UBMetadataDcSubsetAdaptor::persist(UBDocumentProxy* proxy)
+void UBMetadataDcSubsetAdaptor::persist(UBDocumentProxy* proxy, UBDocumentJournal* journal)
 {
     if(!QDir(proxy->persistencePath()).exists()){
         //In this case the a document is an empty document so we do not persist it
@@ -89,15 +90,10 @@ void UBMetadataDcSubsetAdaptor::persist(UBDocumentProxy* proxy)
     }
     QString fileName = proxy->persistencePath() + "/" + metadataFilename;
     qWarning() << "Persisting document; path is" << fileName;
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
-    {
-        qCritical() << "cannot open " << fileName << " for writing ...";
-        qCritical() << "error : "  << file.errorString();
-        return;
-    }
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
 
-    QXmlStreamWriter xmlWriter(&file);
+    QXmlStreamWriter xmlWriter(&buffer);
     xmlWriter.setAutoFormatting(true);
 
     xmlWriter.writeStartDocument();
@@ -127,13 +123,21 @@ void UBMetadataDcSubsetAdaptor::persist(UBDocumentProxy* proxy)
 
     xmlWriter.writeTextElement(UBSettings::uniboardDocumentNamespaceUri, "page-count", QString::number(proxy->pageCount()));
 
+    // item count of the sole page of single page documents, as of its last save
+    if (!proxy->metaData(UBSettings::documentItemCountPage).toString().isEmpty())
+    {
+        xmlWriter.writeStartElement(UBSettings::uniboardDocumentNamespaceUri, "item-count");
+        xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "page", proxy->metaData(UBSettings::documentItemCountPage).toString());
+        xmlWriter.writeCharacters(QString::number(proxy->metaData(UBSettings::documentItemCount).toInt()));
+        xmlWriter.writeEndElement();
+    }
+
     xmlWriter.writeEndElement(); //dc:Description
     xmlWriter.writeEndElement(); //RDF
 
     xmlWriter.writeEndDocument();
 
-    file.flush();
-    file.close();
+    UBDocumentJournal::writeFile(fileName, buffer.data(), journal);
 }
 
 
@@ -231,6 +235,12 @@ QMap<QString, QVariant> UBMetadataDcSubsetAdaptor::load(QString pPath)
                 {
                     metadata.insert(UBSettings::documentPageCount, xml.readElementText());
                 }
+                else if (xml.name() == "item-count"
+                        && xml.namespaceUri() == UBSettings::uniboardDocumentNamespaceUri)
+                {
+                    metadata.insert(UBSettings::documentItemCountPage, xml.attributes().value(UBSettings::uniboardDocumentNamespaceUri, "page").toString());
+                    metadata.insert(UBSettings::documentItemCount, xml.readElementText().toInt());
+                }
                 metadata.insert(UBSettings::documentVersion, docVersion);
             }
 
@@ -33,6 +33,7 @@
 #include <QtGui>
 
 class UBDocumentProxy;
+class UBDocumentJournal;
 
 class UBMetadataDcSubsetAdaptor
 {
@@ -40,7 +41,7 @@ class UBMetadataDcSubsetAdaptor
         UBMetadataDcSubsetAdaptor();
         virtual ~UBMetadataDcSubsetAdaptor();
 
-        static void persist(UBDocumentProxy* proxy);
+        static void persist(UBDocumentProxy* proxy, UBDocumentJournal* journal = 0);
         static QMap<QString, QVariant> load(QString pPath);
 
         static const QString nsRdf;
@@ -72,8 +72,12 @@
 #include "core/UBSettings.h"
 #include "core/UBSetting.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBPageManifest.h"
+#include "core/UBAssetManifest.h"
+#include "core/UBDocumentJournal.h"
 #include "core/UBApplication.h"
 #include "core/UBTextTools.h"
+#include "core/UBTrace.h"
 
 #include "pdf/PDFRenderer.h"
 
@@ -159,7 +163,7 @@ void UBSvgSubsetAdaptor::upgradeScene(UBDocumentProxy* proxy, const int pageInde
 
 QDomDocument UBSvgSubsetAdaptor::loadSceneDocument(UBDocumentProxy* proxy, const int pPageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg",pPageIndex);
+    QString fileName = UBPageManifest::svgFilePath(proxy->persistencePath(), pPageIndex);
 
     QFile file(fileName);
     QDomDocument doc("page");
@@ -182,53 +186,48 @@ QDomDocument UBSvgSubsetAdaptor::loadSceneDocument(UBDocumentProxy* proxy, const
 
 void UBSvgSubsetAdaptor::setSceneUuid(UBDocumentProxy* proxy, const int pageIndex, QUuid pUuid)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg",pageIndex);
+    QString fileName = UBPageManifest::svgFilePath(proxy->persistencePath(), pageIndex);
 
     QFile file(fileName);
 
     if (!file.exists() || !file.open(QIODevice::ReadOnly))
         return;
 
-    QTextStream textReadStream(&file);
-    QString xmlContent = textReadStream.readAll();
-    int uuidIndex = xmlContent.indexOf("uuid");
-    if (-1 == uuidIndex)
-    {
-        qWarning() << "Cannot read UUID from file" << fileName << "to set new UUID";
-        file.close();
-        return;
-    }
-    int quoteStartIndex = xmlContent.indexOf('"', uuidIndex);
-    if (-1 == quoteStartIndex)
+    // the scene uuid is the first uuid attribute of the file, on the svg element: only the head of
+    // the file is patched, the rest is streamed through unchanged
+    QByteArray head = file.read(4096);
+
+    int uuidIndex = head.indexOf("uuid");
+    int quoteStartIndex = uuidIndex == -1 ? -1 : head.indexOf('"', uuidIndex);
+    int quoteEndIndex = quoteStartIndex == -1 ? -1 : head.indexOf('"', quoteStartIndex + 1);
+
+    if (-1 == quoteEndIndex)
     {
         qWarning() << "Cannot read UUID from file" << fileName << "to set new UUID";
         file.close();
         return;
     }
-    int quoteEndIndex = xmlContent.indexOf('"', quoteStartIndex + 1);
-    if (-1 == quoteEndIndex)
+
+    QSaveFile newFile(fileName);
+
+    if (!newFile.open(QIODevice::WriteOnly))
     {
-        qWarning() << "Cannot read UUID from file" << fileName << "to set new UUID";
+        qWarning() << "Cannot open file" << fileName  << "to write UUID";
         file.close();
         return;
     }
 
-    file.close();
+    newFile.write(head.left(quoteStartIndex + 1));
+    newFile.write(UBStringUtils::toCanonicalUuid(pUuid).toUtf8());
+    newFile.write(head.mid(quoteEndIndex));
 
-    QString newXmlContent = xmlContent.left(quoteStartIndex + 1);
-    newXmlContent.append(UBStringUtils::toCanonicalUuid(pUuid));
-    newXmlContent.append(xmlContent.right(xmlContent.length() - quoteEndIndex));
+    while (!file.atEnd())
+        newFile.write(file.read(64 * 1024));
 
-    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
-    {
-        QTextStream textWriteStream(&file);
-        textWriteStream << newXmlContent;
-        file.close();
-    }
-    else
-    {
-        qWarning() << "Cannot open file" << fileName  << "to write UUID";
-    }
+    file.close();
+
+    if (!newFile.commit())
+        qWarning() << "Cannot write UUID to file" << fileName << newFile.errorString();
 }
 
 QString UBSvgSubsetAdaptor::uniboardDocumentNamespaceUriFromVersion(int mFileVersion)
@@ -239,7 +238,7 @@ QString UBSvgSubsetAdaptor::uniboardDocumentNamespaceUriFromVersion(int mFileVer
 
 UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
+    QString fileName = UBPageManifest::svgFilePath(proxy->persistencePath(), pageIndex);
     qDebug() << fileName;
     QFile file(fileName);
 
@@ -264,7 +263,7 @@ UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const int
 
 QByteArray UBSvgSubsetAdaptor::loadSceneAsText(UBDocumentProxy* proxy, const int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
+    QString fileName = UBPageManifest::svgFilePath(proxy->persistencePath(), pageIndex);
     qDebug() << fileName;
     QFile file(fileName);
 
@@ -285,9 +284,65 @@ QByteArray UBSvgSubsetAdaptor::loadSceneAsText(UBDocumentProxy* proxy, const int
 }
 
 
+/*
+ * Whether the page holds anything but its background and tools, reading it only up to the first
+ * element that would become an item of the scene.
+ */
+bool UBSvgSubsetAdaptor::hasContent(UBDocumentProxy* proxy, const int pageIndex)
+{
+    QString fileName = UBPageManifest::svgFilePath(proxy->persistencePath(), pageIndex);
+
+    QFile file(fileName);
+
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+        return false;
+
+    static QStringList tools = QStringList() << "curtain" << "ruler" << "axes" << "compass" << "protractor" << "triangle" << "cache";
+
+    QXmlStreamReader xml(&file);
+
+    int depth = 0;
+    bool backgroundFound = false;
+
+    while (!xml.atEnd())
+    {
+        xml.readNext();
+
+        if (xml.isStartElement())
+        {
+            depth++;
+
+            // items are the children of the svg element
+            if (depth != 2)
+                continue;
+
+            if (xml.name() == "rect" && !backgroundFound)
+                backgroundFound = true;
+            else if (xml.name() == tGroups)
+                continue;
+            else if (!tools.contains(xml.name().toString()))
+                return true;
+        }
+        else if (xml.isEndElement())
+        {
+            depth--;
+        }
+    }
+
+    // a page that cannot be read is kept rather than purged as empty
+    if (xml.hasError())
+    {
+        qWarning() << "error parsing page" << fileName << xml.errorString();
+        return true;
+    }
+
+    return false;
+}
+
+
 QUuid UBSvgSubsetAdaptor::sceneUuid(UBDocumentProxy* proxy, const int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
+    QString fileName = UBPageManifest::svgFilePath(proxy->persistencePath(), pageIndex);
 
     QFile file(fileName);
 
@@ -334,6 +389,8 @@ QUuid UBSvgSubsetAdaptor::sceneUuid(UBDocumentProxy* proxy, const int pageIndex)
 
 UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const QByteArray& pArray)
 {
+    UB_TRACE_SCOPE("UBSvgSubsetAdaptor::loadScene");
+
     UBSvgSubsetReader reader(proxy, UBTextTools::cleanHtmlCData(QString(pArray)).toUtf8());
     return reader.loadScene(proxy);
 }
@@ -981,6 +1038,9 @@ UBGraphicsScene* UBSvgSubsetAdaptor::UBSvgSubsetReader::loadScene(UBDocumentProx
 
     if (mScene) {
         mScene->setModified(saveSceneAfterLoading);
+        // the thumbnail on disk already shows what was just loaded
+        if (!saveSceneAfterLoading)
+            mScene->clearThumbnailDamage();
         mScene->enableUndoRedoStack();
     }
 
@@ -1108,56 +1168,101 @@ QGraphicsItem *UBSvgSubsetAdaptor::UBSvgSubsetReader::readElementFromGroup()
     return result;
 }
 
-void UBSvgSubsetAdaptor::persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex)
+void UBSvgSubsetAdaptor::persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex, UBDocumentJournal* journal)
 {
-    UBSvgSubsetWriter writer(proxy, pScene, pageIndex);
+    UB_TRACE_SCOPE("UBSvgSubsetAdaptor::persistScene");
+
+    UBSvgSubsetWriter writer(proxy, pScene, pageIndex, journal);
     writer.persistScene(proxy, pageIndex);
 }
 
 
-UBSvgSubsetAdaptor::UBSvgSubsetWriter::UBSvgSubsetWriter(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex)
+/*
+ * Writes the page an imported pdf page would produce once placed on a new scene, without building
+ * the scene: a page of the pdf page size holding the page as its background object.
+ */
+bool UBSvgSubsetAdaptor::persistPdfPage(UBDocumentProxy* proxy, const int pageIndex, const QUuid& pdfFileUuid, int pdfPageNumber, const QSizeF& pdfPageSize)
+{
+    UB_TRACE_SCOPE("UBSvgSubsetAdaptor::persistPdfPage");
+
+    UBSvgSubsetWriter writer(proxy, pageIndex);
+    return writer.persistPdfPage(proxy, pdfFileUuid, pdfPageNumber, pdfPageSize);
+}
+
+
+UBSvgSubsetAdaptor::UBSvgSubsetWriter::UBSvgSubsetWriter(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex, UBDocumentJournal* journal)
     : mScene(pScene)
     , mDocumentPath(proxy->persistencePath())
     , mPageIndex(pageIndex)
+    , mJournal(journal)
+
+{
+    // NOOP
+}
 
+
+UBSvgSubsetAdaptor::UBSvgSubsetWriter::UBSvgSubsetWriter(UBDocumentProxy* proxy, const int pageIndex)
+    : mScene(0)
+    , mDocumentPath(proxy->persistencePath())
+    , mPageIndex(pageIndex)
+    , mJournal(0)
 {
     // NOOP
 }
 
 
+void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeStartDocument(QIODevice* device)
+{
+    mXmlWriter.setDevice(device);
+
+    mXmlWriter.setAutoFormatting(true);
+
+    mXmlWriter.writeStartDocument();
+    mXmlWriter.writeDefaultNamespace(nsSvg);
+    mXmlWriter.writeNamespace(nsXLink, "xlink");
+    mXmlWriter.writeNamespace(UBSettings::uniboardDocumentNamespaceUri, "ub");
+    mXmlWriter.writeNamespace(nsXHtml, "xhtml");
+}
+
+
 void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeSvgElement(UBDocumentProxy* proxy)
+{
+    writeSvgElement(proxy, mScene->uuid(), mScene->normalizedSceneRect(), mScene->nominalSize(), mScene->isDarkBackground()
+                    , mScene->pageBackground(), mScene->backgroundGridSize(), mScene->intermediateLines());
+}
+
+
+void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeSvgElement(UBDocumentProxy* proxy, const QUuid& sceneUuid, const QRectF& normalizedSceneRect
+                                                             , const QSize& pageNominalSize, bool darkBackground, UBPageBackground pageBackground
+                                                             , int gridSize, bool intermediateLines)
 {
     mXmlWriter.writeStartElement("svg");
 
     mXmlWriter.writeAttribute("version", "1.1");
     mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "version", UBSettings::currentFileVersion);
-    mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "uuid", UBStringUtils::toCanonicalUuid(mScene->uuid()));
+    mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "uuid", UBStringUtils::toCanonicalUuid(sceneUuid));
 
     int margin = UBSettings::settings()->svgViewBoxMargin->get().toInt();
-    QRect normalized = mScene->normalizedSceneRect().toRect();
+    QRect normalized = normalizedSceneRect.toRect();
     normalized.translate(margin * -1, margin * -1);
     normalized.setWidth(normalized.width() + (margin * 2));
     normalized.setHeight(normalized.height() + (margin * 2));
     mXmlWriter.writeAttribute("viewBox", QString("%1 %2 %3 %4").arg(normalized.x()).arg(normalized.y()).arg(normalized.width()).arg(normalized.height()));
 
-    QSize pageNominalSize = mScene->nominalSize();
     if (pageNominalSize.isValid())
     {
         mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "nominal-size", QString("%1x%2").arg(pageNominalSize.width()).arg(pageNominalSize.height()));
     }
 
-    mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "dark-background", mScene->isDarkBackground() ? xmlTrue : xmlFalse);
+    mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "dark-background", darkBackground ? xmlTrue : xmlFalse);
 
-    bool crossedBackground = mScene->pageBackground() == UBPageBackground::crossed;
-    bool ruledBackground = mScene->pageBackground() == UBPageBackground::ruled;
+    bool crossedBackground = pageBackground == UBPageBackground::crossed;
+    bool ruledBackground = pageBackground == UBPageBackground::ruled;
 
     mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "crossed-background", crossedBackground ? xmlTrue : xmlFalse);
     mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "ruled-background", ruledBackground ? xmlTrue : xmlFalse);
 
     if (crossedBackground || ruledBackground) {
-        int gridSize = mScene->backgroundGridSize();
-        bool intermediateLines = mScene->intermediateLines();
-
         mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "grid-size", QString::number(gridSize));
         mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "intermediate-lines", QString::number(intermediateLines));
     }
@@ -1171,7 +1276,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeSvgElement(UBDocumentProxy* pro
 
 
     mXmlWriter.writeStartElement("rect");
-    mXmlWriter.writeAttribute("fill", mScene->isDarkBackground() ? "black" : "white");
+    mXmlWriter.writeAttribute("fill", darkBackground ? "black" : "white");
     mXmlWriter.writeAttribute("x", QString::number(normalized.x()));
     mXmlWriter.writeAttribute("y", QString::number(normalized.y()));
     mXmlWriter.writeAttribute("width", QString::number(normalized.width()));
@@ -1180,6 +1285,49 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeSvgElement(UBDocumentProxy* pro
     mXmlWriter.writeEndElement();
 }
 
+
+bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::writePage(const QByteArray& data)
+{
+    if (!UBDocumentJournal::writeFile(UBPageManifest::svgFilePath(mDocumentPath, mPageIndex), data, mJournal))
+        return false;
+
+    UBPageManifest* pages = UBPageManifest::manifest(mDocumentPath);
+    UBAssetManifest::manifest(mDocumentPath)->setPageAssets(pages->pageFileName(mPageIndex), mAssetReferences, mJournal);
+
+    return true;
+}
+
+
+bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistPdfPage(UBDocumentProxy* proxy, const QUuid& pdfFileUuid, int pdfPageNumber, const QSizeF& pdfPageSize)
+{
+    QSize nominalSize(pdfPageSize.width(), pdfPageSize.height());
+    QRectF pageRect(-pdfPageSize.width() / 2, -pdfPageSize.height() / 2, pdfPageSize.width(), pdfPageSize.height());
+    QRectF normalizedRect(nominalSize.width() / -2, nominalSize.height() / -2, nominalSize.width(), nominalSize.height());
+
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+
+    writeStartDocument(&buffer);
+
+    writeSvgElement(proxy, QUuid::createUuid(), normalizedRect.united(pageRect), nominalSize, UBSettings::settings()->isDarkBackground()
+                    , UBSettings::settings()->pageBackground(), UBSettings::crossSize, UBSettings::intermediateLines);
+
+    writeLinkedPDFStart(UBPersistenceManager::objectDirectory + "/" + pdfFileUuid.toString() + ".pdf", pdfPageNumber);
+
+    writeItemGeometry(pdfPageSize, QMatrix(1, 0, 0, 1, pageRect.x(), pageRect.y())
+                      , UBZLayerController(0).generateZLevel(itemLayerType::BackgroundItem), true);
+    mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "uuid", UBStringUtils::toCanonicalUuid(QUuid::createUuid()));
+    mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "layer", QString("%1").arg(UBItemLayerType::FixedBackground));
+
+    mXmlWriter.writeEndElement(); // foreignObject
+
+    mXmlWriter.writeEndElement(); // svg
+    mXmlWriter.writeEndDocument();
+
+    return writePage(buffer.data());
+}
+
+
 bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(UBDocumentProxy* proxy, int pageIndex)
 {
     Q_UNUSED(pageIndex);
@@ -1191,15 +1339,8 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(UBDocumentProxy* proxy,
 
     QBuffer buffer;
     buffer.open(QBuffer::WriteOnly);
-    mXmlWriter.setDevice(&buffer);
 
-    mXmlWriter.setAutoFormatting(true);
-
-    mXmlWriter.writeStartDocument();
-    mXmlWriter.writeDefaultNamespace(nsSvg);
-    mXmlWriter.writeNamespace(nsXLink, "xlink");
-    mXmlWriter.writeNamespace(UBSettings::uniboardDocumentNamespaceUri, "ub");
-    mXmlWriter.writeNamespace(nsXHtml, "xhtml");
+    writeStartDocument(&buffer);
 
     writeSvgElement(proxy);
 
@@ -1471,19 +1612,8 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(UBDocumentProxy* proxy,
     }
 
     mXmlWriter.writeEndDocument();
-    QString fileName = mDocumentPath + UBFileSystemUtils::digitFileFormat("/page%1.svg", mPageIndex);
-    QFile file(fileName);
 
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
-    {
-        qCritical() << "cannot open " << fileName << " for writing ...";
-        return false;
-    }
-    file.write(buffer.data());
-    file.flush();
-    file.close();
-
-    return true;
+    return writePage(buffer.data());
 }
 
 void UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistGroupToDom(QGraphicsItem *groupItem, QDomElement *curParent, QDomDocument *groupDomDocument)
@@ -1576,11 +1706,16 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::strokeToSvgPolyline(UBGraphicsStroke
             points[1] = QPointF(points[1].x() + 0.01, points[1].y());
         }
 
-        QString svgPoints = pointsToSvgPointsAttribute(points);
-        mXmlWriter.writeAttribute("points", svgPoints);
-
         UBGraphicsPolygonItem* firstPolygonItem = pols.at(0);
 
+        QString svgPoints = firstPolygonItem->serializedPoints(points);
+        if (svgPoints.isNull())
+        {
+            svgPoints = pointsToSvgPointsAttribute(points);
+            firstPolygonItem->setSerializedPoints(points, svgPoints);
+        }
+        mXmlWriter.writeAttribute("points", svgPoints);
+
         mXmlWriter.writeAttribute("fill", "none");
         mXmlWriter.writeAttribute("stroke-width", QString::number(firstPolygonItem->originalWidth(), 'f', 2));
         mXmlWriter.writeAttribute("stroke", firstPolygonItem->brush().color().name());
@@ -1639,7 +1774,13 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::polygonItemToSvgPolygon(UBGraphicsPo
     {
         mXmlWriter.writeStartElement("polygon");
 
-        QString points = pointsToSvgPointsAttribute(polygon);
+        // unchanged polygons reuse the text of the previous save
+        QString points = polygonItem->serializedPoints(polygon);
+        if (points.isNull())
+        {
+            points = pointsToSvgPointsAttribute(polygon);
+            polygonItem->setSerializedPoints(polygon, points);
+        }
         mXmlWriter.writeAttribute("points", points);
         mXmlWriter.writeAttribute("transform",toSvgTransform(polygonItem->matrix()));
         mXmlWriter.writeAttribute("fill", polygonItem->brush().color().name());
@@ -2030,6 +2171,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::pixmapItemToLinkedImage(UBGraphicsPi
     QString path = mDocumentPath + "/" + fileName;
 
     mXmlWriter.writeAttribute(nsXLink, "href", fileName);
+    mAssetReferences.insert(fileName);
 
     graphicsItemToSvg(pixmapItem);
 
@@ -2072,6 +2214,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::svgItemToLinkedSvg(UBGraphicsSvgItem
 
 
     mXmlWriter.writeAttribute(nsXLink, "href", fileName);
+    mAssetReferences.insert(fileName);
 
     graphicsItemToSvg(svgItem);
 
@@ -2106,9 +2249,6 @@ UBGraphicsSvgItem* UBSvgSubsetAdaptor::UBSvgSubsetReader::svgItemFromSvg()
 
 void UBSvgSubsetAdaptor::UBSvgSubsetWriter::pdfItemToLinkedPDF(UBGraphicsPDFItem* pdfItem)
 {
-    mXmlWriter.writeStartElement("foreignObject");
-    mXmlWriter.writeAttribute("requiredExtensions", "http://ns.adobe.com/pdf/1.3/");
-
     QString fileName = UBPersistenceManager::objectDirectory + "/" + pdfItem->fileUuid().toString() + ".pdf";
 
     QString path = mDocumentPath + "/" + fileName;
@@ -2129,7 +2269,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::pdfItemToLinkedPDF(UBGraphicsPDFItem
         file.close();
     }
 
-    mXmlWriter.writeAttribute(nsXLink, "href", fileName + "#page=" + QString::number(pdfItem->pageNumber()));
+    writeLinkedPDFStart(fileName, pdfItem->pageNumber());
 
     graphicsItemToSvg(pdfItem);
 
@@ -2137,6 +2277,16 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::pdfItemToLinkedPDF(UBGraphicsPDFItem
 }
 
 
+void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeLinkedPDFStart(const QString& fileName, int pageNumber)
+{
+    mXmlWriter.writeStartElement("foreignObject");
+    mXmlWriter.writeAttribute("requiredExtensions", "http://ns.adobe.com/pdf/1.3/");
+
+    mXmlWriter.writeAttribute(nsXLink, "href", fileName + "#page=" + QString::number(pageNumber));
+    mAssetReferences.insert(fileName);
+}
+
+
 UBGraphicsPDFItem* UBSvgSubsetAdaptor::UBSvgSubsetReader::pdfItemFromPDF()
 {
     UBGraphicsPDFItem* pdfItem = 0;
@@ -2176,6 +2326,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::audioItemToLinkedAudio(UBGraphicsAud
     QString audioFileHref = "audios/" + audioItem->mediaFileUrl().fileName();
 
     mXmlWriter.writeAttribute(nsXLink, "href", audioFileHref);
+    mAssetReferences.insert(audioFileHref);
     mXmlWriter.writeEndElement();
 }
 
@@ -2203,6 +2354,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::videoItemToLinkedVideo(UBGraphicsVid
     QString videoFileHref = "videos/" + videoItem->mediaFileUrl().fileName();
 
     mXmlWriter.writeAttribute(nsXLink, "href", videoFileHref);
+    mAssetReferences.insert(videoFileHref);
     mXmlWriter.writeEndElement();
 }
 
@@ -2385,23 +2537,27 @@ void UBSvgSubsetAdaptor::UBSvgSubsetReader::graphicsItemFromSvg(QGraphicsItem* g
     }
 }
 
-void UBSvgSubsetAdaptor::UBSvgSubsetWriter::graphicsItemToSvg(QGraphicsItem* item)
+void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeItemGeometry(const QSizeF& size, const QMatrix& sceneMatrix, qreal zValue, bool isBackground)
 {
     mXmlWriter.writeAttribute("x", "0");
     mXmlWriter.writeAttribute("y", "0");
 
-    mXmlWriter.writeAttribute("width", QString("%1").arg(item->boundingRect().width()));
-    mXmlWriter.writeAttribute("height", QString("%1").arg(item->boundingRect().height()));
+    mXmlWriter.writeAttribute("width", QString("%1").arg(size.width()));
+    mXmlWriter.writeAttribute("height", QString("%1").arg(size.height()));
 
-    mXmlWriter.writeAttribute("transform", toSvgTransform(item->sceneMatrix()));
+    mXmlWriter.writeAttribute("transform", toSvgTransform(sceneMatrix));
 
     QString zs;
-    zs.setNum(item->zValue(), 'f'); // 'f' keeps precision
+    zs.setNum(zValue, 'f'); // 'f' keeps precision
     mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "z-value", zs);
 
-    bool isBackground = mScene->isBackgroundObject(item);
-
     mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "background", isBackground ? xmlTrue : xmlFalse);
+}
+
+
+void UBSvgSubsetAdaptor::UBSvgSubsetWriter::graphicsItemToSvg(QGraphicsItem* item)
+{
+    writeItemGeometry(item->boundingRect().size(), item->sceneMatrix(), item->zValue(), mScene->isBackgroundObject(item));
 
     UBItem* ubItem = dynamic_cast<UBItem*>(item);
 
@@ -2476,6 +2632,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::graphicsWidgetToSvg(UBGraphicsWidget
 
     mXmlWriter.writeStartElement("foreignObject");
     mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "src", widgetPath);
+    mAssetReferences.insert(widgetPath);
 
     graphicsItemToSvg(item);
 
@@ -2513,6 +2670,9 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::graphicsWidgetToSvg(UBGraphicsWidget
         mXmlWriter.writeAttribute("key", key);
         mXmlWriter.writeAttribute("value", value);
 
+        foreach(QString objectReference, UBAssetManifest::referencesInText(value, UBPersistenceManager::objectDirectory))
+            mAssetReferences.insert(widgetPath + "/" + objectReference);
+
         mXmlWriter.writeEndElement(); //ub::preference
     }
 
@@ -2638,9 +2798,13 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::textItemToSvg(UBGraphicsTextItem* it
     // Note: don't use mXmlWriter.writeCDATA(htmlString); because it doesn't escape characters sequences correctly.
     // Texts copied from other programs like Open-Office can truncate the svg file.
     //mXmlWriter.writeCharacters(item->toHtml());
-    mXmlWriter.writeCharacters(UBTextTools::cleanHtmlCData(item->toHtml()));
+    QString html = UBTextTools::cleanHtmlCData(item->toHtml());
+    mXmlWriter.writeCharacters(html);
     mXmlWriter.writeEndElement(); //itemTextContent
 
+    foreach(QString imageReference, UBAssetManifest::referencesInText(html, UBPersistenceManager::imageDirectory))
+        mAssetReferences.insert(imageReference);
+
     mXmlWriter.writeEndElement(); //foreignObject
 }
 
@@ -34,6 +34,7 @@
 #include <QtXml>
 #include <QGraphicsItem>
 
+#include "core/UB.h"
 #include "frameworks/UBGeometryUtils.h"
 
 class UBGraphicsSvgItem;
@@ -58,6 +59,7 @@ class UBGraphicsStroke;
 class UBPersistenceManager;
 class UBGraphicsTriangle;
 class UBGraphicsCache;
+class UBDocumentJournal;
 class UBGraphicsGroupContainerItem;
 class UBGraphicsStrokesGroup;
 
@@ -74,10 +76,12 @@ class UBSvgSubsetAdaptor
         static QByteArray loadSceneAsText(UBDocumentProxy* proxy, const int pageIndex);
         static UBGraphicsScene* loadScene(UBDocumentProxy* proxy, const QByteArray& pArray);
 
-        static void persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex);
+        static void persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex, UBDocumentJournal* journal = 0);
+        static bool persistPdfPage(UBDocumentProxy* proxy, const int pageIndex, const QUuid& pdfFileUuid, int pdfPageNumber, const QSizeF& pdfPageSize);
         static void upgradeScene(UBDocumentProxy* proxy, const int pageIndex);
 
         static QUuid sceneUuid(UBDocumentProxy* proxy, const int pageIndex);
+        static bool hasContent(UBDocumentProxy* proxy, const int pageIndex);
         static void setSceneUuid(UBDocumentProxy* proxy, const int pageIndex, QUuid pUuid);
 
         static void convertPDFObjectsToImages(UBDocumentProxy* proxy);
@@ -183,9 +187,11 @@ class UBSvgSubsetAdaptor
         {
             public:
 
-                UBSvgSubsetWriter(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex);
+                UBSvgSubsetWriter(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex, UBDocumentJournal* journal = 0);
+                UBSvgSubsetWriter(UBDocumentProxy* proxy, const int pageIndex);
 
                 bool persistScene(UBDocumentProxy *proxy, int pageIndex);
+                bool persistPdfPage(UBDocumentProxy *proxy, const QUuid& pdfFileUuid, int pdfPageNumber, const QSizeF& pdfPageSize);
 
                 virtual ~UBSvgSubsetWriter(){}
 
@@ -241,8 +247,10 @@ class UBSvgSubsetAdaptor
                 void pixmapItemToLinkedImage(UBGraphicsPixmapItem *pixmapItem);
                 void svgItemToLinkedSvg(UBGraphicsSvgItem *svgItem);
                 void pdfItemToLinkedPDF(UBGraphicsPDFItem *pdfItem);
+                void writeLinkedPDFStart(const QString& fileName, int pageNumber);
                 void videoItemToLinkedVideo(UBGraphicsVideoItem *videoItem);
                 void audioItemToLinkedAudio(UBGraphicsAudioItem *audioItem);
+                void writeItemGeometry(const QSizeF& size, const QMatrix& sceneMatrix, qreal zValue, bool isBackground);
                 void graphicsItemToSvg(QGraphicsItem *item);
                 void graphicsAppleWidgetToSvg(UBGraphicsAppleWidgetItem *item);
                 void graphicsW3CWidgetToSvg(UBGraphicsW3CWidgetItem *item);
@@ -255,7 +263,12 @@ class UBSvgSubsetAdaptor
                 void protractorToSvg(UBGraphicsProtractor *item);
                 void cacheToSvg(UBGraphicsCache* item);
                 void triangleToSvg(UBGraphicsTriangle *item);
+                void writeStartDocument(QIODevice *device);
                 void writeSvgElement(UBDocumentProxy *proxy);
+                void writeSvgElement(UBDocumentProxy *proxy, const QUuid& sceneUuid, const QRectF& normalizedSceneRect
+                                     , const QSize& pageNominalSize, bool darkBackground, UBPageBackground pageBackground
+                                     , int gridSize, bool intermediateLines);
+                bool writePage(const QByteArray& data);
 
         private:
 
@@ -263,6 +276,8 @@ class UBSvgSubsetAdaptor
                 QXmlStreamWriter mXmlWriter;
                 QString mDocumentPath;
                 int mPageIndex;
+                QSet<QString> mAssetReferences;
+                UBDocumentJournal* mJournal;
 
         };
 };
@@ -34,8 +34,11 @@
 #include "frameworks/UBFileSystemUtils.h"
 
 #include "core/UBPersistenceManager.h"
+#include "core/UBPageManifest.h"
+#include "core/UBDocumentJournal.h"
 #include "core/UBApplication.h"
 #include "core/UBSettings.h"
+#include "core/UBTrace.h"
 
 #include "board/UBBoardController.h"
 #include "board/UBBoardPaletteManager.h"
@@ -48,17 +51,21 @@
 
 #include "core/memcheck.h"
 
+QHash<QString, QSize> UBThumbnailAdaptor::sPendingThumbnails;
+
 void UBThumbnailAdaptor::generateMissingThumbnails(UBDocumentProxy* proxy)
 {
+    UB_TRACE_SCOPE("UBThumbnailAdaptor::generateMissingThumbnails");
+
     int existingPageCount = proxy->pageCount();
 
     for (int iPageNo = 0; iPageNo < existingPageCount; ++iPageNo)
     {
-        QString thumbFileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", iPageNo);
+        QString thumbFileName = UBPageManifest::thumbnailFilePath(proxy->persistencePath(), iPageNo);
 
         QFile thumbFile(thumbFileName);
 
-        if (!thumbFile.exists())
+        if (!thumbFile.exists() && !sPendingThumbnails.contains(thumbFileName))
         {
             bool displayMessage = (existingPageCount > 5);
 
@@ -85,7 +92,14 @@ void UBThumbnailAdaptor::generateMissingThumbnails(UBDocumentProxy* proxy)
 
 const QPixmap* UBThumbnailAdaptor::get(UBDocumentProxy* proxy, int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", pageIndex);
+    QString fileName = UBPageManifest::thumbnailFilePath(proxy->persistencePath(), pageIndex);
+
+    if (sPendingThumbnails.contains(fileName))
+    {
+        QPixmap* placeholder = new QPixmap(sPendingThumbnails.value(fileName));
+        placeholder->fill(Qt::white);
+        return placeholder;
+    }
 
     QFile file(fileName);
     if (!file.exists())
@@ -119,9 +133,21 @@ void UBThumbnailAdaptor::load(UBDocumentProxy* proxy, QList<const QPixmap*>& lis
         list.append(get(proxy, i));
 }
 
-void UBThumbnailAdaptor::persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, int pageIndex, bool overrideModified)
+void UBThumbnailAdaptor::setPending(const QString& thumbnailPath, const QSize& size)
+{
+    sPendingThumbnails.insert(thumbnailPath, size);
+}
+
+void UBThumbnailAdaptor::clearPending(const QString& thumbnailPath)
+{
+    sPendingThumbnails.remove(thumbnailPath);
+}
+
+void UBThumbnailAdaptor::persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, int pageIndex, bool overrideModified, UBDocumentJournal* journal)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", pageIndex);
+    UB_TRACE_SCOPE("UBThumbnailAdaptor::persistScene");
+
+    QString fileName = UBPageManifest::thumbnailFilePath(proxy->persistencePath(), pageIndex);
 
     QFile thumbFile(fileName);
 
@@ -160,14 +186,44 @@ void UBThumbnailAdaptor::persistScene(UBDocumentProxy* proxy, UBGraphicsScene* p
         pScene->setRenderingContext(UBGraphicsScene::Screen);
         pScene->setRenderingQuality(UBItem::RenderingQualityNormal, UBItem::CacheAllowed);
 
-        thumb.scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation).save(fileName, "JPG");
+        QByteArray thumbData;
+        QBuffer thumbBuffer(&thumbData);
+        thumbBuffer.open(QIODevice::WriteOnly);
+        thumb.scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation).save(&thumbBuffer, "JPG");
+
+        UBDocumentJournal::writeFile(fileName, thumbData, journal);
+        clearPending(fileName);
+
+        pScene->clearThumbnailDamage();
     }
 }
 
 
+bool UBThumbnailAdaptor::hasVisibleChanges(UBGraphicsScene* pScene)
+{
+    if (!pScene->hasThumbnailDamage())
+        return false;
+
+    QRectF damage = pScene->thumbnailDamage();
+    if (damage.isNull())
+        return true;
+
+    qreal nominalWidth = pScene->nominalSize().width();
+    qreal nominalHeight = pScene->nominalSize().height();
+    QRectF sceneRect = pScene->normalizedSceneRect(nominalWidth / nominalHeight);
+
+    if (sceneRect.isEmpty())
+        return true;
+
+    qreal scale = UBSettings::maxThumbnailWidth / sceneRect.width();
+
+    return damage.width() * scale * damage.height() * scale >= 4;
+}
+
+
 QUrl UBThumbnailAdaptor::thumbnailUrl(UBDocumentProxy* proxy, int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", pageIndex);
+    QString fileName = UBPageManifest::thumbnailFilePath(proxy->persistencePath(), pageIndex);
 
     return QUrl::fromLocalFile(fileName);
 }
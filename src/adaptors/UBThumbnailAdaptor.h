@@ -35,6 +35,7 @@
 class UBDocument;
 class UBDocumentProxy;
 class UBGraphicsScene;
+class UBDocumentJournal;
 
 class UBThumbnailAdaptor //static class
 {
@@ -43,14 +44,23 @@ class UBThumbnailAdaptor //static class
 public:
     static QUrl thumbnailUrl(UBDocumentProxy* proxy, int pageIndex);
 
-    static void persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, int pageIndex, bool overrideModified = false);
+    static void persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, int pageIndex, bool overrideModified = false, UBDocumentJournal* journal = 0);
+
+    // false when the changes since the last thumbnail would cover less than a few of its pixels
+    static bool hasVisibleChanges(UBGraphicsScene* pScene);
 
     static const QPixmap* get(UBDocumentProxy* proxy, int index);
     static void load(UBDocumentProxy* proxy, QList<const QPixmap*>& list);
 
+    // thumbnails being rendered in the background; get() hands out a blank placeholder of the given size meanwhile
+    static void setPending(const QString& thumbnailPath, const QSize& size);
+    static void clearPending(const QString& thumbnailPath);
+
 private:
     static void generateMissingThumbnails(UBDocumentProxy* proxy);
 
+    static QHash<QString, QSize> sPendingThumbnails;
+
     UBThumbnailAdaptor() {}
 };
 
@@ -30,6 +30,7 @@
 #include "UBBoardController.h"
 
 #include <QtWidgets>
+#include <QtConcurrent>
 
 #include "frameworks/UBFileSystemUtils.h"
 #include "frameworks/UBPlatformUtils.h"
@@ -42,6 +43,7 @@
 #include "core/UBDocumentManager.h"
 #include "core/UBMimeData.h"
 #include "core/UBDownloadManager.h"
+#include "core/UBTrace.h"
 
 #include "network/UBHttpGet.h"
 
@@ -1547,6 +1549,8 @@ void UBBoardController::setActiveDocumentScene(int pSceneIndex)
 
 void UBBoardController::setActiveDocumentScene(UBDocumentProxy* pDocumentProxy, const int pSceneIndex, bool forceReload, bool onImport)
 {
+    UB_TRACE_SCOPE("UBBoardController::setActiveDocumentScene");
+
     saveViewState();
 
     bool documentChange = selectedDocument() != pDocumentProxy;
@@ -1632,50 +1636,15 @@ void UBBoardController::moveSceneToIndex(int source, int target)
     }
 }
 
-void UBBoardController::findUniquesItems(const QUndoCommand *parent, QSet<QGraphicsItem*> &itms)
+void UBBoardController::ClearUndoStack()
 {
-    if (parent->childCount()) {
-        for (int i = 0; i < parent->childCount(); i++) {
-            findUniquesItems(parent->child(i), itms);
-        }
-    }
-
-    // Undo command transaction macros. Process separatedly
-    if (parent->text() == UBSettings::undoCommandTransactionName) {
-        return;
-    }
-
-    const UBUndoCommand *undoCmd = static_cast<const UBUndoCommand*>(parent);
-    if(undoCmd->getType() != UBUndoType::undotype_GRAPHICITEM)
-        return;
-
-    const UBGraphicsItemUndoCommand *cmd = dynamic_cast<const UBGraphicsItemUndoCommand*>(parent);
-
-    // go through all added and removed objects, for create list of unique objects
+    // the items added or removed by the commands in the stack, tracked as the commands come and go.
     // grouped items will be deleted by groups, so we don't need do delete that items.
-    QSetIterator<QGraphicsItem*> itAdded(cmd->GetAddedList());
-    while (itAdded.hasNext())
-    {
-        QGraphicsItem* item = itAdded.next();
-        if( !itms.contains(item) && !(item->parentItem() && UBGraphicsGroupContainerItem::Type == item->parentItem()->type()))
-            itms.insert(item);
-    }
-
-    QSetIterator<QGraphicsItem*> itRemoved(cmd->GetRemovedList());
-    while (itRemoved.hasNext())
+    QList<QGraphicsItem*> uniqueItems;
+    foreach (QGraphicsItem* item, UBGraphicsItemUndoCommand::referencedItems())
     {
-        QGraphicsItem* item = itRemoved.next();
-        if( !itms.contains(item) && !(item->parentItem() && UBGraphicsGroupContainerItem::Type == item->parentItem()->type()))
-            itms.insert(item);
-    }
-}
-
-void UBBoardController::ClearUndoStack()
-{
-    QSet<QGraphicsItem*> uniqueItems;
-    // go through all stack command
-    for (int i = 0; i < UBApplication::undoStack->count(); i++) {
-        findUniquesItems(UBApplication::undoStack->command(i), uniqueItems);
+        if (!(item->parentItem() && UBGraphicsGroupContainerItem::Type == item->parentItem()->type()))
+            uniqueItems << item;
     }
 
     // Get items from clipboard in order not to delete an item that was cut
@@ -1683,7 +1652,7 @@ void UBBoardController::ClearUndoStack()
     // This ensures that we can cut and paste a media item, widget, etc. from one page to the next.
     QClipboard *clipboard = QApplication::clipboard();
     const QMimeData* data = clipboard->mimeData();
-    QList<QUrl> sourceURLs;
+    QSet<QUrl> sourceURLs;
 
     if (data && data->hasFormat(UBApplication::mimeTypeUniboardPageItem)) {
         const UBMimeDataGraphicsItem* mimeDataGI = qobject_cast <const UBMimeDataGraphicsItem*>(data);
@@ -1697,10 +1666,8 @@ void UBBoardController::ClearUndoStack()
 
     // go through all unique items, and check, if they are on scene, or not.
     // if not on scene, than item can be deleted
-    QSetIterator<QGraphicsItem*> itUniq(uniqueItems);
-    while (itUniq.hasNext())
+    foreach (QGraphicsItem* item, uniqueItems)
     {
-        QGraphicsItem* item = itUniq.next();
         UBGraphicsScene *scene = NULL;
         if (item->scene()) {
             scene = dynamic_cast<UBGraphicsScene*>(item->scene());
@@ -1878,6 +1845,12 @@ void UBBoardController::autosaveTimeout()
         return;
     }
 
+    if (mActiveScene && mActiveScene->isInputDevicePressed()) {
+        // saving now would stall the stroke being drawn, retry once the pen is lifted
+        QTimer::singleShot(500, this, SLOT(autosaveTimeout()));
+        return;
+    }
+
     saveData(sf_showProgress);
     UBSettings::settings()->save();
 }
@@ -1920,6 +1893,7 @@ void UBBoardController::lastWindowClosed()
         else
         {
             persistCurrentScene();
+            UBPersistenceManager::persistenceManager()->cleanDocumentAssets(selectedDocument());
         }
 
         UBPersistenceManager::persistenceManager()->purgeEmptyDocuments();
@@ -2008,10 +1982,13 @@ void UBBoardController::persistCurrentScene(bool isAnAutomaticBackup, bool force
     if(UBPersistenceManager::persistenceManager()
             && selectedDocument() && mActiveScene && mActiveSceneIndex != mDeletingSceneIndex
             && (mActiveSceneIndex >= 0) && mActiveSceneIndex != mMovingSceneIndex
-            && (mActiveScene->isModified()))
+            && (mActiveScene->isModified() || mActiveScene->hasThumbnailDamage()))
     {
-        UBPersistenceManager::persistenceManager()->persistDocumentScene(selectedDocument(), mActiveScene, mActiveSceneIndex);
-        updatePage(mActiveSceneIndex);
+        UBPersistenceManager::persistenceManager()->persistDocumentScene(selectedDocument(), mActiveScene, mActiveSceneIndex, isAnAutomaticBackup);
+
+        // the thumbnail is still pending when the autosave found the change too small for it
+        if (!mActiveScene->hasThumbnailDamage())
+            updatePage(mActiveSceneIndex);
     }
 }
 
@@ -2176,7 +2153,17 @@ void UBBoardController::grabScene(const QRectF& pSceneRect)
 {
     if (mActiveScene)
     {
-        QImage image(pSceneRect.width(), pSceneRect.height(), QImage::Format_ARGB32);
+        UB_TRACE_SCOPE("UBBoardController::grabScene");
+
+        int width = pSceneRect.width();
+        int height = pSceneRect.height();
+
+        if (width <= 0 || height <= 0)
+            return;
+
+        // Scene items can only be painted on the GUI thread, so the grab is rasterized here and
+        // only its PNG encoding, which dominates on large grabs, runs on a worker.
+        QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
         image.fill(Qt::transparent);
 
         QRectF targetRect(0, 0, pSceneRect.width(), pSceneRect.height());
@@ -2184,21 +2171,69 @@ void UBBoardController::grabScene(const QRectF& pSceneRect)
         painter.setRenderHint(QPainter::SmoothPixmapTransform);
         painter.setRenderHint(QPainter::Antialiasing);
 
+        // Only the items in the grabbed area are rendered uncached at high quality, the others keep
+        // their device caches. Each item gets its own rendering settings back afterwards.
+        QList<UBItem*> grabbedItems;
+        QList<QPair<UBItem::RenderingQuality, UBItem::CacheBehavior> > grabbedItemsRendering;
+
+        foreach (QGraphicsItem* item, mActiveScene->items(pSceneRect))
+        {
+            UBItem* ubItem = dynamic_cast<UBItem*>(item);
+            if (!ubItem)
+                continue;
+
+            grabbedItems << ubItem;
+            grabbedItemsRendering << qMakePair(ubItem->renderingQuality(), ubItem->cacheBehavior());
+
+            ubItem->setRenderingQuality(UBItem::RenderingQualityHigh);
+            ubItem->setCacheBehavior(UBItem::CacheNotAllowed);
+        }
+
         mActiveScene->setRenderingContext(UBGraphicsScene::NonScreen);
-        mActiveScene->setRenderingQuality(UBItem::RenderingQualityHigh, UBItem::CacheNotAllowed);
 
         mActiveScene->render(&painter, targetRect, pSceneRect);
+        painter.end();
 
         mActiveScene->setRenderingContext(UBGraphicsScene::Screen);
-//        mActiveScene->setRenderingQuality(UBItem::RenderingQualityNormal);
-        mActiveScene->setRenderingQuality(UBItem::RenderingQualityHigh, UBItem::CacheAllowed);
 
+        for (int i = 0; i < grabbedItems.size(); i++)
+        {
+            grabbedItems.at(i)->setRenderingQuality(grabbedItemsRendering.at(i).first);
+            grabbedItems.at(i)->setCacheBehavior(grabbedItemsRendering.at(i).second);
+        }
+
+        QFutureWatcher<SceneGrab>* watcher = new QFutureWatcher<SceneGrab>(this);
+        connect(watcher, SIGNAL(finished()), this, SLOT(sceneGrabbed()));
+        watcher->setFuture(QtConcurrent::run(&UBBoardController::encodeSceneGrab, image));
 
-        mPaletteManager->addItem(QPixmap::fromImage(image));
         selectedDocument()->setMetaData(UBSettings::documentUpdatedAt, UBStringUtils::toUtcIsoDateTime(QDateTime::currentDateTime()));
     }
 }
 
+
+UBBoardController::SceneGrab UBBoardController::encodeSceneGrab(const QImage& image)
+{
+    SceneGrab grab;
+    grab.image = image;
+
+    QBuffer buffer(&grab.encodedImage);
+    buffer.open(QIODevice::WriteOnly);
+    grab.image.save(&buffer, "PNG");
+
+    return grab;
+}
+
+
+void UBBoardController::sceneGrabbed()
+{
+    QFutureWatcher<SceneGrab>* watcher = static_cast<QFutureWatcher<SceneGrab>*>(sender());
+    SceneGrab grab = watcher->result();
+    watcher->deleteLater();
+
+    if (!grab.image.isNull())
+        mPaletteManager->addItem(QPixmap::fromImage(grab.image), QPointF(0.0, 0.0), 1.0, QUrl(), grab.encodedImage);
+}
+
 UBGraphicsMediaItem* UBBoardController::addVideo(const QUrl& pSourceUrl, bool startPlay, const QPointF& pos, bool bUseSource)
 {
     QUuid uuid = QUuid::createUuid();
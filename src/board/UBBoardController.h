@@ -177,7 +177,6 @@ class UBBoardController : public UBDocumentContainer
         void notifyPageChanged();
         void displayMetaData(QMap<QString, QString> metadatas);
 
-        void findUniquesItems(const QUndoCommand *parent, QSet<QGraphicsItem *> &itms);
         void ClearUndoStack();
 
         void setActiveDocumentScene(UBDocumentProxy* pDocumentProxy, int pSceneIndex = 0, bool forceReload = false, bool onImport = false);
@@ -287,8 +286,17 @@ class UBBoardController : public UBDocumentContainer
     private slots:
         void autosaveTimeout();
         void appMainModeChanged(UBApplicationController::MainMode);
+        void sceneGrabbed();
 
     private:
+        struct SceneGrab
+        {
+            QImage image;
+            QByteArray encodedImage;
+        };
+
+        static SceneGrab encodeSceneGrab(const QImage& image);
+
         void initBackgroundGridSize();
         void updatePageSizeState();
         void saveViewState();
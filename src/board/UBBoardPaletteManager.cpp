@@ -653,6 +653,7 @@ void UBBoardPaletteManager::addItem(const QUrl& pUrl)
 {
     mItemUrl = pUrl;
     mPixmap = QPixmap();
+    mEncodedPixmap = QByteArray();
     mPos = QPointF(0, 0);
     mScaleFactor = 1.;
 
@@ -836,10 +837,11 @@ void UBBoardPaletteManager::changeMode(eUBDockPaletteWidgetMode newMode, bool is
         UBApplication::boardController->notifyPageChanged();
 }
 
-void UBBoardPaletteManager::addItem(const QPixmap& pPixmap, const QPointF& pos,  qreal scaleFactor, const QUrl& sourceUrl)
+void UBBoardPaletteManager::addItem(const QPixmap& pPixmap, const QPointF& pos,  qreal scaleFactor, const QUrl& sourceUrl, const QByteArray& encodedPixmap)
 {
     mItemUrl = sourceUrl;
     mPixmap = pPixmap;
+    mEncodedPixmap = encodedPixmap;
     mPos = pos;
     mScaleFactor = scaleFactor;
 
@@ -882,6 +884,17 @@ void UBBoardPaletteManager::addItemToNewPage()
 
 void UBBoardPaletteManager::addItemToLibrary()
 {
+    // a capture already encoded as PNG off the GUI thread is stored as is
+    if(!mEncodedPixmap.isEmpty() && mScaleFactor == 1.)
+    {
+        QDateTime now = QDateTime::currentDateTime();
+        QString capturedName  = tr("CapturedImage") + "-" + now.toString("dd-MM-yyyy hh-mm-ss") + ".png";
+        mpFeaturesWidget->importEncodedImage(mEncodedPixmap, capturedName);
+
+        mAddItemPalette->hide();
+        return;
+    }
+
     if(mPixmap.isNull())
     {
        mPixmap = QPixmap(mItemUrl.toLocalFile());
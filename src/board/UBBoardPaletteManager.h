@@ -87,7 +87,7 @@ class UBBoardPaletteManager : public QObject
         void activeSceneChanged();
         void containerResized();
         void addItem(const QUrl& pUrl);
-        void addItem(const QPixmap& pPixmap, const QPointF& p = QPointF(0.0, 0.0), qreal scale = 1.0, const QUrl& sourceUrl = QUrl());
+        void addItem(const QPixmap& pPixmap, const QPointF& p = QPointF(0.0, 0.0), qreal scale = 1.0, const QUrl& sourceUrl = QUrl(), const QByteArray& encodedPixmap = QByteArray());
 
         void slot_changeMainMode(UBApplicationController::MainMode);
         void slot_changeDesktopMode(bool);
@@ -121,6 +121,7 @@ class UBBoardPaletteManager : public QObject
 
         QUrl mItemUrl;
         QPixmap mPixmap;
+        QByteArray mEncodedPixmap;
         QPointF mPos;
         qreal mScaleFactor;
 
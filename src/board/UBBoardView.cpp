@@ -165,6 +165,7 @@ void UBBoardView::init ()
     setAcceptDrops (true);
 
     mTabletStylusIsPressed = false;
+    mTabletFlushPosted = false;
     mMouseButtonIsPressed = false;
     mPendingStylusReleaseEvent = false;
 
@@ -391,14 +392,30 @@ void UBBoardView::tabletEvent (QTabletEvent * event)
 
     switch (event->type ()) {
     case QEvent::TabletPress: {
+        flushTabletSamples();
+
         mTabletStylusIsPressed = true;
         scene()->inputDevicePress (scenePos, pressure);
 
         break;
     }
     case QEvent::TabletMove: {
-        if (mTabletStylusIsPressed)
-            scene ()->inputDeviceMove (scenePos, pressure);
+        if (mTabletStylusIsPressed) {
+            // tablets report several hundred moves per second: coalesce them so that the scene draws
+            // the stroke once per frame instead of once per event
+            // the samples are in the coordinates of the scene they were taken on
+            if (mPendingTabletScene != scene())
+                flushTabletSamples();
+
+            UBInputSample sample = {scenePos, pressure, event->timestamp()};
+            mPendingTabletSamples << sample;
+            mPendingTabletScene = scene();
+
+            if (!mTabletFlushPosted) {
+                mTabletFlushPosted = true;
+                QMetaObject::invokeMethod(this, "flushTabletSamples", Qt::QueuedConnection);
+            }
+        }
 
         acceptEvent = false; // rerouted to mouse move
 
@@ -410,6 +427,7 @@ void UBBoardView::tabletEvent (QTabletEvent * event)
         scene ()->setToolCursor (currentTool);
         setToolCursor (currentTool);
 
+        flushTabletSamples();
         scene ()->inputDeviceRelease ();
 
         mPendingStylusReleaseEvent = false;
@@ -436,6 +454,20 @@ void UBBoardView::tabletEvent (QTabletEvent * event)
 
 }
 
+void UBBoardView::flushTabletSamples()
+{
+    mTabletFlushPosted = false;
+
+    if (mPendingTabletSamples.isEmpty())
+        return;
+
+    QList<UBInputSample> samples = mPendingTabletSamples;
+    mPendingTabletSamples.clear();
+
+    if (mTabletStylusIsPressed && mPendingTabletScene)
+        mPendingTabletScene->inputDeviceMove(samples);
+}
+
 bool UBBoardView::itemIsLocked(QGraphicsItem *item)
 {
     if (!item)
@@ -1478,6 +1510,7 @@ void UBBoardView::forcedTabletRelease ()
         qWarning () << "mPendingStylusReleaseEvent" << mPendingStylusReleaseEvent;
         qWarning () << "forcing device release";
 
+        flushTabletSamples();
         scene ()->inputDeviceRelease ();
 
         mMouseButtonIsPressed = false;
@@ -1618,9 +1651,9 @@ void UBBoardView::drawBackground (QPainter *painter, const QRectF &rect)
         QColor bgCrossColor;
 
         if (darkBackground)
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorDarkBackground->get().toString());
+            bgCrossColor = UBSettings::settings()->boardCrossColorDarkBackground->toColor();
         else
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorLightBackground->get().toString());
+            bgCrossColor = UBSettings::settings()->boardCrossColorLightBackground->toColor();
 
         if (transform ().m11 () < 0.7)
         {
@@ -1628,63 +1661,10 @@ void UBBoardView::drawBackground (QPainter *painter, const QRectF &rect)
             bgCrossColor.setAlpha (alpha); // fade the crossing on small zooms
         }
 
-        qreal gridSize = scene()->backgroundGridSize();
-        bool intermediateLines = scene()->intermediateLines();
-
-        painter->setPen (bgCrossColor);
-
-        if (scene () && scene ()->pageBackground() == UBPageBackground::crossed)
-        {
-            qreal firstY = ((int) (rect.y () / gridSize)) * gridSize;
-
-            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSize)
-            {
-                painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-            }
-
-            qreal firstX = ((int) (rect.x () / gridSize)) * gridSize;
-
-            for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += gridSize)
-            {
-                painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-            }
-
-            if (intermediateLines) {
-                QColor intermediateColor = bgCrossColor;
-                intermediateColor.setAlphaF(0.5 * bgCrossColor.alphaF());
-                painter->setPen(intermediateColor);
-
-                for (qreal yPos = firstY - gridSize/2; yPos < rect.y () + rect.height (); yPos += gridSize)
-                {
-                    painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-                }
-
-                for (qreal xPos = firstX - gridSize/2; xPos < rect.x () + rect.width (); xPos += gridSize)
-                {
-                    painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-                }
-            }
-        }
-
-        if (scene() && scene()->pageBackground() == UBPageBackground::ruled)
+        if (scene ())
         {
-            qreal firstY = ((int) (rect.y () / gridSize)) * gridSize;
-
-            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSize)
-            {
-                painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-            }
-
-            if (intermediateLines) {
-                QColor intermediateColor = bgCrossColor;
-                intermediateColor.setAlphaF(0.5 * bgCrossColor.alphaF());
-                painter->setPen(intermediateColor);
-
-                for (qreal yPos = firstY - gridSize/2; yPos < rect.y () + rect.height (); yPos += gridSize)
-                {
-                    painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-                }
-            }
+            mBackgroundTile.paint(painter, rect, scene()->pageBackground(), scene()->backgroundGridSize(),
+                                  bgCrossColor, scene()->intermediateLines());
         }
     }
 
@@ -37,6 +37,7 @@
 
 #include "core/UB.h"
 #include "domain/UBGraphicsDelegateFrame.h"
+#include "domain/UBBackgroundTile.h"
 
 class UBBoardController;
 class UBGraphicsScene;
@@ -132,9 +133,16 @@ private:
     int mStartLayer, mEndLayer;
     bool mFilterZIndex;
 
+    UBBackgroundTile mBackgroundTile;
+
     bool mTabletStylusIsPressed;
     bool mUsingTabletEraser;
 
+    // tablet moves received since the last flush, handed to the scene once per event loop iteration
+    QList<UBInputSample> mPendingTabletSamples;
+    QPointer<UBGraphicsScene> mPendingTabletScene;
+    bool mTabletFlushPosted;
+
     bool mPendingStylusReleaseEvent;
 
     bool mMouseButtonIsPressed;
@@ -204,6 +212,7 @@ private:
 private slots:
     void settingChanged(QVariant newValue);
     void movingItemDestroyed(QObject* item = nullptr);
+    void flushTabletSamples();
 
 public slots:
     void virtualKeyboardActivated(bool b);
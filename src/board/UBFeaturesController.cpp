@@ -779,6 +779,32 @@ void UBFeaturesController::importImage( const QImage &image, const UBFeature &de
 
 }
 
+void UBFeaturesController::importEncodedImage(const QByteArray &imageData, const QString &fileName)
+{
+    UBFeature dest = currentElement;
+
+    if ( !dest.getFullVirtualPath().startsWith( picturesElement.getFullVirtualPath(), Qt::CaseInsensitive ) )
+    {
+        dest = picturesElement;
+    }
+
+    QString filePath = dest.getFullPath().toLocalFile() + "/" + fileName;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(imageData) != imageData.size())
+    {
+        qWarning() << "cannot write image to library" << filePath;
+        return;
+    }
+    file.close();
+
+    QImage thumb = createThumbnail( filePath );
+    UBFeature resultItem =  UBFeature( dest.getFullVirtualPath() + "/" + fileName, thumb, fileName,
+        QUrl::fromLocalFile( filePath ), FEATURE_ITEM );
+
+    featuresModel->addItem(resultItem);
+}
+
 QStringList UBFeaturesController::getFileNamesInFolders()
 {
     QStringList strList;
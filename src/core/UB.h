@@ -227,4 +227,12 @@ enum UBPageBackground
     ruled
 };
 
+// A pen position in scene coordinates with its full precision pressure and the time it was sampled at (ms)
+struct UBInputSample
+{
+    QPointF position;
+    qreal pressure;
+    ulong timestamp;
+};
+
 #endif /* UB_H_ */
@@ -33,6 +33,7 @@
 #include <QtXml>
 #include <QFontDatabase>
 #include <QStyleFactory>
+#include <QShortcut>
 
 #include "frameworks/UBPlatformUtils.h"
 #include "frameworks/UBFileSystemUtils.h"
@@ -65,6 +66,8 @@
 #include "tools/UBToolsManager.h"
 
 #include "UBDisplayManager.h"
+#include "UBBenchmark.h"
+#include "UBTrace.h"
 #include "core/memcheck.h"
 
 QPointer<QUndoStack> UBApplication::undoStack;
@@ -90,6 +93,7 @@ QObject* UBApplication::staticMemoryCleaner = 0;
 
 UBApplication::UBApplication(const QString &id, int &argc, char **argv) : QtSingleApplication(id, argc, argv)
   , mPreferencesController(NULL)
+  , mBenchmark(NULL)
   , mApplicationTranslator(NULL)
   , mQtGuiTranslator(NULL)
 {
@@ -107,6 +111,10 @@ UBApplication::UBApplication(const QString &id, int &argc, char **argv) : QtSing
 
     QStringList args = arguments();
 
+    // before anything reads the settings or the user directories
+    if (UBBenchmark::isRequested(args))
+        mBenchmark = new UBBenchmark(args);
+
     mIsVerbose = args.contains("-v")
         || args.contains("-verbose")
         || args.contains("verbose")
@@ -115,6 +123,7 @@ UBApplication::UBApplication(const QString &id, int &argc, char **argv) : QtSing
 
 
     setupTranslators(args);
+    setupTracing(args);
 
     UBResources::resources();
 
@@ -176,6 +185,10 @@ UBApplication::~UBApplication()
         mQtGuiTranslator = NULL;
     }
 
+    // removes the temporary data directory, once nothing writes to it anymore
+    delete mBenchmark;
+    mBenchmark = NULL;
+
     delete staticMemoryCleaner;
     staticMemoryCleaner = 0;
 }
@@ -329,6 +342,14 @@ int UBApplication::exec(const QString& pFileToImport)
     mPreferencesController = new UBPreferencesController(mainWindow);
 
     connect(mainWindow->actionPreferences, SIGNAL(triggered()), mPreferencesController, SLOT(show()));
+
+    if (UBTrace::isEnabled())
+    {
+        // dumps the recent history of a running session, e.g. right after it froze
+        QShortcut* dumpTraceShortcut = new QShortcut(QKeySequence("Ctrl+Alt+Shift+T"), mainWindow);
+        dumpTraceShortcut->setContext(Qt::ApplicationShortcut);
+        connect(dumpTraceShortcut, SIGNAL(activated()), this, SLOT(dumpTrace()));
+    }
     connect(mainWindow->actionCheckUpdate, SIGNAL(triggered()), applicationController, SLOT(checkUpdateRequest()));
 
 
@@ -347,6 +368,9 @@ int UBApplication::exec(const QString& pFileToImport)
     applicationController->initScreenLayout(bUseMultiScreen);
     boardController->setupLayout();
 
+    if (mBenchmark)
+        return mBenchmark->run();
+
     if (pFileToImport.length() > 0)
         UBApplication::applicationController->importFile(pFileToImport);
 
@@ -362,6 +386,36 @@ int UBApplication::exec(const QString& pFileToImport)
     return QApplication::exec();
 }
 
+/**
+ * Tracing is enabled by the -trace argument, optionally followed by the file the trace is written to, or by
+ * the OPENBOARD_TRACE environment variable holding that file name.
+ */
+void UBApplication::setupTracing(QStringList args)
+{
+    int traceIndex = args.indexOf("-trace");
+
+    if (traceIndex >= 0)
+    {
+        if (traceIndex + 1 < args.size() && !args.at(traceIndex + 1).startsWith("-"))
+            mTraceFileName = args.at(traceIndex + 1);
+    }
+    else if (qEnvironmentVariableIsSet("OPENBOARD_TRACE"))
+        mTraceFileName = QString::fromLocal8Bit(qgetenv("OPENBOARD_TRACE"));
+    else
+        return;
+
+    if (mTraceFileName.isEmpty())
+        mTraceFileName = UBSettings::userDataDirectory() + "/log/trace.json";
+
+    UBTrace::enable();
+}
+
+void UBApplication::dumpTrace()
+{
+    if (UBTrace::dump(mTraceFileName))
+        qDebug() << "trace written to" << mTraceFileName;
+}
+
 void UBApplication::onScreenCountChanged(int newCount)
 {
     Q_UNUSED(newCount);
@@ -626,6 +680,9 @@ bool UBApplication::handleOpenMessage(const QString& pMessage)
 
 void UBApplication::cleanup()
 {
+    if (UBTrace::isEnabled())
+        dumpTrace();
+
     if (applicationController) delete applicationController;
     if (boardController) delete boardController;
     if (webController) delete webController;
@@ -53,6 +53,7 @@ class UBPersistenceManager;
 class UBApplicationController;
 class UBDocumentController;
 class UBMainWindow;
+class UBBenchmark;
 
 class UBApplication : public QtSingleApplication
 {
@@ -133,12 +134,15 @@ class UBApplication : public QtSingleApplication
         void showMinimized();
 //#endif
         void onScreenCountChanged(int newCount);
+        void dumpTrace();
 
     private:
         void updateProtoActionsState();
         void setupTranslators(QStringList args);
+        void setupTracing(QStringList args);
         QList<QMenu*> mProtoMenus;
         bool mIsVerbose;
+        QString mTraceFileName;
         QString checkLanguageAvailabilityForSankore(QString& language);
     protected:
 /*
@@ -148,6 +152,7 @@ class UBApplication : public QtSingleApplication
         */
 
         UBPreferencesController* mPreferencesController;
+        UBBenchmark* mBenchmark;
         QTranslator* mApplicationTranslator;
         QTranslator* mQtGuiTranslator;
 
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#include "UBAssetManifest.h"
+
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "core/UBPageManifest.h"
+#include "core/UBDocumentJournal.h"
+
+#include "core/memcheck.h"
+
+const QString UBAssetManifest::manifestFileName = "assets.xml";
+
+static const QString tAssets = "assets";
+static const QString tPage = "page";
+static const QString tAsset = "asset";
+static const QString tItemTextContent = "itemTextContent";
+static const QString tPreference = "preference";
+static const QString tForeignObject = "foreignObject";
+static const QString aVersion = "version";
+static const QString aFile = "file";
+static const QString aHref = "href";
+static const QString aValue = "value";
+static const QString vCurrentVersion = "1";
+
+// attributes of the page format that may hold a document relative file path
+static const QStringList sReferenceAttributes = QStringList()
+        << "xlink:href" << "ub:src" << "ub:actionFirstParameter" << "relativePath";
+
+QHash<QString, UBAssetManifest*> UBAssetManifest::sManifests;
+QMutex UBAssetManifest::sManifestsMutex;
+
+static QString normalizedReference(const QString& reference)
+{
+    QString result = reference.trimmed();
+
+    // pdf references carry the page number, i.e. objects/{uuid}.pdf#page=3
+    int fragmentIndex = result.indexOf('#');
+    if (fragmentIndex != -1)
+        result.truncate(fragmentIndex);
+
+    if (result.isEmpty() || result.contains(':') || result.startsWith('/') || !result.contains('/'))
+        return QString();
+
+    return result;
+}
+
+
+UBAssetManifest::UBAssetManifest(const QString& documentPath)
+    : mDocumentPath(documentPath)
+{
+    load();
+}
+
+
+UBAssetManifest* UBAssetManifest::manifest(const QString& documentPath)
+{
+    QString key = QDir::cleanPath(documentPath);
+
+    QMutexLocker locker(&sManifestsMutex);
+
+    UBAssetManifest* assetManifest = sManifests.value(key, 0);
+    if (!assetManifest)
+    {
+        assetManifest = new UBAssetManifest(key);
+        sManifests.insert(key, assetManifest);
+    }
+
+    return assetManifest;
+}
+
+
+void UBAssetManifest::forget(const QString& documentPath)
+{
+    QMutexLocker locker(&sManifestsMutex);
+
+    delete sManifests.take(QDir::cleanPath(documentPath));
+}
+
+
+QSet<QString> UBAssetManifest::scanPage(const QString& svgFilePath)
+{
+    QSet<QString> assets;
+
+    QFile file(svgFilePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return assets;
+
+    QXmlStreamReader reader(&file);
+    QString currentWidget;
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (!reader.isStartElement())
+            continue;
+
+        QXmlStreamAttributes attributes = reader.attributes();
+
+        foreach(QString attributeName, sReferenceAttributes)
+        {
+            QString reference = normalizedReference(attributes.value(attributeName).toString());
+            if (!reference.isEmpty())
+                assets.insert(reference);
+        }
+
+        if (reader.name() == tForeignObject)
+        {
+            currentWidget = normalizedReference(attributes.value("ub:src").toString());
+        }
+        else if (reader.name() == tPreference && !currentWidget.isEmpty())
+        {
+            foreach(QString reference, referencesInText(attributes.value(aValue).toString(), "objects"))
+                assets.insert(currentWidget + "/" + reference);
+        }
+        else if (reader.name() == tItemTextContent)
+        {
+            foreach(QString reference, referencesInText(reader.readElementText(), "images"))
+                assets.insert(reference);
+        }
+    }
+
+    file.close();
+
+    return assets;
+}
+
+
+QStringList UBAssetManifest::referencesInText(const QString& text, const QString& directory)
+{
+    QStringList references;
+
+    QRegExp referenceExpression(QRegExp::escape(directory + "/") + "[^\"'\\s\\)]+");
+
+    int position = 0;
+    while ((position = referenceExpression.indexIn(text, position)) != -1)
+    {
+        references << referenceExpression.cap();
+        position += referenceExpression.matchedLength();
+    }
+
+    return references;
+}
+
+
+void UBAssetManifest::setPageAssets(const QString& pageFileName, const QSet<QString>& assets, UBDocumentJournal* journal)
+{
+    if (mPageAssets.contains(pageFileName) && mPageAssets.value(pageFileName) == assets)
+        return;
+
+    removeReferences(mPageAssets.value(pageFileName));
+    addReferences(assets);
+
+    mPageAssets.insert(pageFileName, assets);
+
+    persist(journal);
+}
+
+
+void UBAssetManifest::removePage(const QString& pageFileName)
+{
+    removePages(QStringList() << pageFileName);
+}
+
+
+void UBAssetManifest::removePages(const QStringList& pageFileNames)
+{
+    bool removed = false;
+
+    foreach(QString pageFileName, pageFileNames)
+    {
+        if (!mPageAssets.contains(pageFileName))
+            continue;
+
+        removeReferences(mPageAssets.take(pageFileName));
+        removed = true;
+    }
+
+    if (removed)
+        persist();
+}
+
+
+QSet<QString> UBAssetManifest::pageAssets(const QString& pageFileName) const
+{
+    if (mPageAssets.contains(pageFileName))
+        return mPageAssets.value(pageFileName);
+
+    return scanPage(mDocumentPath + "/" + pageFileName + ".svg");
+}
+
+
+QStringList UBAssetManifest::references()
+{
+    ensureComplete();
+
+    return mReferenceCounts.keys();
+}
+
+
+int UBAssetManifest::referenceCount(const QString& asset)
+{
+    ensureComplete();
+
+    return mReferenceCounts.value(asset, 0);
+}
+
+
+bool UBAssetManifest::hasReferenceIn(const QString& directory, const QString& suffix)
+{
+    ensureComplete();
+
+    QString prefix = directory + "/";
+
+    foreach(QString asset, mReferenceCounts.keys())
+    {
+        if (asset.startsWith(prefix) && (suffix.isEmpty() || asset.endsWith(suffix, Qt::CaseInsensitive)))
+            return true;
+    }
+
+    return false;
+}
+
+
+bool UBAssetManifest::persist(UBDocumentJournal* journal)
+{
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+
+    QXmlStreamWriter writer(&buffer);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement(tAssets);
+    writer.writeAttribute(aVersion, vCurrentVersion);
+
+    foreach(QString pageFileName, mPageAssets.keys())
+    {
+        writer.writeStartElement(tPage);
+        writer.writeAttribute(aFile, pageFileName);
+
+        foreach(QString asset, mPageAssets.value(pageFileName))
+        {
+            writer.writeStartElement(tAsset);
+            writer.writeAttribute(aHref, asset);
+            writer.writeEndElement();
+        }
+
+        writer.writeEndElement();
+    }
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    return UBDocumentJournal::writeFile(mDocumentPath + "/" + manifestFileName, buffer.data(), journal);
+}
+
+
+void UBAssetManifest::load()
+{
+    QFile file(mDocumentPath + "/" + manifestFileName);
+
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+        return;
+
+    QXmlStreamReader reader(&file);
+    QString pageFileName;
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (!reader.isStartElement())
+            continue;
+
+        if (reader.name() == tPage)
+        {
+            pageFileName = reader.attributes().value(aFile).toString();
+            mPageAssets.insert(pageFileName, QSet<QString>());
+        }
+        else if (reader.name() == tAsset && !pageFileName.isEmpty())
+        {
+            mPageAssets[pageFileName].insert(reader.attributes().value(aHref).toString());
+        }
+    }
+
+    if (reader.hasError())
+    {
+        // pages are scanned again when the references are needed
+        qWarning() << "Error reading asset manifest" << file.fileName() << ":" << reader.errorString();
+        mPageAssets.clear();
+    }
+
+    file.close();
+
+    foreach(QSet<QString> assets, mPageAssets)
+        addReferences(assets);
+}
+
+
+void UBAssetManifest::ensureComplete()
+{
+    UBPageManifest* pages = UBPageManifest::manifest(mDocumentPath);
+
+    QSet<QString> pageFileNames;
+    bool changed = false;
+
+    for (int i = 0; i < pages->count(); i++)
+    {
+        QString pageFileName = pages->pageFileName(i);
+        pageFileNames.insert(pageFileName);
+
+        if (!mPageAssets.contains(pageFileName))
+        {
+            QSet<QString> assets = scanPage(pages->svgFilePath(i));
+            addReferences(assets);
+            mPageAssets.insert(pageFileName, assets);
+            changed = true;
+        }
+    }
+
+    foreach(QString pageFileName, mPageAssets.keys())
+    {
+        if (!pageFileNames.contains(pageFileName))
+        {
+            removeReferences(mPageAssets.take(pageFileName));
+            changed = true;
+        }
+    }
+
+    if (changed)
+        persist();
+}
+
+
+void UBAssetManifest::addReferences(const QSet<QString>& assets)
+{
+    foreach(QString asset, assets)
+        mReferenceCounts[asset]++;
+}
+
+
+void UBAssetManifest::removeReferences(const QSet<QString>& assets)
+{
+    foreach(QString asset, assets)
+    {
+        int count = mReferenceCounts.value(asset, 0) - 1;
+
+        if (count > 0)
+            mReferenceCounts.insert(asset, count);
+        else
+            mReferenceCounts.remove(asset);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#ifndef UBASSETMANIFEST_H_
+#define UBASSETMANIFEST_H_
+
+#include <QtCore>
+
+class UBDocumentJournal;
+
+/*
+ * Reference-counted list of the files (images, videos, audios, widgets, pdf objects) used by the
+ * pages of a document.
+ *
+ * References are recorded per page file when a page is saved and dropped when it is deleted, so
+ * that cleaning up unused files, copying pages with their files or checking whether a document
+ * contains a given kind of asset does not need to parse every page. Pages the manifest doesn't
+ * know yet (legacy documents, pages copied from another document) are scanned once, the first
+ * time the references are needed.
+ */
+class UBAssetManifest
+{
+    public:
+
+        static const QString manifestFileName;
+
+        static UBAssetManifest* manifest(const QString& documentPath);
+        static void forget(const QString& documentPath);
+
+        static QSet<QString> scanPage(const QString& svgFilePath);
+        static QStringList referencesInText(const QString& text, const QString& directory);
+
+        void setPageAssets(const QString& pageFileName, const QSet<QString>& assets, UBDocumentJournal* journal = 0);
+        void removePage(const QString& pageFileName);
+        void removePages(const QStringList& pageFileNames);
+        QSet<QString> pageAssets(const QString& pageFileName) const;
+
+        QStringList references();
+        int referenceCount(const QString& asset);
+        bool hasReferenceIn(const QString& directory, const QString& suffix = QString());
+
+        bool persist(UBDocumentJournal* journal = 0);
+
+    private:
+
+        UBAssetManifest(const QString& documentPath);
+
+        void load();
+        void ensureComplete();
+        void addReferences(const QSet<QString>& assets);
+        void removeReferences(const QSet<QString>& assets);
+
+        QString mDocumentPath;
+        QHash<QString, QSet<QString> > mPageAssets;
+        QHash<QString, int> mReferenceCounts;
+
+        static QHash<QString, UBAssetManifest*> sManifests;
+        static QMutex sManifestsMutex;
+};
+
+#endif /* UBASSETMANIFEST_H_ */
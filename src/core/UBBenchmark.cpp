@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#include "UBBenchmark.h"
+
+#include <QtGui>
+#include <QPdfWriter>
+
+#include "core/UBSettings.h"
+#include "core/UBPageManifest.h"
+#include "core/UBAssetManifest.h"
+#include "core/UBPersistenceManager.h"
+
+#include "adaptors/UBSvgSubsetAdaptor.h"
+#include "adaptors/UBThumbnailAdaptor.h"
+
+#include "board/UBDrawingController.h"
+
+#include "document/UBDocumentProxy.h"
+
+#include "domain/UBGraphicsScene.h"
+#include "domain/UBGraphicsPDFItem.h"
+
+#include "pdf/PDFRenderer.h"
+
+#include "core/memcheck.h"
+
+static const QString benchmarkArgument = "-benchmark";
+
+UBBenchmark::UBBenchmark(const QStringList& arguments)
+    : mDocument(0)
+{
+    mPages = intArgument(arguments, "-benchmark-pages", 10);
+    mStrokes = intArgument(arguments, "-benchmark-strokes", 100);
+    mImages = intArgument(arguments, "-benchmark-images", 2);
+    mTexts = intArgument(arguments, "-benchmark-texts", 5);
+    mPdfPages = qMin(mPages, intArgument(arguments, "-benchmark-pdf-pages", 2));
+    mIterations = qMax(1, intArgument(arguments, "-benchmark-iterations", 5));
+
+    int outputIndex = arguments.indexOf("-benchmark-output");
+    if (outputIndex >= 0 && outputIndex + 1 < arguments.size())
+        mOutputPath = arguments.at(outputIndex + 1);
+
+    // the board creates its start document and the settings their user file in there
+    if (mDataDir.isValid())
+        UBSettings::setUserDataDirectory(mDataDir.path());
+}
+
+
+bool UBBenchmark::isRequested(const QStringList& arguments)
+{
+    return arguments.contains(benchmarkArgument);
+}
+
+
+int UBBenchmark::intArgument(const QStringList& arguments, const QString& name, int defaultValue) const
+{
+    int index = arguments.indexOf(name);
+    if (index < 0 || index + 1 >= arguments.size())
+        return defaultValue;
+
+    bool ok = false;
+    int value = arguments.at(index + 1).toInt(&ok);
+
+    return ok ? qMax(0, value) : defaultValue;
+}
+
+
+int UBBenchmark::run()
+{
+    if (!mDataDir.isValid())
+    {
+        qWarning() << "Benchmark failed: cannot create a temporary data directory";
+        return 1;
+    }
+
+    if (!createDocument())
+    {
+        qWarning() << "Benchmark failed: cannot create the benchmark document in" << mDocumentDir.path();
+        return 1;
+    }
+
+    measure("save", []{}, [this]
+    {
+        for (int i = 0; i < mScenes.count(); i++)
+            UBSvgSubsetAdaptor::persistScene(mDocument, mScenes.at(i), i);
+    }, []{});
+
+    measure("thumbnail", []{}, [this]
+    {
+        for (int i = 0; i < mScenes.count(); i++)
+            UBThumbnailAdaptor::persistScene(mDocument, mScenes.at(i), i, true);
+    }, []{});
+
+    QList<UBGraphicsScene*> scenes;
+
+    measure("load", []{}, [this, &scenes]
+    {
+        scenes = loadScenes();
+    }, [&scenes]
+    {
+        qDeleteAll(scenes);
+        scenes.clear();
+    });
+
+    // a new image each time, so that cached renderings (pdf pages in particular) don't hide the first paint
+    measure("render", [this, &scenes]
+    {
+        scenes = loadScenes();
+    }, [&scenes]
+    {
+        foreach(UBGraphicsScene* scene, scenes)
+        {
+            QSize size = scene->nominalSize();
+            QImage image(size, QImage::Format_ARGB32_Premultiplied);
+            image.fill(Qt::transparent);
+
+            QPainter painter(&image);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setRenderHint(QPainter::SmoothPixmapTransform);
+            scene->render(&painter, QRectF(QPointF(0, 0), size), QRectF(QPointF(-size.width() / 2., -size.height() / 2.), size));
+        }
+    }, [&scenes]
+    {
+        qDeleteAll(scenes);
+        scenes.clear();
+    });
+
+    measure("eraser", [this, &scenes]
+    {
+        scenes = loadScenes();
+    }, [this, &scenes]
+    {
+        foreach(UBGraphicsScene* scene, scenes)
+            erase(scene);
+    }, [&scenes]
+    {
+        qDeleteAll(scenes);
+        scenes.clear();
+    });
+
+    deleteDocument();
+
+    return writeResults() ? 0 : 1;
+}
+
+
+bool UBBenchmark::createDocument()
+{
+    if (!mDocumentDir.isValid())
+        return false;
+
+    mDocument = new UBDocumentProxy(mDocumentDir.path());
+    mDocument->setMetaData(UBSettings::documentName, "Benchmark");
+
+    QString pdfPath = mPdfPages > 0 ? createPdf(mPdfPages) : QString();
+    if (mPdfPages > 0 && pdfPath.isEmpty())
+        return false;
+
+    for (int i = 0; i < mPages; i++)
+    {
+        UBGraphicsScene* scene = new UBGraphicsScene(mDocument, false);
+        scene->setNominalSize(UBSettings::settings()->pageSize->get().toSize());
+
+        populateScene(scene, i, pdfPath);
+
+        mScenes << scene;
+    }
+
+    mDocument->setPageCount(mPages);
+
+    // the pages must exist on disk before the load passes
+    for (int i = 0; i < mScenes.count(); i++)
+        UBSvgSubsetAdaptor::persistScene(mDocument, mScenes.at(i), i);
+
+    return true;
+}
+
+
+void UBBenchmark::deleteDocument()
+{
+    qDeleteAll(mScenes);
+    mScenes.clear();
+
+    delete mDocument;
+    mDocument = 0;
+
+    UBPageManifest::forget(mDocumentDir.path());
+    UBAssetManifest::forget(mDocumentDir.path());
+}
+
+
+QString UBBenchmark::createPdf(int pageCount)
+{
+    QDir documentDir(mDocumentDir.path());
+    documentDir.mkpath(UBPersistenceManager::objectDirectory);
+
+    QString pdfPath = documentDir.filePath(UBPersistenceManager::objectDirectory + "/" + QUuid::createUuid().toString() + ".pdf");
+
+    QPdfWriter writer(pdfPath);
+    writer.setPageSize(QPagedPaintDevice::A4);
+
+    QPainter painter;
+    if (!painter.begin(&writer))
+        return QString();
+
+    QRect page = painter.viewport();
+
+    for (int i = 0; i < pageCount; i++)
+    {
+        if (i > 0)
+            writer.newPage();
+
+        painter.setFont(QFont("Arial", 24));
+        painter.drawText(page.adjusted(page.width() / 10, page.height() / 10, 0, 0), QString("Benchmark page %1").arg(i + 1));
+
+        painter.setFont(QFont("Arial", 10));
+        for (int line = 0; line < 40; line++)
+            painter.drawText(page.width() / 10, page.height() / 5 + line * page.height() / 60,
+                             QString("Line %1 of a text that fills the pdf page with glyphs to render").arg(line + 1));
+
+        painter.setPen(QPen(Qt::darkBlue, page.width() / 200));
+        for (int shape = 0; shape < 20; shape++)
+            painter.drawEllipse(QPoint(page.width() / 2, page.height() * 3 / 4), shape * page.width() / 50, shape * page.width() / 80);
+    }
+
+    painter.end();
+
+    return pdfPath;
+}
+
+
+void UBBenchmark::populateScene(UBGraphicsScene* scene, int pageIndex, const QString& pdfPath)
+{
+    QSize size = scene->nominalSize();
+    QRectF area(-size.width() / 2., -size.height() / 2., size.width(), size.height());
+
+    if (pageIndex < mPdfPages)
+    {
+        QUuid pdfUuid(QFileInfo(pdfPath).completeBaseName());
+        PDFRenderer* renderer = PDFRenderer::rendererForUuid(pdfUuid, pdfPath, true);
+
+        UBGraphicsPDFItem* pdfItem = new UBGraphicsPDFItem(renderer, pageIndex + 1);
+        pdfItem->setPos(-pdfItem->boundingRect().width() / 2, -pdfItem->boundingRect().height() / 2);
+        scene->setAsBackgroundObject(pdfItem, false, false);
+    }
+
+    QImage image(640, 480, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); y++)
+    {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); x++)
+            line[x] = qRgb((x + pageIndex * 16) % 256, (y * 2) % 256, (x * y + qrand()) % 256);
+    }
+
+    for (int i = 0; i < mImages; i++)
+        scene->addPixmap(QPixmap::fromImage(image), 0, area.center() + QPointF(i * 40 - 200, i * 30 - 150), 0.5, false, true);
+
+    for (int i = 0; i < mTexts; i++)
+        scene->addTextWithFont(QString("Benchmark text %1 of page %2").arg(i + 1).arg(pageIndex + 1),
+                               area.topLeft() + QPointF(area.width() / 10, area.height() * (i + 1) / (mTexts + 2)), 24);
+
+    UBDrawingController::drawingController()->setStylusTool(UBStylusTool::Pen);
+
+    for (int i = 0; i < mStrokes; i++)
+    {
+        QPointF start(area.left() + (qrand() % 1000) / 1000. * area.width() * 0.8,
+                      area.top() + (qrand() % 1000) / 1000. * area.height() * 0.9);
+        drawStroke(scene, start, 40);
+    }
+}
+
+
+void UBBenchmark::drawStroke(UBGraphicsScene* scene, const QPointF& start, int pointCount)
+{
+    scene->inputDevicePress(start, 1.0);
+
+    for (int i = 1; i <= pointCount; i++)
+        scene->inputDeviceMove(start + QPointF(i * 5, 40 * qSin(i / 6.)), 0.5 + 0.5 * qAbs(qSin(i / 9.)));
+
+    scene->inputDeviceRelease();
+}
+
+
+void UBBenchmark::erase(UBGraphicsScene* scene)
+{
+    UBDrawingController::drawingController()->setStylusTool(UBStylusTool::Eraser);
+
+    QSize size = scene->nominalSize();
+    QRectF area(-size.width() / 2., -size.height() / 2., size.width(), size.height());
+
+    // horizontal sweeps across the whole page
+    for (qreal y = area.top(); y < area.bottom(); y += area.height() / 8)
+    {
+        scene->inputDevicePress(QPointF(area.left(), y));
+        for (qreal x = area.left(); x < area.right(); x += 10)
+            scene->inputDeviceMove(QPointF(x, y + 20 * qSin(x / 50)));
+        scene->inputDeviceRelease();
+    }
+
+    UBDrawingController::drawingController()->setStylusTool(UBStylusTool::Pen);
+}
+
+
+QList<UBGraphicsScene*> UBBenchmark::loadScenes()
+{
+    QList<UBGraphicsScene*> scenes;
+
+    for (int i = 0; i < mPages; i++)
+    {
+        UBGraphicsScene* scene = UBSvgSubsetAdaptor::loadScene(mDocument, i);
+        if (scene)
+            scenes << scene;
+    }
+
+    return scenes;
+}
+
+
+void UBBenchmark::measure(const QString& name, std::function<void()> setUp, std::function<void()> pass, std::function<void()> tearDown)
+{
+    Result result;
+    result.name = name;
+
+    QElapsedTimer timer;
+
+    for (int i = 0; i < mIterations; i++)
+    {
+        setUp();
+
+        timer.start();
+        pass();
+        result.samples << timer.nsecsElapsed();
+
+        tearDown();
+    }
+
+    mResults << result;
+}
+
+
+bool UBBenchmark::writeResults()
+{
+    QJsonObject parameters;
+    parameters["pages"] = mPages;
+    parameters["strokes"] = mStrokes;
+    parameters["images"] = mImages;
+    parameters["texts"] = mTexts;
+    parameters["pdfPages"] = mPdfPages;
+    parameters["iterations"] = mIterations;
+
+    QJsonArray results;
+    foreach(Result result, mResults)
+    {
+        qSort(result.samples);
+
+        qint64 total = 0;
+        foreach(qint64 sample, result.samples)
+            total += sample;
+
+        QJsonObject entry;
+        entry["name"] = result.name;
+        entry["minMs"] = result.samples.first() / 1e6;
+        entry["medianMs"] = result.samples.at(result.samples.count() / 2) / 1e6;
+        entry["meanMs"] = total / 1e6 / result.samples.count();
+        entry["maxMs"] = result.samples.last() / 1e6;
+
+        results.append(entry);
+    }
+
+    QJsonObject root;
+    root["version"] = QCoreApplication::applicationVersion();
+    root["parameters"] = parameters;
+    root["results"] = results;
+
+    QByteArray json = QJsonDocument(root).toJson();
+
+    if (mOutputPath.isEmpty())
+    {
+        QTextStream(stdout) << json;
+        return true;
+    }
+
+    QFile output(mOutputPath);
+    if (!output.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Benchmark failed: cannot write the results to" << mOutputPath << output.errorString();
+        return false;
+    }
+
+    output.write(json);
+    output.close();
+
+    return true;
+}
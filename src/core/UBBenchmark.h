@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#ifndef UBBENCHMARK_H_
+#define UBBENCHMARK_H_
+
+#include <QtCore>
+
+#include <functional>
+
+class UBDocumentProxy;
+class UBGraphicsScene;
+
+/*
+ * Benchmark of the page hot paths, run instead of the application with the -benchmark argument.
+ *
+ * It must be created before the settings are first used: the application then runs on a temporary data
+ * directory with default settings, so that neither the user's preferences nor their documents affect the
+ * timings or are touched by the run. A synthetic document is generated in a temporary folder, then its
+ * pages are saved, thumbnailed, loaded, rendered and erased a number of times. The timings are written as JSON to stdout, or to the file given
+ * with -benchmark-output. With QT_QPA_PLATFORM=offscreen it runs without a display, e.g.
+ *
+ *   OpenBoard -benchmark -benchmark-pages 10 -benchmark-strokes 200 -benchmark-pdf-pages 5
+ */
+class UBBenchmark
+{
+    public:
+
+        UBBenchmark(const QStringList& arguments);
+
+        static bool isRequested(const QStringList& arguments);
+
+        int run();
+
+    private:
+
+        int intArgument(const QStringList& arguments, const QString& name, int defaultValue) const;
+
+        bool createDocument();
+        void deleteDocument();
+        QString createPdf(int pageCount);
+        void populateScene(UBGraphicsScene* scene, int pageIndex, const QString& pdfPath);
+        void drawStroke(UBGraphicsScene* scene, const QPointF& start, int pointCount);
+        void erase(UBGraphicsScene* scene);
+
+        QList<UBGraphicsScene*> loadScenes();
+
+        void measure(const QString& name, std::function<void()> setUp, std::function<void()> pass, std::function<void()> tearDown);
+        bool writeResults();
+
+        int mPages;
+        int mStrokes;
+        int mImages;
+        int mTexts;
+        int mPdfPages;
+        int mIterations;
+        QString mOutputPath;
+
+        QTemporaryDir mDataDir;
+        QTemporaryDir mDocumentDir;
+        UBDocumentProxy* mDocument;
+        QList<UBGraphicsScene*> mScenes;
+
+        struct Result
+        {
+            QString name;
+            QList<qint64> samples; // nanoseconds
+        };
+
+        QList<Result> mResults;
+};
+
+#endif /* UBBENCHMARK_H_ */
@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#include "UBDocumentJournal.h"
+
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+#include "core/memcheck.h"
+
+const QString UBDocumentJournal::journalFileName = "journal.txt";
+const QString UBDocumentJournal::stagedFileSuffix = ".staged";
+
+static const QString vPending = "pending";
+static const QString vCommitted = "committed";
+
+QHash<QString, UBDocumentJournal::WrittenFile> UBDocumentJournal::sWrittenFiles;
+QMutex UBDocumentJournal::sMutex;
+
+UBDocumentJournal::UBDocumentJournal(const QString& documentPath)
+    : mDocumentPath(QDir::cleanPath(documentPath))
+    , mIsOpen(true)
+    , mHasFailed(false)
+{
+    mPendingJournal.setFileName(mDocumentPath + "/" + journalFileName);
+}
+
+
+UBDocumentJournal::~UBDocumentJournal()
+{
+    if (mIsOpen)
+        rollback();
+}
+
+
+bool UBDocumentJournal::commit()
+{
+    if (!mIsOpen)
+        return false;
+
+    if (mHasFailed)
+    {
+        qWarning() << "Not committing the save of" << mDocumentPath << ": a file could not be staged";
+        rollback();
+        return false;
+    }
+
+    finish();
+
+    bool journalStarted = mPendingJournal.isOpen();
+    if (journalStarted)
+        mPendingJournal.close();
+
+    if (mStagedFiles.isEmpty())
+    {
+        if (journalStarted)
+            QFile::remove(mPendingJournal.fileName());
+
+        return true;
+    }
+
+    // once the committed journal is on disk, the save is complete even if we crash before moving the files
+    QSaveFile journal(mDocumentPath + "/" + journalFileName);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qWarning() << "Cannot open journal" << journal.fileName() << "for writing:" << journal.errorString();
+        rollback();
+        return false;
+    }
+
+    journal.write(vCommitted.toUtf8() + "\n");
+    foreach(QString relativePath, mStagedFiles)
+        journal.write(relativePath.toUtf8() + "\n");
+
+    if (!journal.commit())
+    {
+        qWarning() << "Cannot commit journal" << journal.fileName() << ":" << journal.errorString();
+        rollback();
+        return false;
+    }
+
+    bool result = true;
+
+    foreach(QString relativePath, mStagedFiles)
+    {
+        QString filePath = mDocumentPath + "/" + relativePath;
+
+        if (replaceWithStagedFile(filePath))
+            rememberWrittenFile(filePath, mStagedDigests.value(relativePath));
+        else
+            result = false;
+    }
+
+    // keep the journal if a file could not be moved, so that the next startup retries
+    if (result)
+        QFile::remove(journal.fileName());
+
+    mStagedFiles.clear();
+    mStagedDigests.clear();
+
+    return result;
+}
+
+
+void UBDocumentJournal::rollback()
+{
+    finish();
+
+    bool journalStarted = mPendingJournal.isOpen();
+    if (journalStarted)
+        mPendingJournal.close();
+
+    foreach(QString relativePath, mStagedFiles)
+        QFile::remove(mDocumentPath + "/" + relativePath + stagedFileSuffix);
+
+    if (journalStarted)
+        QFile::remove(mPendingJournal.fileName());
+
+    mStagedFiles.clear();
+    mStagedDigests.clear();
+}
+
+
+void UBDocumentJournal::finish()
+{
+    mIsOpen = false;
+}
+
+
+bool UBDocumentJournal::writeFile(const QString& filePath, const QByteArray& data, UBDocumentJournal* journal)
+{
+    QString cleanFilePath = QDir::cleanPath(filePath);
+    QByteArray digest = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+
+    if (isUnchanged(cleanFilePath, digest))
+        return true;
+
+    if (journal && journal->mIsOpen && cleanFilePath.startsWith(journal->mDocumentPath + "/"))
+        return journal->stage(cleanFilePath, data);
+
+    QSaveFile file(cleanFilePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCritical() << "cannot open " << cleanFilePath << " for writing ...";
+        qCritical() << "error : " << file.errorString();
+        return false;
+    }
+
+    file.write(data);
+
+    if (!file.commit())
+    {
+        qCritical() << "cannot write " << cleanFilePath << ":" << file.errorString();
+        return false;
+    }
+
+    rememberWrittenFile(cleanFilePath, digest);
+
+    return true;
+}
+
+
+bool UBDocumentJournal::stage(const QString& filePath, const QByteArray& data)
+{
+    QString relativePath = filePath.mid(mDocumentPath.length() + 1);
+
+    // assume the worst until the file is staged
+    bool hasFailed = mHasFailed;
+    mHasFailed = true;
+
+    if (!mPendingJournal.isOpen())
+    {
+        if (!mPendingJournal.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        {
+            qWarning() << "Cannot open journal" << mPendingJournal.fileName() << "for writing:" << mPendingJournal.errorString();
+            return false;
+        }
+
+        mPendingJournal.write(vPending.toUtf8() + "\n");
+    }
+
+    // listed before it is written so that an interrupted save can always be cleaned up
+    if (!mStagedFiles.contains(relativePath))
+    {
+        mPendingJournal.write(relativePath.toUtf8() + "\n");
+        mPendingJournal.flush();
+    }
+
+    QSaveFile stagedFile(filePath + stagedFileSuffix);
+    if (!stagedFile.open(QIODevice::WriteOnly))
+    {
+        qCritical() << "cannot open " << stagedFile.fileName() << " for writing ...";
+        return false;
+    }
+
+    stagedFile.write(data);
+
+    if (!stagedFile.commit())
+    {
+        qCritical() << "cannot write " << stagedFile.fileName() << ":" << stagedFile.errorString();
+        return false;
+    }
+
+    if (!mStagedFiles.contains(relativePath))
+        mStagedFiles << relativePath;
+
+    mStagedDigests.insert(relativePath, QCryptographicHash::hash(data, QCryptographicHash::Md5));
+
+    mHasFailed = hasFailed;
+
+    return true;
+}
+
+
+void UBDocumentJournal::recover(const QString& documentPath)
+{
+    QString cleanDocumentPath = QDir::cleanPath(documentPath);
+    QFile journal(cleanDocumentPath + "/" + journalFileName);
+
+    if (!journal.exists())
+        return;
+
+    if (!journal.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qWarning() << "Cannot open journal" << journal.fileName() << "for recovery:" << journal.errorString();
+        return;
+    }
+
+    QString state = QString::fromUtf8(journal.readLine()).trimmed();
+
+    QStringList relativePaths;
+    while (!journal.atEnd())
+    {
+        QString relativePath = QString::fromUtf8(journal.readLine()).trimmed();
+        if (!relativePath.isEmpty())
+            relativePaths << relativePath;
+    }
+
+    journal.close();
+
+    bool complete = true;
+
+    foreach(QString relativePath, relativePaths)
+    {
+        QString filePath = cleanDocumentPath + "/" + relativePath;
+
+        if (!QFile::exists(filePath + stagedFileSuffix))
+            continue;
+
+        if (state == vCommitted)
+            complete &= replaceWithStagedFile(filePath);
+        else
+            QFile::remove(filePath + stagedFileSuffix);
+    }
+
+    qDebug() << (state == vCommitted ? "Completed" : "Rolled back") << "interrupted save of" << cleanDocumentPath;
+
+    if (complete)
+        QFile::remove(journal.fileName());
+}
+
+
+bool UBDocumentJournal::isJournalFile(const QString& fileName)
+{
+    QString name = QFileInfo(fileName).fileName();
+
+    return name == journalFileName || name.endsWith(stagedFileSuffix);
+}
+
+
+bool UBDocumentJournal::isUnchanged(const QString& filePath, const QByteArray& digest)
+{
+    QFileInfo fileInfo(filePath);
+
+    if (!fileInfo.exists())
+        return false;
+
+    QMutexLocker locker(&sMutex);
+
+    if (!sWrittenFiles.contains(filePath))
+        return false;
+
+    // size and date guard against files replaced behind our back since we wrote them
+    const WrittenFile& writtenFile = sWrittenFiles[filePath];
+
+    return writtenFile.digest == digest
+            && writtenFile.size == fileInfo.size()
+            && writtenFile.lastModified == fileInfo.lastModified();
+}
+
+
+void UBDocumentJournal::rememberWrittenFile(const QString& filePath, const QByteArray& digest)
+{
+    QFileInfo fileInfo(filePath);
+
+    WrittenFile writtenFile;
+    writtenFile.digest = digest;
+    writtenFile.size = fileInfo.size();
+    writtenFile.lastModified = fileInfo.lastModified();
+
+    QMutexLocker locker(&sMutex);
+    sWrittenFiles.insert(filePath, writtenFile);
+}
+
+
+bool UBDocumentJournal::replaceWithStagedFile(const QString& filePath)
+{
+    QString stagedFilePath = filePath + stagedFileSuffix;
+
+    if (QFile::exists(filePath) && !QFile::remove(filePath))
+    {
+        qWarning() << "Cannot replace" << filePath;
+        return false;
+    }
+
+    if (!QFile::rename(stagedFilePath, filePath))
+    {
+        qWarning() << "Cannot move" << stagedFilePath << "to" << filePath;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#ifndef UBDOCUMENTJOURNAL_H_
+#define UBDOCUMENTJOURNAL_H_
+
+#include <QtCore>
+
+/*
+ * Write-ahead journal making multi-file document saves atomic.
+ *
+ * Writers given a journal through UBDocumentJournal::writeFile stage their file next to its target.
+ * commit() records the staged files in the journal, then moves them in place; an interrupted commit
+ * is replayed by recover() on next startup, and a save that never reached commit() is rolled back.
+ * Without a journal, writeFile still replaces the file atomically. commit() fails, and rolls the
+ * save back, if any of the files could not be staged.
+ *
+ * Files whose content did not change since they were last written are neither rewritten nor synced.
+ */
+class UBDocumentJournal
+{
+    public:
+
+        UBDocumentJournal(const QString& documentPath);
+        virtual ~UBDocumentJournal();
+
+        bool commit();
+        void rollback();
+
+        static bool writeFile(const QString& filePath, const QByteArray& data, UBDocumentJournal* journal = 0);
+        static void recover(const QString& documentPath);
+
+        // whether the file is a journal or a staged file, which are never copied or exported
+        static bool isJournalFile(const QString& fileName);
+
+        static const QString journalFileName;
+        static const QString stagedFileSuffix;
+
+    private:
+
+        struct WrittenFile
+        {
+            QByteArray digest;
+            qint64 size;
+            QDateTime lastModified;
+        };
+
+        bool stage(const QString& filePath, const QByteArray& data);
+        void finish();
+
+        static bool isUnchanged(const QString& filePath, const QByteArray& digest);
+        static void rememberWrittenFile(const QString& filePath, const QByteArray& digest);
+        static bool replaceWithStagedFile(const QString& filePath);
+
+        QString mDocumentPath;
+        QStringList mStagedFiles;
+        QHash<QString, QByteArray> mStagedDigests;
+        QFile mPendingJournal;
+        bool mIsOpen;
+        bool mHasFailed;
+
+        static QHash<QString, WrittenFile> sWrittenFiles;
+        static QMutex sMutex;
+};
+
+#endif /* UBDOCUMENTJOURNAL_H_ */
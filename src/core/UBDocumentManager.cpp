@@ -208,20 +208,23 @@ UBDocumentProxy* UBDocumentManager::importFile(const QFile& pFile, const QString
                     }
                 }
 
-                QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
-                int nPage = 0;
-                foreach(UBGraphicsItem* page, pages)
+                if (!importAdaptor->importPages(document, uuid, filepath))
                 {
+                    QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
+                    int nPage = 0;
+                    foreach(UBGraphicsItem* page, pages)
+                    {
 
-                    UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
+                        UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
 #ifdef Q_WS_MACX
-                    //Workaround for issue 912
-                    QApplication::processEvents();
+                        //Workaround for issue 912
+                        QApplication::processEvents();
 #endif
-                    int pageIndex = document->pageCount();
-                    UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
-                    importAdaptor->placeImportedItemToScene(scene, page);
-                    UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
+                        int pageIndex = document->pageCount();
+                        UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
+                        importAdaptor->placeImportedItemToScene(scene, page);
+                        UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
+                    }
                 }
 
                 UBPersistenceManager::persistenceManager()->persistDocumentMetadata(document);
@@ -277,16 +280,25 @@ int UBDocumentManager::addFilesToDocument(UBDocumentProxy* document, QStringList
                         }
                     }
 
-                    QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
-                    int nPage = 0;
-                    foreach(UBGraphicsItem* page, pages)
+                    int firstNewPage = document->pageCount();
+                    if (importAdaptor->importPages(document, uuid, filepath))
                     {
-                        UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
-                        int pageIndex = document->pageCount();
-                        UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
-                        importAdaptor->placeImportedItemToScene(scene, page);
-                        UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
-                        UBApplication::boardController->insertThumbPage(pageIndex);
+                        for (int pageIndex = firstNewPage; pageIndex < document->pageCount(); pageIndex++)
+                            UBApplication::boardController->insertThumbPage(pageIndex);
+                    }
+                    else
+                    {
+                        QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
+                        int nPage = 0;
+                        foreach(UBGraphicsItem* page, pages)
+                        {
+                            UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
+                            int pageIndex = document->pageCount();
+                            UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
+                            importAdaptor->placeImportedItemToScene(scene, page);
+                            UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
+                            UBApplication::boardController->insertThumbPage(pageIndex);
+                        }
                     }
 
                     UBPersistenceManager::persistenceManager()->persistDocumentMetadata(document);
@@ -29,6 +29,8 @@
 #include <QtGui>
 #include <QtXml>
 #include "UBSettings.h"
+#include "UBPageManifest.h"
+#include "UBAssetManifest.h"
 
 const QString tVideo = "video";
 const QString tAudio = "audio";
@@ -52,6 +54,9 @@ const QString vReqExt = "http://ns.adobe.com/pdf/1.3/";
 const QString wgtSuff = ".wgt";
 const QString thumbSuff = ".png";
 
+const QString widgetsPrefix = "widgets/";
+const QString objectsSubPath = "/objects/";
+
 const QString scanDirs = "audios,images,videos,teacherGuideObjects,widgets";
 const QStringList trashFilter = QStringList() << "*.swf";
 
@@ -152,12 +157,6 @@ static QString thumbFileNameFrom(const QString &filePath)
     return thumbPath;
 }
 
-
-QString svgPageName(int pageIndex)
-{
-    return QString("page%1.svg").arg(pageIndex, 3, 10, QLatin1Char('0'));
-}
-
 static QDomDocument createDomFromSvg(const QString &svgUrl)
 {
     Q_ASSERT(QFile::exists(svgUrl));
@@ -198,10 +197,14 @@ public:
         mCurrentDir = dir.toLocalFile();
         cleanTrash();
 
-        // Gathering information from svg files
-        QFileInfoList svgInfos = QDir(mCurrentDir).entryInfoList(QStringList() << "*.svg", QDir::NoDotAndDotDot | QDir::Files);
-        foreach (QFileInfo svgInfo, svgInfos) {
-            cureIdsFromSvgDom(createDomFromSvg(svgInfo.absoluteFilePath()));
+        // Gathering information from the asset manifest instead of parsing every page
+        UBAssetManifest *assets = UBAssetManifest::manifest(mCurrentDir);
+        foreach (QString reference, assets->references()) {
+            containReference(reference);
+        }
+
+        foreach (QString widgetPath, mWidgetObjectsMap.keys()) {
+            cleanObjectFolder(widgetPath, mWidgetObjectsMap.value(widgetPath));
         }
 
         fitIdsFromFileSystem();
@@ -241,22 +244,25 @@ private:
         }
     }
 
-    void cureIdsFromSvgDom(const QDomDocument &dom)
+    void containReference(const QString &reference)
     {
-        Q_ASSERT(!dom.isNull());
+        // widget state references its own files as <widget>/objects/<file>
+        int objectsPos = reference.indexOf(objectsSubPath);
+        if (objectsPos != -1) {
+            mWidgetObjectsMap[reference.left(objectsPos)].insert(reference.mid(objectsPos + 1));
+            return;
+        }
 
-        QDomElement nextElement = dom.documentElement().firstChildElement();
-        while (!nextElement.isNull()) {
-            QString nextTag = nextElement.tagName();
-            qDebug() << "Tag name of the next parsed element is" << nextTag;
-            if (nextTag == tGroups)
-            {
-               nextElement = nextElement.firstChildElement("group");
-            }
+        if (reference.startsWith(widgetsPrefix) && !mWidgetObjectsMap.contains(reference)) {
+            mWidgetObjectsMap.insert(reference, QSet<QString>());
+        }
 
-            invokeFromText(nextTag, nextElement);
-            nextElement = nextElement.nextSiblingElement();
+        QString uid = strIdFrom(reference);
+        if (uid.isNull()) {
+            return;
         }
+
+        mDomIdsMap.insert(uid, reference);
     }
 
     void fitIdsFromFileSystem()
@@ -299,60 +305,10 @@ private:
         v.resize(it_diff - v.begin());
     }
 
-    void invokeFromText(const QString &what, const QDomElement &element)
-    {
-        if (what == tVideo
-                || what == tAudio
-                || what == tImage) {
-            mediaToContainer(element);
-        } else if (what == tForeignObject) {
-            foreingObjectToContainer(element);
-
-            //N/C - NNE - 20140317
-            cleanObjectFolder(element);
-
-            //N/C - NNE - 20140520
-            //foreign object may referer resource which are not present in the svg
-            addResourceIdToSvg(element);
-        } else if (what == tTeacherGuide) {
-            teacherGuideToContainer(element);
-        }
-
-        pullActionFromElement(element);
-    }
-
     // N/C - NNE - 20140317 : When export, reduce the size of the ubz file
-    void cleanObjectFolder(const QDomElement &element)
+    void cleanObjectFolder(const QString &widgetPath, const QSet<QString> &objectsIdUsed)
     {
-        //QDomElement preference = element.firstChildElement("ub:preference");
-
-        //N/C - NNE - 20141021
-        QDomNodeList childrenNode = element.elementsByTagName("ub:preference");
-
-        QVector<QString> objectsIdUsed;
-
-        for(int i = 0; i < childrenNode.size(); i++){
-            QDomElement preference = childrenNode.at(i).toElement();
-
-            if(!preference.isNull()){
-                QString value = preference.attribute("value");
-
-                int findPos = value.indexOf("objects/");
-                int endPos;
-
-                //find all objects used
-                while(findPos != -1){
-                    endPos = value.indexOf("\"", findPos);
-                    objectsIdUsed << value.mid(findPos, endPos - findPos);
-                    findPos = value.indexOf("objects/", endPos);
-                }
-            }
-        }
-        //N/C - NNE - 20141021 : END
-
-
-        QString path = element.attribute(aSrc);
-        QString objectsFolderPath = mCurrentDir + "/" + path + "/objects/";
+        QString objectsFolderPath = mCurrentDir + "/" + widgetPath + "/objects/";
 
         QDir dir(objectsFolderPath);
         dir.setFilter(QDir::Files | QDir::NoSymLinks | QDir::NoDotAndDotDot);
@@ -371,108 +327,11 @@ private:
     }
     // N/C - NNE - 20140317 : END
 
-    //N/C - NNE - 20140520
-    void addResourceIdToSvg(const QDomElement& element)
-    {
-        QDomElement textContent = element.firstChildElement("itemTextContent");
-
-        QString value = textContent.text();
-
-        int findPos = value.indexOf("images/");
-        int endPos;
-
-        //find all objects used
-        while(findPos != -1){
-            endPos = value.indexOf("\"", findPos);
-
-            QString path = value.mid(findPos, endPos - findPos);
-
-            QString uuid = path.split("/").at(1).split(".").at(0);
-
-            mDomIdsMap.insert(uuid, path);
-
-            findPos = value.indexOf("images/", endPos);
-        }
-    }
-    //N/C - NNE - 20140520 : END
-
-    void pullActionFromElement(const QDomElement &element)
-    {
-        if (!element.hasAttribute(aActionMedia)) {
-            return;
-        }
-
-        QString path = element.attribute(aActionMedia);
-        if (path.isNull()) {
-            return;
-        }
-
-        QString uid = strIdFrom(path);
-        if (uid.isNull()) {
-            return;
-        }
-
-        mDomIdsMap.insert(uid, path);
-    }
-
-    void teacherGuideToContainer(const QDomElement &element)
-    {
-        QDomElement nMediaElement = element.firstChildElement(tMedia);
-        while (!nMediaElement.isNull()) {
-
-            QString path = nMediaElement.attribute(aRelativePath);
-            if (path.isNull()) {
-                continue;
-            }
-
-            QString uid = strIdFrom(path);
-            if (uid.isNull()) {
-                return;
-            }
-            mDomIdsMap.insert(uid, path);
-
-            nMediaElement = nMediaElement.nextSiblingElement(tMedia);
-        }
-    }
-
-    void mediaToContainer(const QDomElement &element)
-    {
-        QString path = element.attribute(aHref);
-        if (path.isNull()) {
-            return;
-        }
-        QString uid = strIdFrom(path);
-        if (uid.isNull()) {
-            return;
-        }
-        mDomIdsMap.insert(uid, path);
-    }
-
-    void foreingObjectToContainer(const QDomElement &element)
-    {
-        QString type = element.attribute(aType);
-        if (type == vText) { // We don't have to care of the text object
-            return;
-        }
-
-        QString path = element.attribute(aSrc);
-        if (path.isNull()) {
-            return;
-        }
-
-        QString uid = strIdFrom(path);
-        if (uid.isNull()) {
-            return;
-        }
-
-        mDomIdsMap.insert(uid, path);
-    }
-
 private:
     QString mCurrentDir;
-    QDomDocument mSvgData;
     QMap<QString, QString> mDomIdsMap;
     QMap<QString, QString> mPresentIdsMap;
+    QMap<QString, QSet<QString> > mWidgetObjectsMap;
 };
 
 class PageCopier
@@ -485,8 +344,8 @@ public:
         mFromIndex = fromIndex;
         mToIndex = toIndex;
 
-        QString svgFrom = mFromDir + "/" + svgPageName(fromIndex);
-        QString svgTo = toDir.toLocalFile() + "/" + svgPageName(toIndex);
+        QString svgFrom = UBPageManifest::svgFilePath(mFromDir, fromIndex);
+        QString svgTo = UBPageManifest::svgFilePath(mToDir, toIndex);
         QDomDocument dd = createDomFromSvg(svgFrom);
         QFile fl(svgTo);
         if (!fl.open(QIODevice::WriteOnly)) {
@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#include "UBPageManifest.h"
+
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QSaveFile>
+
+#include "frameworks/UBFileSystemUtils.h"
+
+#include "core/memcheck.h"
+
+const QString UBPageManifest::manifestFileName = "pages.xml";
+
+static const QString tPages = "pages";
+static const QString tPage = "page";
+static const QString aVersion = "version";
+static const QString aId = "id";
+static const QString aFile = "file";
+static const QString vCurrentVersion = "1";
+
+QHash<QString, UBPageManifest*> UBPageManifest::sManifests;
+QMutex UBPageManifest::sManifestsMutex;
+
+UBPageManifest::UBPageManifest(const QString& documentPath)
+    : mDocumentPath(documentPath)
+{
+    load();
+}
+
+
+UBPageManifest* UBPageManifest::manifest(const QString& documentPath)
+{
+    QString key = QDir::cleanPath(documentPath);
+
+    QMutexLocker locker(&sManifestsMutex);
+
+    UBPageManifest* pageManifest = sManifests.value(key, 0);
+    if (!pageManifest)
+    {
+        pageManifest = new UBPageManifest(key);
+        sManifests.insert(key, pageManifest);
+    }
+    else if (pageManifest->isOutdated())
+    {
+        // the document was replaced or its manifest rewritten behind our back
+        pageManifest->load();
+    }
+
+    return pageManifest;
+}
+
+
+void UBPageManifest::forget(const QString& documentPath)
+{
+    QMutexLocker locker(&sManifestsMutex);
+
+    delete sManifests.take(QDir::cleanPath(documentPath));
+}
+
+
+QString UBPageManifest::svgFilePath(const QString& documentPath, int index)
+{
+    return manifest(documentPath)->svgFilePath(index);
+}
+
+
+QString UBPageManifest::thumbnailFilePath(const QString& documentPath, int index)
+{
+    return manifest(documentPath)->thumbnailFilePath(index);
+}
+
+
+int UBPageManifest::count() const
+{
+    return mPages.count();
+}
+
+
+QUuid UBPageManifest::pageId(int index) const
+{
+    if (index < 0 || index >= mPages.count())
+        return QUuid();
+
+    return mPages.at(index).id;
+}
+
+
+int UBPageManifest::indexOf(const QUuid& pageId) const
+{
+    for (int i = 0; i < mPages.count(); i++)
+    {
+        if (mPages.at(i).id == pageId)
+            return i;
+    }
+
+    return -1;
+}
+
+
+QString UBPageManifest::pageFileName(int index) const
+{
+    if (index >= 0 && index < mPages.count())
+        return mPages.at(index).fileName;
+
+    // pages that are not registered yet are looked up with the legacy naming
+    return UBFileSystemUtils::digitFileFormat("page%1", index);
+}
+
+
+QString UBPageManifest::svgFilePath(int index) const
+{
+    return mDocumentPath + "/" + pageFileName(index) + ".svg";
+}
+
+
+QString UBPageManifest::thumbnailFilePath(int index) const
+{
+    return mDocumentPath + "/" + pageFileName(index) + ".thumbnail.jpg";
+}
+
+
+void UBPageManifest::insertPage(int index)
+{
+    Page page;
+    page.id = QUuid::createUuid();
+    page.fileName = nextFreeFileName();
+
+    mPages.insert(qBound(0, index, mPages.count()), page);
+
+    persist();
+}
+
+
+// inserts one new page at each of the given indexes, counted in the resulting order
+void UBPageManifest::insertPages(const QList<int>& indexes)
+{
+    if (indexes.isEmpty())
+        return;
+
+    QList<int> sortedIndexes = indexes;
+    qSort(sortedIndexes);
+
+    QStringList fileNames = nextFreeFileNames(sortedIndexes.count());
+
+    for (int i = 0; i < sortedIndexes.count(); i++)
+    {
+        Page page;
+        page.id = QUuid::createUuid();
+        page.fileName = fileNames.at(i);
+
+        mPages.insert(qBound(0, sortedIndexes.at(i), mPages.count()), page);
+    }
+
+    persist();
+}
+
+
+void UBPageManifest::reservePage(int index)
+{
+    if (index < mPages.count())
+        return;
+
+    while (mPages.count() <= index)
+    {
+        Page page;
+        page.id = QUuid::createUuid();
+        page.fileName = nextFreeFileName();
+
+        mPages.append(page);
+    }
+
+    persist();
+}
+
+
+void UBPageManifest::removePages(QList<int> indexes)
+{
+    qSort(indexes.begin(), indexes.end(), qGreater<int>());
+
+    int lastRemoved = -1;
+    foreach(int index, indexes)
+    {
+        if (index == lastRemoved || index < 0 || index >= mPages.count())
+            continue;
+
+        mPages.removeAt(index);
+        lastRemoved = index;
+    }
+
+    persist();
+}
+
+
+void UBPageManifest::movePage(int source, int target)
+{
+    if (source == target
+            || source < 0 || source >= mPages.count()
+            || target < 0 || target >= mPages.count())
+        return;
+
+    mPages.move(source, target);
+
+    persist();
+}
+
+
+bool UBPageManifest::persist()
+{
+    QDir().mkpath(mDocumentPath);
+
+    QSaveFile file(mDocumentPath + "/" + manifestFileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Cannot open" << file.fileName() << "for writing:" << file.errorString();
+        return false;
+    }
+
+    QXmlStreamWriter writer(&file);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement(tPages);
+    writer.writeAttribute(aVersion, vCurrentVersion);
+
+    foreach(const Page& page, mPages)
+    {
+        writer.writeStartElement(tPage);
+        writer.writeAttribute(aId, page.id.toString());
+        writer.writeAttribute(aFile, page.fileName);
+        writer.writeEndElement();
+    }
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    if (writer.hasError() || !file.commit())
+    {
+        qWarning() << "Cannot write page manifest" << file.fileName() << ":" << file.errorString();
+        return false;
+    }
+
+    mManifestStamp = manifestStamp();
+
+    return true;
+}
+
+
+// the modification time and size of pages.xml, or an empty string when there is none
+QString UBPageManifest::manifestStamp() const
+{
+    QFileInfo info(mDocumentPath + "/" + manifestFileName);
+
+    if (!info.exists())
+        return QString();
+
+    return QString("%1:%2").arg(info.lastModified().toMSecsSinceEpoch()).arg(info.size());
+}
+
+
+bool UBPageManifest::isOutdated() const
+{
+    return manifestStamp() != mManifestStamp;
+}
+
+
+void UBPageManifest::load()
+{
+    mPages.clear();
+    mManifestStamp = manifestStamp();
+
+    QFile file(mDocumentPath + "/" + manifestFileName);
+
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+    {
+        loadLegacyLayout();
+        return;
+    }
+
+    QXmlStreamReader reader(&file);
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (reader.isStartElement() && reader.name() == tPage)
+        {
+            Page page;
+            page.id = QUuid(reader.attributes().value(aId).toString());
+            page.fileName = reader.attributes().value(aFile).toString();
+
+            if (page.id.isNull())
+                page.id = QUuid::createUuid();
+
+            // an entry without its svg is left over from an interrupted page creation
+            if (!page.fileName.isEmpty() && QFile::exists(mDocumentPath + "/" + page.fileName + ".svg"))
+                mPages.append(page);
+        }
+    }
+
+    if (reader.hasError())
+    {
+        qWarning() << "Error reading page manifest" << file.fileName() << ":" << reader.errorString()
+                   << "- falling back to the numbered page files";
+        mPages.clear();
+        loadLegacyLayout();
+    }
+
+    file.close();
+}
+
+
+void UBPageManifest::loadLegacyLayout()
+{
+    int pageIndex = 0;
+
+    while (QFile::exists(mDocumentPath + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex)))
+    {
+        Page page;
+        page.id = QUuid::createUuid();
+        page.fileName = UBFileSystemUtils::digitFileFormat("page%1", pageIndex);
+
+        mPages.append(page);
+
+        pageIndex++;
+    }
+}
+
+
+QString UBPageManifest::nextFreeFileName() const
+{
+    return nextFreeFileNames(1).first();
+}
+
+
+QStringList UBPageManifest::nextFreeFileNames(int count) const
+{
+    QStringList fileNames;
+
+    QSet<QString> usedFileNames;
+    foreach(const Page& page, mPages)
+        usedFileNames.insert(page.fileName);
+
+    // reuse the lowest free numbers so that documents keep a page%1.svg layout whenever possible
+    for (int i = 0; fileNames.count() < count; i++)
+    {
+        QString fileName = UBFileSystemUtils::digitFileFormat("page%1", i);
+
+        if (!usedFileNames.contains(fileName)
+                && !QFile::exists(mDocumentPath + "/" + fileName + ".svg")
+                && !QFile::exists(mDocumentPath + "/" + fileName + ".thumbnail.jpg"))
+            fileNames << fileName;
+    }
+
+    return fileNames;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#ifndef UBPAGEMANIFEST_H_
+#define UBPAGEMANIFEST_H_
+
+#include <QtCore>
+
+/*
+ * Ordered list of the pages of a document.
+ *
+ * Each page has a stable identifier and a file name (without extension) that never changes once
+ * allocated; the svg and the thumbnail of a page live in <fileName>.svg and <fileName>.thumbnail.jpg.
+ * Reordering, inserting or deleting pages therefore only rewrites the manifest instead of renaming
+ * every following page file.
+ *
+ * Documents written by older versions have no manifest: their pages are read from the numbered
+ * page%1.svg files and the manifest is created the first time the page order changes.
+ *
+ * Manifests are cached per document path and reloaded when pages.xml changes on disk.
+ */
+class UBPageManifest
+{
+    public:
+
+        static const QString manifestFileName;
+
+        static UBPageManifest* manifest(const QString& documentPath);
+        static void forget(const QString& documentPath);
+
+        static QString svgFilePath(const QString& documentPath, int index);
+        static QString thumbnailFilePath(const QString& documentPath, int index);
+
+        int count() const;
+
+        QUuid pageId(int index) const;
+        int indexOf(const QUuid& pageId) const;
+        QString pageFileName(int index) const;
+
+        QString svgFilePath(int index) const;
+        QString thumbnailFilePath(int index) const;
+
+        void insertPage(int index);
+        void insertPages(const QList<int>& indexes);
+        void reservePage(int index);
+        void removePages(QList<int> indexes);
+        void movePage(int source, int target);
+
+        bool persist();
+
+    private:
+
+        UBPageManifest(const QString& documentPath);
+
+        void load();
+        void loadLegacyLayout();
+        QString manifestStamp() const;
+        bool isOutdated() const;
+        QString nextFreeFileName() const;
+        QStringList nextFreeFileNames(int count) const;
+
+        struct Page
+        {
+            QUuid id;
+            QString fileName;
+        };
+
+        QString mDocumentPath;
+        QList<Page> mPages;
+        QString mManifestStamp;
+
+        static QHash<QString, UBPageManifest*> sManifests;
+        static QMutex sManifestsMutex;
+};
+
+#endif /* UBPAGEMANIFEST_H_ */
@@ -42,6 +42,10 @@
 #include "core/UBSettings.h"
 #include "core/UBSetting.h"
 #include "core/UBForeignObjectsHandler.h"
+#include "core/UBPageManifest.h"
+#include "core/UBAssetManifest.h"
+#include "core/UBDocumentJournal.h"
+#include "core/UBTrace.h"
 
 #include "document/UBDocumentProxy.h"
 
@@ -164,6 +168,8 @@ void UBPersistenceManager::createDocumentProxiesStructure(const QFileInfoList &c
     {
         QString fullPath = path.absoluteFilePath();
 
+        UBDocumentJournal::recover(fullPath);
+
         QMap<QString, QVariant> metadatas = UBMetadataDcSubsetAdaptor::load(fullPath);
 
         QString docGroupName = metadatas.value(UBSettings::documentGroupName, QString()).toString();
@@ -422,6 +428,7 @@ UBDocumentProxy* UBPersistenceManager::createDocument(const QString& pGroupName
 {
     UBDocumentProxy *doc;
     if(directory.length() != 0 ){
+        forgetDocumentManifests(directory);
         doc = new UBDocumentProxy(directory); // deleted in UBPersistenceManager::destructor
         doc->setPageCount(pageCount);
     }
@@ -498,6 +505,9 @@ UBDocumentProxy* UBPersistenceManager::createDocumentFromDir(const QString& pDoc
 {
     checkIfDocumentRepositoryExists();
 
+    // the directory was just filled by an importer, possibly over an earlier document at that path
+    forgetDocumentManifests(pDocumentDirectory);
+
     UBDocumentProxy* doc = new UBDocumentProxy(pDocumentDirectory); // deleted in UBPersistenceManager::destructor
 
     if (pGroupName.length() > 0)
@@ -558,6 +568,8 @@ void UBPersistenceManager::deleteDocument(UBDocumentProxy* pDocumentProxy)
     if (QFileInfo(pDocumentProxy->persistencePath()).exists())
         UBFileSystemUtils::deleteDir(pDocumentProxy->persistencePath());
 
+    forgetDocumentManifests(pDocumentProxy->persistencePath());
+
     mSceneCache.removeAllScenes(pDocumentProxy);
 
     pDocumentProxy->deleteLater();
@@ -570,13 +582,33 @@ UBDocumentProxy* UBPersistenceManager::duplicateDocument(UBDocumentProxy* pDocum
     UBDocumentProxy *copy = new UBDocumentProxy(); // deleted in UBPersistenceManager::destructor
 
     generatePathIfNeeded(copy);
+    forgetDocumentManifests(copy->persistencePath());
+
+    QDir sourceDir(pDocumentProxy->persistencePath());
+    QDir().mkpath(copy->persistencePath());
+
+    foreach(QFileInfo entry, sourceDir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden, QDir::Name))
+    {
+        QString source = entry.absoluteFilePath();
+        QString target = copy->persistencePath() + "/" + entry.fileName();
+
+        if (entry.isFile() && UBDocumentJournal::isJournalFile(entry.fileName()))
+            continue;
 
-    UBFileSystemUtils::copyDir(pDocumentProxy->persistencePath(), copy->persistencePath());
+        // images, videos, audios, pdf and other files are never rewritten once added: the copy shares them.
+        // Pages, thumbnails, metadata and widgets (which store their state in place) are copied.
+        if (entry.isDir() && entry.fileName() != widgetDirectory && mDocumentSubDirectories.contains(entry.fileName()))
+            UBFileSystemUtils::shareOrCopyDir(source, target);
+        else if (entry.isDir())
+            UBFileSystemUtils::copyDir(source, target);
+        else
+            UBFileSystemUtils::copyFile(source, target);
+    }
 
     // regenerate scenes UUIDs
     for(int i = 0; i < pDocumentProxy->pageCount(); i++)
     {
-        UBSvgSubsetAdaptor::setSceneUuid(pDocumentProxy, i, QUuid::createUuid());
+        UBSvgSubsetAdaptor::setSceneUuid(copy, i, QUuid::createUuid());
     }
 
     foreach(QString key, pDocumentProxy->metaDatas().keys())
@@ -608,13 +640,8 @@ void UBPersistenceManager::deleteDocumentScenes(UBDocumentProxy* proxy, const QL
 
     int pageCount = UBPersistenceManager::persistenceManager()->sceneCount(proxy);
 
-    QList<int> compactedIndexes;
-
-    foreach(int index, indexes)
-    {
-        if (!compactedIndexes.contains(index))
-            compactedIndexes.append(index);
-    }
+    QList<int> compactedIndexes = indexes.toSet().toList();
+    qSort(compactedIndexes);
 
     if (compactedIndexes.size() == pageCount)
     {
@@ -625,97 +652,197 @@ void UBPersistenceManager::deleteDocumentScenes(UBDocumentProxy* proxy, const QL
     if (compactedIndexes.size() == 0)
         return;
 
-    foreach(int index, compactedIndexes)
-    {
-        emit documentSceneWillBeDeleted(proxy, index);
-    }
+    // listeners reload the whole document, once per operation is enough
+    emit documentSceneWillBeDeleted(proxy, compactedIndexes.first());
+
+    UBPageManifest *pages = UBPageManifest::manifest(proxy->persistencePath());
 
+    UBAssetManifest *assets = UBAssetManifest::manifest(proxy->persistencePath());
+
+    // the deleted pages are kept in a trash document, copied file by file instead of being loaded and saved again
     QString sourceName = proxy->metaData(UBSettings::documentName).toString();
     UBDocumentProxy *trashDocProxy = createDocument(UBSettings::trashedDocumentGroupNamePrefix/* + sourceGroupName*/, sourceName, false);
 
-    foreach(int index, compactedIndexes)
+    UBPageManifest *trashPages = UBPageManifest::manifest(trashDocProxy->persistencePath());
+    trashPages->reservePage(compactedIndexes.size() - 1);
+
+    UBAssetManifest *trashAssets = UBAssetManifest::manifest(trashDocProxy->persistencePath());
+
+    QSet<QString> copiedAssets;
+
+    for (int i = 0; i < compactedIndexes.size(); i++)
     {
-        UBGraphicsScene *scene = loadDocumentScene(proxy, index);
-        if (scene)
-        {
-            //scene is about to move into new document
-            foreach (QUrl relativeFile, scene->relativeDependencies())
-            {
-                QString source = scene->document()->persistencePath() + "/" + relativeFile.toString();
-                QString target = trashDocProxy->persistencePath() + "/" + relativeFile.toString();
+        int index = compactedIndexes.at(i);
 
-                QFileInfo fi(target);
-                QDir d = fi.dir();
+        UBGraphicsScene *cachedScene = mSceneCache.value(UBSceneCacheID(proxy, index));
+        if (cachedScene && (cachedScene->isModified() || cachedScene->hasThumbnailDamage()))
+            persistDocumentScene(proxy, cachedScene, index);
 
-                d.mkpath(d.absolutePath());
-                QFile::copy(source, target);
-            }
+        QFile::copy(pages->svgFilePath(index), trashPages->svgFilePath(i));
+        QFile::copy(pages->thumbnailFilePath(index), trashPages->thumbnailFilePath(i));
 
-            insertDocumentSceneAt(trashDocProxy, scene, trashDocProxy->pageCount());
-        }
-    }
+        QSet<QString> pageAssetSet = assets->pageAssets(pages->pageFileName(index));
+        trashAssets->setPageAssets(trashPages->pageFileName(i), pageAssetSet);
 
-    for (int i = 1; i < pageCount; i++)
-    {
-        renamePage(trashDocProxy, i , i - 1);
-    }
+        QStringList pageAssets = pageAssetSet.toList();
+        qSort(pageAssets);
 
-    foreach(int index, compactedIndexes)
-    {
-        QString svgFileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", index);
+        foreach (QString asset, pageAssets)
+        {
+            // a widget's objects are copied along with the widget directory
+            bool alreadyCopied = false;
+            for (QString parent = asset; !alreadyCopied && !parent.isEmpty(); parent = parent.section('/', 0, -2))
+                alreadyCopied = copiedAssets.contains(parent);
 
-        QFile::remove(svgFileName);
+            if (alreadyCopied)
+                continue;
 
-        QString thumbFileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", index);
+            QString source = proxy->persistencePath() + "/" + asset;
+            QString target = trashDocProxy->persistencePath() + "/" + asset;
 
-        QFile::remove(thumbFileName);
+            if (QFileInfo(source).isDir())
+            {
+                UBFileSystemUtils::copyDir(source, target);
+            }
+            else
+            {
+                QDir().mkpath(QFileInfo(target).absolutePath());
+                UBFileSystemUtils::shareOrCopyFile(source, target);
+            }
 
-        mSceneCache.removeScene(proxy, index);
+            copiedAssets.insert(asset);
+        }
+    }
 
-        proxy->decPageCount();
+    trashDocProxy->setPageCount(compactedIndexes.size());
+    UBMetadataDcSubsetAdaptor::persist(trashDocProxy);
 
+    QStringList removedFiles;
+    QStringList removedPages;
+    foreach(int index, compactedIndexes)
+    {
+        removedFiles << pages->svgFilePath(index);
+        removedFiles << pages->thumbnailFilePath(index);
+        removedPages << pages->pageFileName(index);
     }
 
-    qSort(compactedIndexes);
+    // the manifest is updated first so that an interruption only leaves unreferenced files behind
+    pages->removePages(compactedIndexes);
+    assets->removePages(removedPages);
 
-    int offset = 1;
+    foreach(QString fileName, removedFiles)
+    {
+        QFile::remove(fileName);
+    }
 
-    for (int i = compactedIndexes.at(0) + 1; i < pageCount; i++)
+    // the following pages move up by the number of deleted pages before them
+    QVector<int> newIndexes(pageCount);
+    int deletedCount = 0;
+    for (int i = 0; i < pageCount; i++)
     {
-        if(compactedIndexes.contains(i))
+        if (deletedCount < compactedIndexes.size() && compactedIndexes.at(deletedCount) == i)
         {
-            offset++;
+            mSceneCache.removeScene(proxy, i);
+            newIndexes[i] = -1;
+            deletedCount++;
         }
         else
         {
-            renamePage(proxy, i , i - offset);
-
-            mSceneCache.moveScene(proxy, i, i - offset);
-
+            newIndexes[i] = i - deletedCount;
         }
     }
+
+    mSceneCache.remapScenes(proxy, newIndexes);
+
+    proxy->setPageCount(proxy->pageCount() - compactedIndexes.size());
+
+    forgetDocumentItemCount(proxy);
 }
 
 
 void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int index)
+{
+    duplicateDocumentScenes(proxy, QList<int>() << index);
+}
+
+
+// inserts a copy of each page right after it, in one pass over the page order, the cache and the thumbnails
+void UBPersistenceManager::duplicateDocumentScenes(UBDocumentProxy* proxy, const QList<int>& indexes)
 {
     checkIfDocumentRepositoryExists();
 
     int pageCount = UBPersistenceManager::persistenceManager()->sceneCount(proxy);
 
-    for (int i = pageCount; i > index + 1; i--)
+    QList<int> sourceIndexes = indexes.toSet().toList();
+    qSort(sourceIndexes);
+
+    if (sourceIndexes.isEmpty())
+        return;
+
+    // the copies are made from the files on disk, which must hold the pages as they are shown
+    foreach (int sourceIndex, sourceIndexes)
+    {
+        UBGraphicsScene *cachedScene = mSceneCache.value(UBSceneCacheID(proxy, sourceIndex));
+        if (cachedScene && (cachedScene->isModified() || cachedScene->hasThumbnailDamage()))
+            persistDocumentScene(proxy, cachedScene, sourceIndex);
+    }
+
+    // every page moves down by the number of copies inserted before it
+    QVector<int> newIndexes(pageCount);
+    QList<int> copyIndexes;
+    int copiesBefore = 0;
+    for (int i = 0; i < pageCount; i++)
+    {
+        newIndexes[i] = i + copiesBefore;
+
+        if (copiesBefore < sourceIndexes.size() && sourceIndexes.at(copiesBefore) == i)
+        {
+            copyIndexes << newIndexes[i] + 1;
+            copiesBefore++;
+        }
+    }
+
+    mSceneCache.remapScenes(proxy, newIndexes);
+
+    // new entries whose svg is not written yet are dropped when the manifest is loaded again after an interruption
+    UBPageManifest *pages = UBPageManifest::manifest(proxy->persistencePath());
+    pages->insertPages(copyIndexes);
+    forgetDocumentItemCount(proxy);
+
+    UBAssetManifest *assets = UBAssetManifest::manifest(proxy->persistencePath());
+
+    foreach (int copyIndex, copyIndexes)
     {
-        renamePage(proxy, i - 1 , i);
+        int sourceIndex = copyIndex - 1;
 
-        mSceneCache.moveScene(proxy, i - 1, i);
+        QFile::copy(pages->svgFilePath(sourceIndex), pages->svgFilePath(copyIndex));
+        UBSvgSubsetAdaptor::setSceneUuid(proxy, copyIndex, QUuid::createUuid());
+        QFile::copy(pages->thumbnailFilePath(sourceIndex), pages->thumbnailFilePath(copyIndex));
+
+        proxy->incPageCount();
+
+        // only pages using media, widgets or images need their own copies of the files, and thus a reload
+        if (assets->pageAssets(pages->pageFileName(sourceIndex)).isEmpty())
+            continue;
 
+        //TODO: write a proper way to handle object on disk
+        UBGraphicsScene *scene = loadDocumentScene(proxy, copyIndex);
+        if (!scene)
+            continue;
+
+        duplicateSceneAssets(proxy, scene);
+
+        scene->setModified(true);
+
+        persistDocumentScene(proxy, scene, copyIndex);
     }
 
-    copyPage(proxy, index , index + 1);
+    emit documentSceneCreated(proxy, copyIndexes.first());
+}
 
-    //TODO: write a proper way to handle object on disk
-    UBGraphicsScene *scene = loadDocumentScene(proxy, index + 1);
 
+void UBPersistenceManager::duplicateSceneAssets(UBDocumentProxy* proxy, UBGraphicsScene* scene)
+{
     foreach(QGraphicsItem* item, scene->items())
     {
         UBGraphicsMediaItem *mediaItem = qgraphicsitem_cast<UBGraphicsMediaItem*> (item);
@@ -726,7 +853,7 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
             QUuid newUuid = QUuid::createUuid();
             QString fileName = QFileInfo(source).completeBaseName();
             destination = destination.replace(fileName,newUuid.toString());
-            QFile::copy(source,destination);
+            UBFileSystemUtils::shareOrCopyFile(source, destination);
             mediaItem->setMediaFileUrl(QUrl::fromLocalFile(destination));
             continue;
         }
@@ -762,7 +889,7 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
             QUuid newUuid = QUuid::createUuid();
             QString fileName = QFileInfo(source).completeBaseName();
             destination = destination.replace(fileName,newUuid.toString());
-            QFile::copy(source,destination);
+            UBFileSystemUtils::shareOrCopyFile(source, destination);
             pixmapItem->setUuid(newUuid);
             continue;
         }
@@ -774,64 +901,80 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
             QUuid newUuid = QUuid::createUuid();
             QString fileName = QFileInfo(source).completeBaseName();
             destination = destination.replace(fileName,newUuid.toString());
-            QFile::copy(source,destination);
+            UBFileSystemUtils::shareOrCopyFile(source, destination);
             svgItem->setUuid(newUuid);
             continue;
         }
 
     }
-    scene->setModified(true);
+}
 
-    proxy->incPageCount();
 
-    persistDocumentScene(proxy,scene, index + 1);
+void UBPersistenceManager::copyDocumentScene(UBDocumentProxy *from, int fromIndex, UBDocumentProxy *to, int toIndex)
+{
+    copyDocumentScenes(from, QList<int>() << fromIndex, to, toIndex);
 
-    emit documentSceneCreated(proxy, index + 1);
+    UBDocumentController *ctrl = UBApplication::documentController;
+    if (ctrl->selectedDocument() == to)
+        ctrl->addPixmapAt(new QPixmap(UBPageManifest::thumbnailFilePath(to->persistencePath(), toIndex)), toIndex);
+    ctrl->TreeViewSelectionChanged(ctrl->firstSelectedTreeIndex(), QModelIndex());
 }
 
-void UBPersistenceManager::copyDocumentScene(UBDocumentProxy *from, int fromIndex, UBDocumentProxy *to, int toIndex)
+
+// copies the pages in order to toIndex and the following indexes; the caller refreshes the views once
+void UBPersistenceManager::copyDocumentScenes(UBDocumentProxy *from, const QList<int>& fromIndexes, UBDocumentProxy *to, int toIndex)
 {
-    if (from == to && toIndex <= fromIndex) {
+    if (fromIndexes.isEmpty())
+        return;
+
+    if (from == to && toIndex <= fromIndexes.last()) {
         qDebug() << "operation is not supported" << Q_FUNC_INFO;
         return;
     }
 
     checkIfDocumentRepositoryExists();
 
-    for (int i = to->pageCount(); i > toIndex; i--) {
-        renamePage(to, i - 1, i);
-        mSceneCache.moveScene(to, i - 1, i);
-    }
+    int pageCount = to->pageCount();
 
-    UBForeighnObjectsHandler hl;
-    hl.copyPage(QUrl::fromLocalFile(from->persistencePath()), fromIndex,
-                QUrl::fromLocalFile(to->persistencePath()), toIndex);
+    QVector<int> newIndexes(pageCount);
+    for (int i = 0; i < pageCount; i++)
+        newIndexes[i] = i < toIndex ? i : i + fromIndexes.size();
 
-    to->incPageCount();
+    mSceneCache.remapScenes(to, newIndexes);
 
-    QString thumbTmp(from->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", fromIndex));
-    QString thumbTo(to->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", toIndex));
+    QList<int> targetIndexes;
+    for (int i = 0; i < fromIndexes.size(); i++)
+        targetIndexes << toIndex + i;
 
-    QFile::remove(thumbTo);
-    QFile::copy(thumbTmp, thumbTo);
+    UBPageManifest::manifest(to->persistencePath())->insertPages(targetIndexes);
+    forgetDocumentItemCount(to);
 
-    Q_ASSERT(QFileInfo(thumbTmp).exists());
-    Q_ASSERT(QFileInfo(thumbTo).exists());
-    const QPixmap *pix = new QPixmap(thumbTmp);
-    UBDocumentController *ctrl = UBApplication::documentController;
-    ctrl->addPixmapAt(pix, toIndex);
-    ctrl->TreeViewSelectionChanged(ctrl->firstSelectedTreeIndex(), QModelIndex());
+    UBForeighnObjectsHandler hl;
+
+    for (int i = 0; i < fromIndexes.size(); i++)
+    {
+        hl.copyPage(QUrl::fromLocalFile(from->persistencePath()), fromIndexes.at(i),
+                    QUrl::fromLocalFile(to->persistencePath()), targetIndexes.at(i));
 
-//    emit documentSceneCreated(to, toIndex + 1);
+        to->incPageCount();
+
+        QString thumbTmp(UBPageManifest::thumbnailFilePath(from->persistencePath(), fromIndexes.at(i)));
+        QString thumbTo(UBPageManifest::thumbnailFilePath(to->persistencePath(), targetIndexes.at(i)));
+
+        QFile::remove(thumbTo);
+        QFile::copy(thumbTmp, thumbTo);
+    }
 }
 
 
 UBGraphicsScene* UBPersistenceManager::createDocumentSceneAt(UBDocumentProxy* proxy, int index, bool useUndoRedoStack)
 {
+    generatePathIfNeeded(proxy);
+
     int count = sceneCount(proxy);
 
-    for(int i = count - 1; i >= index; i--)
-        renamePage(proxy, i , i + 1);
+    UBPageManifest::manifest(proxy->persistencePath())->insertPage(index);
+    forgetDocumentItemCount(proxy);
 
     mSceneCache.shiftUpScenes(proxy, index, count -1);
 
@@ -856,12 +999,12 @@ void UBPersistenceManager::insertDocumentSceneAt(UBDocumentProxy* proxy, UBGraph
 {
     scene->setDocument(proxy);
 
+    generatePathIfNeeded(proxy);
+
     int count = sceneCount(proxy);
 
-    for(int i = count - 1; i >= index; i--)
-    {
-        renamePage(proxy, i , i + 1);
-    }
+    UBPageManifest::manifest(proxy->persistencePath())->insertPage(index);
+    forgetDocumentItemCount(proxy);
 
     mSceneCache.shiftUpScenes(proxy, index, count -1);
 
@@ -878,39 +1021,71 @@ void UBPersistenceManager::insertDocumentSceneAt(UBDocumentProxy* proxy, UBGraph
 }
 
 
-void UBPersistenceManager::moveSceneToIndex(UBDocumentProxy* proxy, int source, int target)
+// writes the pages of an imported pdf straight from the pdf, without building their scenes; the
+// pdf page n has the size pdfPageSizes[n - 1]. Returns the pdf page numbers written, in order from index.
+QList<int> UBPersistenceManager::insertDocumentPdfPagesAt(UBDocumentProxy* proxy, int index, const QUuid& pdfFileUuid, const QList<QSizeF>& pdfPageSizes)
 {
-    checkIfDocumentRepositoryExists();
+    QList<int> writtenPages;
 
-    if (source == target)
-        return;
+    if (pdfPageSizes.isEmpty())
+        return writtenPages;
+
+    generatePathIfNeeded(proxy);
+
+    int pageCount = sceneCount(proxy);
 
-    QFile svgTmp(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", source));
-    svgTmp.rename(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.tmp", target));
+    QList<int> targetIndexes;
+    for (int i = 0; i < pdfPageSizes.size(); i++)
+        targetIndexes << index + i;
 
-    QFile thumbTmp(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", source));
-    thumbTmp.rename(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.tmp", target));
+    // new entries whose svg is not written yet are dropped when the manifest is loaded again after an interruption
+    UBPageManifest* pages = UBPageManifest::manifest(proxy->persistencePath());
+    pages->insertPages(targetIndexes);
+    forgetDocumentItemCount(proxy);
 
-    if (source < target)
+    QList<int> failedIndexes;
+
+    for (int i = 0; i < pdfPageSizes.size(); i++)
     {
-        for (int i = source + 1; i <= target; i++)
+        if (UBSvgSubsetAdaptor::persistPdfPage(proxy, targetIndexes.at(i), pdfFileUuid, i + 1, pdfPageSizes.at(i)))
         {
-            renamePage(proxy, i , i - 1);
+            writtenPages << i + 1;
         }
-    }
-    else
-    {
-        for (int i = source - 1; i >= target; i--)
+        else
         {
-            renamePage(proxy, i , i + 1);
+            qWarning() << "cannot write imported pdf page" << i + 1 << "in" << proxy->persistencePath();
+            failedIndexes << targetIndexes.at(i);
         }
     }
 
-    QFile svg(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.tmp", target));
-    svg.rename(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", target));
+    if (!failedIndexes.isEmpty())
+        pages->removePages(failedIndexes);
 
-    QFile thumb(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.tmp", target));
-    thumb.rename(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", target));
+    QVector<int> newIndexes(pageCount);
+    for (int i = 0; i < pageCount; i++)
+        newIndexes[i] = i < index ? i : i + writtenPages.size();
+
+    mSceneCache.remapScenes(proxy, newIndexes);
+
+    for (int i = 0; i < writtenPages.size(); i++)
+    {
+        proxy->incPageCount();
+        emit documentSceneCreated(proxy, index + i);
+    }
+
+    return writtenPages;
+}
+
+
+void UBPersistenceManager::moveSceneToIndex(UBDocumentProxy* proxy, int source, int target)
+{
+    checkIfDocumentRepositoryExists();
+
+    if (source == target)
+        return;
+
+    UBPageManifest::manifest(proxy->persistencePath())->movePage(source, target);
+    forgetDocumentItemCount(proxy);
 
     mSceneCache.moveScene(proxy, source, target);
 }
@@ -918,6 +1093,8 @@ void UBPersistenceManager::moveSceneToIndex(UBDocumentProxy* proxy, int source,
 
 UBGraphicsScene* UBPersistenceManager::loadDocumentScene(UBDocumentProxy* proxy, int sceneIndex)
 {
+    UB_TRACE_SCOPE("UBPersistenceManager::loadDocumentScene");
+
     if (mSceneCache.contains(proxy, sceneIndex))
         return mSceneCache.value(proxy, sceneIndex);
     else {
@@ -939,8 +1116,10 @@ void UBPersistenceManager::reassignDocProxy(UBDocumentProxy *newDocument, UBDocu
     return mSceneCache.reassignDocProxy(newDocument, oldDocument);
 }
 
-void UBPersistenceManager::persistDocumentScene(UBDocumentProxy* pDocumentProxy, UBGraphicsScene* pScene, const int pSceneIndex)
+void UBPersistenceManager::persistDocumentScene(UBDocumentProxy* pDocumentProxy, UBGraphicsScene* pScene, const int pSceneIndex, bool isAnAutomaticBackup)
 {
+    UB_TRACE_SCOPE("UBPersistenceManager::persistDocumentScene");
+
     checkIfDocumentRepositoryExists();
 
     pScene->deselectAllItems();
@@ -950,17 +1129,35 @@ void UBPersistenceManager::persistDocumentScene(UBDocumentProxy* pDocumentProxy,
     QDir dir(pDocumentProxy->persistencePath());
     dir.mkpath(pDocumentProxy->persistencePath());
 
+    UBPageManifest::manifest(pDocumentProxy->persistencePath())->reservePage(pSceneIndex);
+
+    // metadata, page and thumbnail are replaced together or not at all
+    UBDocumentJournal journal(pDocumentProxy->persistencePath());
+
+    // lets purgeEmptyDocuments tell whether a single page document is empty without loading its page
+    if (pDocumentProxy->pageCount() > 1)
+    {
+        forgetDocumentItemCount(pDocumentProxy);
+    }
+    else if (pSceneIndex == 0)
+    {
+        pDocumentProxy->setMetaData(UBSettings::documentItemCountPage, UBPageManifest::manifest(pDocumentProxy->persistencePath())->pageFileName(0));
+        pDocumentProxy->setMetaData(UBSettings::documentItemCount, pScene->itemCount());
+    }
+
     if (pDocumentProxy->isModified())
-        UBMetadataDcSubsetAdaptor::persist(pDocumentProxy);
+        UBMetadataDcSubsetAdaptor::persist(pDocumentProxy, &journal);
 
     if (pScene->isModified())
-    {
-        UBSvgSubsetAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex);
+        UBSvgSubsetAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex, &journal);
 
-        UBThumbnailAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex);
+    // autosaves leave the thumbnail alone until the changes would show in it, any other save
+    // catches up with the changes it was left behind by, even once the page itself is saved
+    if (pScene->hasThumbnailDamage() && (!isAnAutomaticBackup || UBThumbnailAdaptor::hasVisibleChanges(pScene)))
+        UBThumbnailAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex, true, &journal);
 
+    if (journal.commit())
         pScene->setModified(false);
-    }
 
     mSceneCache.insert(pDocumentProxy, pSceneIndex, pScene);
 }
@@ -968,6 +1165,8 @@ void UBPersistenceManager::persistDocumentScene(UBDocumentProxy* pDocumentProxy,
 
 UBDocumentProxy* UBPersistenceManager::persistDocumentMetadata(UBDocumentProxy* pDocumentProxy)
 {
+    UB_TRACE_SCOPE("UBPersistenceManager::persistDocumentMetadata");
+
     UBMetadataDcSubsetAdaptor::persist(pDocumentProxy);
 
     emit documentMetadataChanged(pDocumentProxy);
@@ -976,65 +1175,12 @@ UBDocumentProxy* UBPersistenceManager::persistDocumentMetadata(UBDocumentProxy*
 }
 
 
-void UBPersistenceManager::renamePage(UBDocumentProxy* pDocumentProxy, const int sourceIndex, const int targetIndex)
-{
-    QFile svg(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", sourceIndex));
-    svg.rename(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg",  targetIndex));
-
-    QFile thumb(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", sourceIndex));
-    thumb.rename(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", targetIndex));
-}
-
-
-void UBPersistenceManager::copyPage(UBDocumentProxy* pDocumentProxy, const int sourceIndex, const int targetIndex)
-{
-    QFile svg(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg",sourceIndex));
-    svg.copy(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", targetIndex));
-
-    UBSvgSubsetAdaptor::setSceneUuid(pDocumentProxy, targetIndex, QUuid::createUuid());
-
-    QFile thumb(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", sourceIndex));
-    thumb.copy(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", targetIndex));
-}
-
-
 int UBPersistenceManager::sceneCount(const UBDocumentProxy* proxy)
 {
-    const QString pPath = proxy->persistencePath();
-
-    int pageIndex = 0;
-    bool moreToProcess = true;
-    bool addedMissingZeroPage = false;
-
-    while (moreToProcess)
-    {
-        QString fileName = pPath + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
-
-        QFile file(fileName);
-
-        if (file.exists())
-        {
-            pageIndex++;
-        }
-        else
-        {
-            moreToProcess = false;
-        }
-    }
-
-    if(pageIndex == 1 && addedMissingZeroPage){
-        // increment is done only to check if there are other pages than the missing zero page
-        // This situation means -> no pages on the document
+    if (proxy->persistencePath().isEmpty())
         return 0;
-    }
-
-    return pageIndex;
-}
 
-QStringList UBPersistenceManager::getSceneFileNames(const QString& folder)
-{
-    QDir dir(folder, "page???.svg", QDir::Name, QDir::Files);
-    return dir.entryList();
+    return UBPageManifest::manifest(proxy->persistencePath())->count();
 }
 
 QString UBPersistenceManager::generateUniqueDocumentPath(const QString& baseFolder)
@@ -1056,33 +1202,51 @@ void UBPersistenceManager::generatePathIfNeeded(UBDocumentProxy* pDocumentProxy)
     if (pDocumentProxy->persistencePath().length() == 0)
     {
         pDocumentProxy->setPersistencePath(generateUniqueDocumentPath());
+        forgetDocumentManifests(pDocumentProxy->persistencePath());
     }
 }
 
 
+// drops the cached manifests of a document directory that is created, replaced or removed
+void UBPersistenceManager::forgetDocumentManifests(const QString& documentPath)
+{
+    UBPageManifest::forget(documentPath);
+    UBAssetManifest::forget(documentPath);
+}
+
+
 bool UBPersistenceManager::addDirectoryContentToDocument(const QString& documentRootFolder, UBDocumentProxy* pDocument)
 {
-    QStringList sourceScenes = getSceneFileNames(documentRootFolder);
-    if (sourceScenes.empty())
+    // the folder may reuse the path of an earlier import
+    forgetDocumentManifests(documentRootFolder);
+
+    UBPageManifest *sourcePages = UBPageManifest::manifest(documentRootFolder);
+    int sourcePageCount = sourcePages->count();
+    if (sourcePageCount == 0)
         return false;
 
     int targetPageCount = pDocument->pageCount();
 
-    for(int sourceIndex = 0 ; sourceIndex < sourceScenes.size(); sourceIndex++)
+    UBPageManifest *targetPages = UBPageManifest::manifest(pDocument->persistencePath());
+    targetPages->reservePage(targetPageCount + sourcePageCount - 1);
+
+    for(int sourceIndex = 0 ; sourceIndex < sourcePageCount; sourceIndex++)
     {
         int targetIndex = targetPageCount + sourceIndex;
 
-        QFile svg(documentRootFolder + "/" + sourceScenes[sourceIndex]);
-        if (!svg.copy(pDocument->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", targetIndex)))
+        QFile svg(sourcePages->svgFilePath(sourceIndex));
+        if (!svg.copy(targetPages->svgFilePath(targetIndex)))
             return false;
 
         UBSvgSubsetAdaptor::setSceneUuid(pDocument, targetIndex, QUuid::createUuid());
 
-        QFile thumb(documentRootFolder + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", sourceIndex));
+        QFile thumb(sourcePages->thumbnailFilePath(sourceIndex));
         // We can ignore error in this case, thumbnail will be genarated
-        thumb.copy(pDocument->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", targetIndex));
+        thumb.copy(targetPages->thumbnailFilePath(targetIndex));
     }
 
+    forgetDocumentManifests(documentRootFolder);
+
     foreach(QString dir, mDocumentSubDirectories)
     {
         qDebug() << "copying " << documentRootFolder << "/" << dir << " to " << pDocument->persistencePath() << "/" + dir;
@@ -1094,12 +1258,20 @@ bool UBPersistenceManager::addDirectoryContentToDocument(const QString& document
     }
 
     pDocument->setPageCount(sceneCount(pDocument));
+    forgetDocumentItemCount(pDocument);
 
     //issue NC - NNE - 20131213 : At this point, all is well done.
     return true;
 }
 
 
+// the item count recorded when the document had a single page says nothing once its pages change
+void UBPersistenceManager::forgetDocumentItemCount(UBDocumentProxy* pDocumentProxy)
+{
+    pDocumentProxy->setMetaData(UBSettings::documentItemCountPage, QString());
+}
+
+
 bool UBPersistenceManager::isEmpty(UBDocumentProxy* pDocumentProxy)
 {
     if(!pDocumentProxy)
@@ -1108,21 +1280,13 @@ bool UBPersistenceManager::isEmpty(UBDocumentProxy* pDocumentProxy)
     if (pDocumentProxy->pageCount() > 1)
         return false;
 
-    UBGraphicsScene *theSoleScene = UBSvgSubsetAdaptor::loadScene(pDocumentProxy, 0);
-
-    bool empty = false;
+    // the item count saved with the metadata is only trusted for the page it was recorded for
+    QString pageFileName = UBPageManifest::manifest(pDocumentProxy->persistencePath())->pageFileName(0);
 
-    if (theSoleScene)
-    {
-        empty = theSoleScene->isEmpty();
-        delete theSoleScene;
-    }
-    else
-    {
-        empty = true;
-    }
+    if (pDocumentProxy->metaData(UBSettings::documentItemCountPage).toString() == pageFileName)
+        return pDocumentProxy->metaData(UBSettings::documentItemCount).toInt() == 0;
 
-    return empty;
+    return !UBSvgSubsetAdaptor::hasContent(pDocumentProxy, 0);
 }
 
 
@@ -1144,6 +1308,26 @@ void UBPersistenceManager::purgeEmptyDocuments()
     }
 }
 
+
+void UBPersistenceManager::cleanDocumentAssets(UBDocumentProxy* pDocumentProxy)
+{
+    UB_TRACE_SCOPE("UBPersistenceManager::cleanDocumentAssets");
+
+    if (!pDocumentProxy || !QDir(pDocumentProxy->persistencePath()).exists())
+        return;
+
+    // the asset manifest only knows saved pages, files added since the last save must not be taken for unused ones
+    for (int i = 0; i < pDocumentProxy->pageCount(); i++)
+    {
+        UBGraphicsScene *cachedScene = mSceneCache.value(UBSceneCacheID(pDocumentProxy, i));
+        if (cachedScene && cachedScene->isModified())
+            persistDocumentScene(pDocumentProxy, cachedScene, i);
+    }
+
+    UBForeighnObjectsHandler cleaner;
+    cleaner.cure(QUrl::fromLocalFile(pDocumentProxy->persistencePath()));
+}
+
 bool UBPersistenceManager::addFileToDocument(UBDocumentProxy* pDocumentProxy,
                                                      QString path,
                                                      const QString& subdir,
@@ -1179,19 +1363,7 @@ bool UBPersistenceManager::addFileToDocument(UBDocumentProxy* pDocumentProxy,
         }
         else
         {
-            QFile newFile(destinationPath);
-
-            if (newFile.open(QIODevice::WriteOnly))
-            {
-                qint64 n = newFile.write(*data);
-                newFile.flush();
-                newFile.close();
-                return n == data->size();
-            }
-            else
-            {
-                return false;
-            }
+            return UBDocumentJournal::writeFile(destinationPath, *data);
         }
     }
     else
@@ -1289,43 +1461,27 @@ void UBPersistenceManager::loadFolderTreeFromXml(const QString &path, const QDom
 
 bool UBPersistenceManager::mayHaveVideo(UBDocumentProxy* pDocumentProxy)
 {
-    QDir videoDir(pDocumentProxy->persistencePath() + "/" + UBPersistenceManager::videoDirectory);
-
-    return videoDir.exists() && videoDir.entryInfoList().length() > 0;
+    return UBAssetManifest::manifest(pDocumentProxy->persistencePath())->hasReferenceIn(UBPersistenceManager::videoDirectory);
 }
 
 bool UBPersistenceManager::mayHaveAudio(UBDocumentProxy* pDocumentProxy)
 {
-    QDir audioDir(pDocumentProxy->persistencePath() + "/" + UBPersistenceManager::audioDirectory);
-
-    return audioDir.exists() && audioDir.entryInfoList().length() > 0;
+    return UBAssetManifest::manifest(pDocumentProxy->persistencePath())->hasReferenceIn(UBPersistenceManager::audioDirectory);
 }
 
 bool UBPersistenceManager::mayHavePDF(UBDocumentProxy* pDocumentProxy)
 {
-    QDir objectDir(pDocumentProxy->persistencePath() + "/" + UBPersistenceManager::objectDirectory);
-
-    QStringList filters;
-    filters << "*.pdf";
-
-    return objectDir.exists() && objectDir.entryInfoList(filters).length() > 0;
+    return UBAssetManifest::manifest(pDocumentProxy->persistencePath())->hasReferenceIn(UBPersistenceManager::objectDirectory, ".pdf");
 }
 
 
 bool UBPersistenceManager::mayHaveSVGImages(UBDocumentProxy* pDocumentProxy)
 {
-    QDir imageDir(pDocumentProxy->persistencePath() + "/" + UBPersistenceManager::imageDirectory);
-
-    QStringList filters;
-    filters << "*.svg";
-
-    return imageDir.exists() && imageDir.entryInfoList(filters).length() > 0;
+    return UBAssetManifest::manifest(pDocumentProxy->persistencePath())->hasReferenceIn(UBPersistenceManager::imageDirectory, ".svg");
 }
 
 
 bool UBPersistenceManager::mayHaveWidget(UBDocumentProxy* pDocumentProxy)
 {
-    QDir widgetDir(pDocumentProxy->persistencePath() + "/" + UBPersistenceManager::widgetDirectory);
-
-    return widgetDir.exists() && widgetDir.entryInfoList(QDir::Dirs).length() > 0;
+    return UBAssetManifest::manifest(pDocumentProxy->persistencePath())->hasReferenceIn(UBPersistenceManager::widgetDirectory);
 }
@@ -101,15 +101,21 @@ class UBPersistenceManager : public QObject
 
         virtual void duplicateDocumentScene(UBDocumentProxy* pDocumentProxy, int index);
 
+        virtual void duplicateDocumentScenes(UBDocumentProxy* pDocumentProxy, const QList<int>& indexes);
+
         virtual void copyDocumentScene(UBDocumentProxy *from, int fromIndex, UBDocumentProxy *to, int toIndex);
 
+        virtual void copyDocumentScenes(UBDocumentProxy *from, const QList<int>& fromIndexes, UBDocumentProxy *to, int toIndex);
+
         virtual void persistDocumentScene(UBDocumentProxy* pDocumentProxy,
-                UBGraphicsScene* pScene, const int pSceneIndex);
+                UBGraphicsScene* pScene, const int pSceneIndex, bool isAnAutomaticBackup = false);
 
         virtual UBGraphicsScene* createDocumentSceneAt(UBDocumentProxy* pDocumentProxy, int index, bool useUndoRedoStack = true);
 
         virtual void insertDocumentSceneAt(UBDocumentProxy* pDocumentProxy, UBGraphicsScene* scene, int index, bool persist = true);
 
+        virtual QList<int> insertDocumentPdfPagesAt(UBDocumentProxy* pDocumentProxy, int index, const QUuid& pdfFileUuid, const QList<QSizeF>& pdfPageSizes);
+
         virtual void moveSceneToIndex(UBDocumentProxy* pDocumentProxy, int source, int target);
 
         virtual UBGraphicsScene* loadDocumentScene(UBDocumentProxy* pDocumentProxy, int sceneIndex);
@@ -142,6 +148,7 @@ class UBPersistenceManager : public QObject
 
         virtual bool isEmpty(UBDocumentProxy* pDocumentProxy);
         virtual void purgeEmptyDocuments();
+        virtual void cleanDocumentAssets(UBDocumentProxy* pDocumentProxy);
 
         bool addGraphicsWidgetToDocument(UBDocumentProxy *mDocumentProxy, QString path, QUuid objectUuid, QString& destinationPath);
         bool addFileToDocument(UBDocumentProxy* pDocumentProxy, QString path, const QString& subdir,  QUuid objectUuid, QString& destinationPath, QByteArray* data = NULL);
@@ -170,12 +177,10 @@ class UBPersistenceManager : public QObject
 
 private:
         int sceneCount(const UBDocumentProxy* pDocumentProxy);
-        static QStringList getSceneFileNames(const QString& folder);
-        void renamePage(UBDocumentProxy* pDocumentProxy,
-                        const int sourceIndex, const int targetIndex);
-        void copyPage(UBDocumentProxy* pDocumentProxy,
-                      const int sourceIndex, const int targetIndex);
+        void duplicateSceneAssets(UBDocumentProxy* pDocumentProxy, UBGraphicsScene* pScene);
         void generatePathIfNeeded(UBDocumentProxy* pDocumentProxy);
+        void forgetDocumentManifests(const QString& documentPath);
+        void forgetDocumentItemCount(UBDocumentProxy* pDocumentProxy);
         void checkIfDocumentRepositoryExists();
 
         void saveFoldersTreeToXml(QXmlStreamWriter &writer, const QModelIndex &parentIndex);
@@ -227,6 +227,36 @@ void UBSceneCache::shiftUpScenes(UBDocumentProxy* proxy, int startIncIndex, int
 }
 
 
+// moves the cached scenes of a document to newIndexes[oldIndex] in one pass, -1 drops the scene from the cache
+void UBSceneCache::remapScenes(UBDocumentProxy* proxy, const QVector<int>& newIndexes)
+{
+    QList<QPair<int, UBGraphicsScene*> > remappedScenes;
+
+    foreach(UBSceneCacheID key, keys())
+    {
+        if (key.documentProxy != proxy)
+            continue;
+
+        UBGraphicsScene* scene = QHash<UBSceneCacheID, UBGraphicsScene*>::take(key);
+        mCachedKeyFIFO.removeAll(key);
+
+        int newIndex = key.pageIndex < newIndexes.size() ? newIndexes.at(key.pageIndex) : key.pageIndex;
+
+        if (newIndex >= 0)
+            remappedScenes << qMakePair(newIndex, scene);
+        else
+            mCachedSceneCount--;
+    }
+
+    for (int i = 0; i < remappedScenes.size(); i++)
+    {
+        UBSceneCacheID targetKey(proxy, remappedScenes.at(i).first);
+        QHash<UBSceneCacheID, UBGraphicsScene*>::insert(targetKey, remappedScenes.at(i).second);
+        mCachedKeyFIFO.enqueue(targetKey);
+    }
+}
+
+
 void UBSceneCache::internalMoveScene(UBDocumentProxy* proxy, int sourceIndex, int targetIndex)
 {
     UBSceneCacheID sourceKey(proxy, sourceIndex);
@@ -102,6 +102,8 @@ class UBSceneCache : public QHash<UBSceneCacheID, UBGraphicsScene*>
 
         void shiftUpScenes(UBDocumentProxy* proxy, int startIncIndex, int endIncIndex);
 
+        void remapScenes(UBDocumentProxy* proxy, const QVector<int>& newIndexes);
+
 
     private:
 
@@ -37,6 +37,9 @@
 
 UBSetting::UBSetting(UBSettings* parent) :
     QObject(parent)
+    , mBoolValue(false)
+    , mIntValue(0)
+    , mRealValue(0)
 {
     //NOOP
 }
@@ -50,7 +53,8 @@ UBSetting::UBSetting(UBSettings* owner, const QString& pDomain, const QString& p
         mPath(pDomain + "/" + pKey), 
         mDefaultValue(pDefaultValue)
 {
-    get(); // force caching of the setting
+    refresh(mOwner->value(mPath, mDefaultValue)); // force caching of the setting
+    mOwner->registerSetting(this);
 }
 
 UBSetting::~UBSetting()
@@ -69,7 +73,7 @@ void UBSetting::set(const QVariant& pValue)
 
 QVariant UBSetting::get()
 {
-    return mOwner->value(mPath, mDefaultValue);
+    return mValue;
 }
 
 QVariant UBSetting::reset()
@@ -79,6 +83,23 @@ QVariant UBSetting::reset()
 }
 
 
+// Called by the owner whenever the value stored under the path changes, whoever changed it
+void UBSetting::refresh(const QVariant& pValue)
+{
+    mValue = pValue;
+    mBoolValue = pValue.toBool();
+    mIntValue = pValue.toInt();
+    mRealValue = pValue.toDouble();
+
+    if (pValue.type() == QVariant::Color)
+        mColorValue = pValue.value<QColor>();
+    else if (QColor::isValidColor(pValue.toString()))
+        mColorValue = QColor(pValue.toString());
+    else
+        mColorValue = QColor();
+}
+
+
 void UBSetting::setBool(bool pValue)
 {
     set(pValue);
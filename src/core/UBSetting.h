@@ -49,6 +49,29 @@ class UBSetting : public QObject
         virtual QVariant get();
         virtual QVariant reset();
 
+        // typed copies of the value, for code reading the setting on every input event or paint
+        bool toBool() const
+        {
+            return mBoolValue;
+        }
+
+        int toInt() const
+        {
+            return mIntValue;
+        }
+
+        qreal toReal() const
+        {
+            return mRealValue;
+        }
+
+        QColor toColor() const
+        {
+            return mColorValue;
+        }
+
+        void refresh(const QVariant& pValue);
+
         virtual QString domain() const
         {
             return mDomain;
@@ -86,6 +109,12 @@ class UBSetting : public QObject
         QString mKey;
         QString mPath;
         QVariant mDefaultValue;
+
+        QVariant mValue;
+        bool mBoolValue;
+        int mIntValue;
+        qreal mRealValue;
+        QColor mColorValue;
 };
 
 
@@ -62,6 +62,8 @@ QString UBSettings::documentIdentifer = QString("ID");
 QString UBSettings::documentVersion = QString("Version");
 QString UBSettings::documentUpdatedAt = QString("UpdatedAt");
 QString UBSettings::documentPageCount = QString("PageCount");
+QString UBSettings::documentItemCount = QString("ItemCount");
+QString UBSettings::documentItemCountPage = QString("ItemCountPage");
 QString UBSettings::documentDate = QString("date");
 
 QString UBSettings::trashedDocumentGroupNamePrefix = QString("_Trash:");
@@ -103,6 +105,7 @@ QColor UBSettings::opaquePaletteColor = QColor(66, 66, 66, 200);
 QColor UBSettings::documentViewLightColor = QColor(241, 241, 241);
 
 QPointer<QSettings> UBSettings::sAppSettings = 0;
+QString UBSettings::sUserDataDirectory;
 
 const int UBSettings::maxThumbnailWidth = 400;
 const int UBSettings::defaultThumbnailWidth = 150;
@@ -283,9 +286,9 @@ void UBSettings::init()
     boardUseHighResTabletEvent = new UBSetting(this, "Board", "UseHighResTabletEvent", true);
 
     boardInterpolatePenStrokes = new UBSetting(this, "Board", "InterpolatePenStrokes", true);
+    boardPredictPenStrokes = new UBSetting(this, "Board", "PredictPenStrokes", false);
     boardSimplifyPenStrokes = new UBSetting(this, "Board", "SimplifyPenStrokes", true);
-    boardSimplifyPenStrokesThresholdAngle = new UBSetting(this, "Board", "SimplifyPenStrokesThresholdAngle", 2);
-    boardSimplifyPenStrokesThresholdWidthDifference = new UBSetting(this, "Board", "SimplifyPenStrokesThresholdWidthDifference", 2.0);
+    boardSimplifyPenStrokesThresholdDistance = new UBSetting(this, "Board", "SimplifyPenStrokesThresholdDistance", 0.5);
 
     boardInterpolateMarkerStrokes = new UBSetting(this, "Board", "InterpolateMarkerStrokes", true);
     boardSimplifyMarkerStrokes = new UBSetting(this, "Board", "SimplifyMarkerStrokes", true);
@@ -444,6 +447,10 @@ void UBSettings::init()
     // removed in version 4.4.b.2
     mUserSettings->remove("Podcast/RecordMicrophone");
 
+    // replaced by Board/SimplifyPenStrokesThresholdDistance
+    mUserSettings->remove("Board/SimplifyPenStrokesThresholdAngle");
+    mUserSettings->remove("Board/SimplifyPenStrokesThresholdWidthDifference");
+
     documentThumbnailWidth      = new UBSetting(this, "Document", "ThumbnailWidth", UBSettings::defaultThumbnailWidth);
     documentSortKind            = new UBSetting(this, "Document", "SortKind", UBSettings::defaultSortKind);
     documentSortOrder           = new UBSetting(this, "Document", "SortOrder", UBSettings::defaultSortOrder);
@@ -478,6 +485,16 @@ void UBSettings::init()
 
     pointerDiameter = value("Board/PointerDiameter", pointerDiameter).toInt();
 
+    mPenWidthIndex = new UBSetting(this, "Board", "PenLineWidthIndex", 0);
+    mPenColorIndex = new UBSetting(this, "Board", "PenColorIndex", 0);
+    mMarkerWidthIndex = new UBSetting(this, "Board", "MarkerLineWidthIndex", 0);
+    mMarkerColorIndex = new UBSetting(this, "Board", "MarkerColorIndex", 0);
+    mEraserWidthIndex = new UBSetting(this, "Board", "EraserCircleWidthIndex", 1);
+    mEraserFineWidth = new UBSetting(this, "Board", "EraserFineWidth", 16);
+    mEraserMediumWidth = new UBSetting(this, "Board", "EraserMediumWidth", 64);
+    mEraserStrongWidth = new UBSetting(this, "Board", "EraserStrongWidth", 128);
+    mDarkBackground = new UBSetting(this, "Board", "DarkBackground", 0);
+
     cleanNonPersistentSettings();
     checkNewSettings();
 }
@@ -518,6 +535,16 @@ void UBSettings::setValue (const QString & key, const QVariant & value)
 {
     // Save the setting to the queue only; a call to save() is necessary to persist the settings
     mSettingsQueue[key] = value;
+
+    // Keep the values cached by the setting objects in sync, whether or not the change went through them
+    foreach(UBSetting* setting, mSettingObjects.values(key))
+        setting->refresh(value);
+}
+
+
+void UBSettings::registerSetting(UBSetting* setting)
+{
+    mSettingObjects.insert(setting->path(), setting);
 }
 
 /**
@@ -556,7 +583,7 @@ void UBSettings::save()
 
 int UBSettings::penWidthIndex()
 {
-    return value("Board/PenLineWidthIndex", 0).toInt();
+    return mPenWidthIndex->toInt();
 }
 
 
@@ -576,18 +603,18 @@ qreal UBSettings::currentPenWidth()
     switch (penWidthIndex())
     {
         case UBWidth::Fine:
-            width = boardPenFineWidth->get().toDouble();
+            width = boardPenFineWidth->toReal();
             break;
         case UBWidth::Medium:
-            width = boardPenMediumWidth->get().toDouble();
+            width = boardPenMediumWidth->toReal();
             break;
         case UBWidth::Strong:
-            width = boardPenStrongWidth->get().toDouble();
+            width = boardPenStrongWidth->toReal();
             break;
         default:
             Q_ASSERT(false);
             //failsafe
-            width = boardPenFineWidth->get().toDouble();
+            width = boardPenFineWidth->toReal();
             break;
     }
 
@@ -597,7 +624,7 @@ qreal UBSettings::currentPenWidth()
 
 int UBSettings::penColorIndex()
 {
-    return value("Board/PenColorIndex", 0).toInt();
+    return mPenColorIndex->toInt();
 }
 
 
@@ -638,7 +665,7 @@ QList<QColor> UBSettings::penColors(bool onDarkBackground)
 
 int UBSettings::markerWidthIndex()
 {
-    return value("Board/MarkerLineWidthIndex", 0).toInt();
+    return mMarkerWidthIndex->toInt();
 }
 
 
@@ -658,18 +685,18 @@ qreal UBSettings::currentMarkerWidth()
     switch (markerWidthIndex())
     {
         case UBWidth::Fine:
-            width = boardMarkerFineWidth->get().toDouble();
+            width = boardMarkerFineWidth->toReal();
             break;
         case UBWidth::Medium:
-            width = boardMarkerMediumWidth->get().toDouble();
+            width = boardMarkerMediumWidth->toReal();
             break;
         case UBWidth::Strong:
-            width = boardMarkerStrongWidth->get().toDouble();
+            width = boardMarkerStrongWidth->toReal();
             break;
         default:
             Q_ASSERT(false);
             //failsafe
-            width = boardMarkerFineWidth->get().toDouble();
+            width = boardMarkerFineWidth->toReal();
             break;
     }
 
@@ -679,7 +706,7 @@ qreal UBSettings::currentMarkerWidth()
 
 int UBSettings::markerColorIndex()
 {
-    return value("Board/MarkerColorIndex", 0).toInt();
+    return mMarkerColorIndex->toInt();
 }
 
 
@@ -722,7 +749,7 @@ QList<QColor> UBSettings::markerColors(bool onDarkBackground)
 
 int UBSettings::eraserWidthIndex()
 {
-    return value("Board/EraserCircleWidthIndex", 1).toInt();
+    return mEraserWidthIndex->toInt();
 }
 
 void UBSettings::setEraserWidthIndex(int index)
@@ -732,7 +759,7 @@ void UBSettings::setEraserWidthIndex(int index)
 
 qreal UBSettings::eraserFineWidth()
 {
-    return value("Board/EraserFineWidth", 16).toDouble();
+    return mEraserFineWidth->toReal();
 }
 
 void UBSettings::setEraserFineWidth(qreal width)
@@ -742,7 +769,7 @@ void UBSettings::setEraserFineWidth(qreal width)
 
 qreal UBSettings::eraserMediumWidth()
 {
-    return value("Board/EraserMediumWidth", 64).toDouble();
+    return mEraserMediumWidth->toReal();
 }
 
 void UBSettings::setEraserMediumWidth(qreal width)
@@ -752,7 +779,7 @@ void UBSettings::setEraserMediumWidth(qreal width)
 
 qreal UBSettings::eraserStrongWidth()
 {
-    return value("Board/EraserStrongWidth", 128).toDouble();
+    return mEraserStrongWidth->toReal();
 }
 
 void UBSettings::setEraserStrongWidth(qreal width)
@@ -787,7 +814,7 @@ qreal UBSettings::currentEraserWidth()
 
 bool UBSettings::isDarkBackground()
 {
-    return value("Board/DarkBackground", 0).toBool();
+    return mDarkBackground->toBool();
 }
 
 
@@ -918,24 +945,30 @@ void UBSettings::setItalicFont(bool italic)
 
 QString UBSettings::userDataDirectory()
 {
-    static QString dataDirPath = "";
-    if(dataDirPath.isEmpty()){
+    if(sUserDataDirectory.isEmpty()){
         if (getAppSettings() && getAppSettings()->contains("App/DataDirectory")) {
             qDebug() << "getAppSettings()->contains(App/DataDirectory):" << getAppSettings()->contains("App/DataDirectory");
-            dataDirPath = getAppSettings()->value("App/DataDirectory").toString();
-            dataDirPath = replaceWildcard(dataDirPath);
+            sUserDataDirectory = getAppSettings()->value("App/DataDirectory").toString();
+            sUserDataDirectory = replaceWildcard(sUserDataDirectory);
 
-            if(checkDirectory(dataDirPath))
-                return dataDirPath;
+            if(checkDirectory(sUserDataDirectory))
+                return sUserDataDirectory;
             else
-                qCritical() << "Impossible to create datadirpath " << dataDirPath;
+                qCritical() << "Impossible to create datadirpath " << sUserDataDirectory;
 
         }
-        dataDirPath = UBFileSystemUtils::normalizeFilePath(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
+        sUserDataDirectory = UBFileSystemUtils::normalizeFilePath(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
         if (qApp->organizationName().size() > 0)
-            dataDirPath.replace(qApp->organizationName() + "/", "");
+            sUserDataDirectory.replace(qApp->organizationName() + "/", "");
     }
-    return dataDirPath;
+    return sUserDataDirectory;
+}
+
+
+// must be called before the first use of the settings or of any user directory
+void UBSettings::setUserDataDirectory(const QString& path)
+{
+    sUserDataDirectory = path;
 }
 
 
@@ -1437,6 +1470,9 @@ void UBSettings::removeSetting(const QString &setting)
 
     if (mSettingsQueue.contains(setting))
         mSettingsQueue.remove(setting);
+
+    foreach(UBSetting* settingObject, mSettingObjects.values(setting))
+        settingObject->refresh(settingObject->defaultValue());
 }
 
 void UBSettings::checkNewSettings()
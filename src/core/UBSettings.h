@@ -129,6 +129,7 @@ class UBSettings : public QObject
 
         //user directories
         static QString userDataDirectory();
+        static void setUserDataDirectory(const QString& path);
         static QString userDocumentDirectory();
         static QString userFavoriteListFilePath();
         static QString userTrashDirPath();
@@ -203,6 +204,8 @@ class UBSettings : public QObject
         static QString documentVersion;
         static QString documentUpdatedAt;
         static QString documentPageCount;
+        static QString documentItemCount;
+        static QString documentItemCountPage;
 
         static QString documentDate;
 
@@ -287,9 +290,9 @@ class UBSettings : public QObject
         UBSetting* boardUseHighResTabletEvent;
 
         UBSetting* boardInterpolatePenStrokes;
+        UBSetting* boardPredictPenStrokes;
         UBSetting* boardSimplifyPenStrokes;
-        UBSetting* boardSimplifyPenStrokesThresholdAngle;
-        UBSetting* boardSimplifyPenStrokesThresholdWidthDifference;
+        UBSetting* boardSimplifyPenStrokesThresholdDistance;
         UBSetting* boardInterpolateMarkerStrokes;
         UBSetting* boardSimplifyMarkerStrokes;
 
@@ -451,6 +454,7 @@ class UBSettings : public QObject
 
         QVariant value ( const QString & key, const QVariant & defaultValue = QVariant() );
         void setValue (const QString & key,const QVariant & value);
+        void registerSetting(UBSetting* setting);
 
         void colorChanged() { emit colorContextChanged(); }
 
@@ -463,6 +467,18 @@ class UBSettings : public QObject
         QSettings* mUserSettings;
 
         QHash<QString, QVariant> mSettingsQueue;
+        QMultiHash<QString, UBSetting*> mSettingObjects;
+
+        // keys read through the accessors above on every input event
+        UBSetting* mPenWidthIndex;
+        UBSetting* mPenColorIndex;
+        UBSetting* mMarkerWidthIndex;
+        UBSetting* mMarkerColorIndex;
+        UBSetting* mEraserWidthIndex;
+        UBSetting* mEraserFineWidth;
+        UBSetting* mEraserMediumWidth;
+        UBSetting* mEraserStrongWidth;
+        UBSetting* mDarkBackground;
 
         static const int sDefaultFontPixelSize;
         static const char *sDefaultFontFamily;
@@ -471,6 +487,7 @@ class UBSettings : public QObject
 
         static QPointer<QSettings> sAppSettings;
         static QPointer<UBSettings> sSingleton;
+        static QString sUserDataDirectory;
 
         static bool checkDirectory(QString& dirPath);
         static QString replaceWildcard(QString& path);
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#include "UBTrace.h"
+
+#include <QSaveFile>
+
+#include "core/memcheck.h"
+
+bool UBTrace::sEnabled = false;
+QElapsedTimer UBTrace::sClock;
+QVector<UBTrace::Event> UBTrace::sEvents;
+int UBTrace::sNextEvent = 0;
+bool UBTrace::sWrapped = false;
+QMutex UBTrace::sMutex;
+
+
+void UBTrace::enable(int capacity)
+{
+    QMutexLocker locker(&sMutex);
+
+    if (!sClock.isValid())
+        sClock.start();
+
+    sEvents.resize(qMax(1, capacity));
+    sNextEvent = 0;
+    sWrapped = false;
+    sEnabled = true;
+}
+
+
+void UBTrace::disable()
+{
+    sEnabled = false;
+}
+
+
+qint64 UBTrace::now()
+{
+    return sClock.nsecsElapsed();
+}
+
+
+void UBTrace::addSpan(const char* name, qint64 start, qint64 end)
+{
+    Event event;
+    event.name = name;
+    event.phase = 'X';
+    event.timestamp = start;
+    event.value = end - start;
+    event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    add(event);
+}
+
+
+void UBTrace::addCounter(const char* name, qint64 value)
+{
+    Event event;
+    event.name = name;
+    event.phase = 'C';
+    event.timestamp = now();
+    event.value = value;
+    event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    add(event);
+}
+
+
+void UBTrace::add(const Event& event)
+{
+    QMutexLocker locker(&sMutex);
+
+    if (sEvents.isEmpty())
+        return;
+
+    sEvents[sNextEvent] = event;
+
+    if (++sNextEvent == sEvents.size())
+    {
+        sNextEvent = 0;
+        sWrapped = true;
+    }
+}
+
+
+/**
+ * @brief Write the recorded events, oldest first, as a Chrome trace event JSON file
+ */
+bool UBTrace::dump(const QString& fileName)
+{
+    QVector<Event> events;
+
+    {
+        QMutexLocker locker(&sMutex);
+
+        if (sWrapped)
+            events << sEvents.mid(sNextEvent);
+
+        events << sEvents.mid(0, sNextEvent);
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "cannot write trace file" << fileName << file.errorString();
+        return false;
+    }
+
+    // written by hand, building a QJsonDocument of a full buffer would cost more than the trace itself
+    QTextStream stream(&file);
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    qint64 pid = QCoreApplication::applicationPid();
+
+    for (int i = 0; i < events.size(); i++)
+    {
+        const Event& event = events.at(i);
+
+        if (i > 0)
+            stream << ",";
+
+        stream << "\n{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+               << "\",\"pid\":" << pid << ",\"tid\":" << event.threadId
+               << ",\"ts\":" << QString::number(event.timestamp / 1000., 'f', 3);
+
+        if (event.phase == 'X')
+            stream << ",\"dur\":" << QString::number(event.value / 1000., 'f', 3) << "}";
+        else
+            stream << ",\"args\":{\"value\":" << event.value << "}}";
+    }
+
+    stream << "\n]}\n";
+    stream.flush();
+
+    return file.commit();
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#ifndef UBTRACE_H_
+#define UBTRACE_H_
+
+#include <QtCore>
+
+/*
+ * Tracing of the hot paths, for the reports where "it froze" is all we know.
+ *
+ * Spans and counters are recorded in a fixed size ring buffer when tracing is enabled (-trace argument or
+ * OPENBOARD_TRACE environment variable) and dumped on demand in the Chrome trace event format, to be
+ * opened in chrome://tracing or Perfetto. When tracing is disabled a span costs a single branch; building
+ * with UB_NO_TRACING removes the instrumentation altogether.
+ *
+ *   void UBFoo::load()
+ *   {
+ *       UB_TRACE_SCOPE("UBFoo::load");
+ *       ...
+ *       UB_TRACE_COUNTER("foo items", mItems.count());
+ *   }
+ *
+ * Names must be string literals: only their address is recorded.
+ */
+class UBTrace
+{
+    public:
+
+        static void enable(int capacity = 65536);
+        static void disable();
+
+        static inline bool isEnabled()
+        {
+            return sEnabled;
+        }
+
+        static qint64 now();
+
+        static void addSpan(const char* name, qint64 start, qint64 end);
+        static void addCounter(const char* name, qint64 value);
+
+        static bool dump(const QString& fileName);
+
+    private:
+
+        struct Event
+        {
+            const char* name;
+            char phase; // 'X' for spans, 'C' for counters
+            qint64 timestamp; // nanoseconds
+            qint64 value; // span duration or counter value
+            quintptr threadId;
+        };
+
+        static void add(const Event& event);
+
+        static bool sEnabled;
+        static QElapsedTimer sClock;
+        static QVector<Event> sEvents;
+        static int sNextEvent;
+        static bool sWrapped;
+        static QMutex sMutex;
+};
+
+
+class UBTraceScope
+{
+    public:
+
+        inline UBTraceScope(const char* name)
+            : mName(name)
+            , mStart(UBTrace::isEnabled() ? UBTrace::now() : -1)
+        {
+            // NOOP
+        }
+
+        inline ~UBTraceScope()
+        {
+            if (mStart >= 0)
+                UBTrace::addSpan(mName, mStart, UBTrace::now());
+        }
+
+    private:
+
+        const char* mName;
+        qint64 mStart;
+};
+
+
+#ifdef UB_NO_TRACING
+    #define UB_TRACE_SCOPE(name)
+    #define UB_TRACE_COUNTER(name, value)
+#else
+    #define UB_TRACE_CONCAT_(a, b) a##b
+    #define UB_TRACE_CONCAT(a, b) UB_TRACE_CONCAT_(a, b)
+    #define UB_TRACE_SCOPE(name) UBTraceScope UB_TRACE_CONCAT(ubTraceScope, __LINE__)(name)
+    #define UB_TRACE_COUNTER(name, value) do { if (UBTrace::isEnabled()) UBTrace::addCounter(name, value); } while (0)
+#endif
+
+#endif /* UBTRACE_H_ */
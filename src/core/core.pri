@@ -4,6 +4,11 @@ HEADERS      += src/core/UB.h \
                 src/core/UBSettings.h \
                 src/core/UBSetting.h \
                 src/core/UBPersistenceManager.h \
+                src/core/UBPageManifest.h \
+                src/core/UBBenchmark.h \
+                src/core/UBTrace.h \
+                src/core/UBDocumentJournal.h \
+                src/core/UBAssetManifest.h \
                 src/core/UBSceneCache.h \
                 src/core/UBPreferencesController.h \
                 src/core/UBMimeData.h \
@@ -23,6 +28,11 @@ SOURCES      += src/core/main.cpp \
                 src/core/UBSettings.cpp \
                 src/core/UBSetting.cpp \
                 src/core/UBPersistenceManager.cpp \
+                src/core/UBPageManifest.cpp \
+                src/core/UBBenchmark.cpp \
+                src/core/UBTrace.cpp \
+                src/core/UBDocumentJournal.cpp \
+                src/core/UBAssetManifest.cpp \
                 src/core/UBSceneCache.cpp \
                 src/core/UBPreferencesController.cpp \
                 src/core/UBMimeData.cpp \
@@ -59,12 +59,7 @@ void UBDocumentContainer::setDocument(UBDocumentProxy* document, bool forceReloa
 
 void UBDocumentContainer::duplicatePages(QList<int>& pageIndexes)
 {
-    int offset = 0;
-    foreach(int sceneIndex, pageIndexes)
-    {
-        UBPersistenceManager::persistenceManager()->duplicateDocumentScene(mCurrentDocument, sceneIndex + offset);
-        offset++;
-    }
+    UBPersistenceManager::persistenceManager()->duplicateDocumentScenes(mCurrentDocument, pageIndexes);
 }
 
 bool UBDocumentContainer::movePageToIndex(int source, int target)
@@ -86,10 +81,9 @@ void UBDocumentContainer::deletePages(QList<int>& pageIndexes)
     foreach(int index, pageIndexes)
     {
         deleteThumbPage(index - offset);
-        emit removeThumbnailRequired(index - offset);
         offset++;
-
     }
+    emit removeThumbnailsRequired(pageIndexes);
     emit documentThumbnailsUpdated(this);
 }
 
@@ -130,6 +124,14 @@ void UBDocumentContainer::updatePage(int index)
     emit documentThumbnailsUpdated(this);
 }
 
+void UBDocumentContainer::updatePages(const QList<int>& indexes)
+{
+    foreach(int index, indexes)
+        updateThumbPage(index);
+
+    emit documentThumbnailsUpdated(this);
+}
+
 void UBDocumentContainer::deleteThumbPage(int index)
 {
     mDocumentThumbs.removeAt(index);
@@ -67,6 +67,7 @@ class UBDocumentContainer : public QObject
         void addPage(int index);
         void addPixmapAt(const QPixmap *pix, int index);
         void updatePage(int index);
+        void updatePages(const QList<int>& indexes);
         void addEmptyThumbPage();
         void reloadThumbnails();
 
@@ -88,6 +89,7 @@ class UBDocumentContainer : public QObject
         void initThumbnailsRequired(UBDocumentContainer* source);
         void addThumbnailRequired(UBDocumentContainer* source, int index);
         void removeThumbnailRequired(int index);
+        void removeThumbnailsRequired(const QList<int>& indexes);
         void moveThumbnailRequired(int from, int to);
         void updateThumbnailsRequired();
 
@@ -36,6 +36,7 @@
 
 #include "core/UBApplication.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBPageManifest.h"
 #include "core/UBDocumentManager.h"
 #include "core/UBApplicationController.h"
 #include "core/UBSettings.h"
@@ -695,15 +696,31 @@ bool UBDocumentTreeModel::dropMimeData(const QMimeData *data, Qt::DropAction act
 
         QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-        foreach (UBMimeDataItem sourceItem, ubMime->items())
+        int firstNewIndex = targetDocProxy->pageCount();
+
+        // consecutive pages of the same document are appended in one batch
+        QList<UBMimeDataItem> items = ubMime->items();
+        for (int i = 0; i < items.size(); )
         {
-            UBDocumentProxy *fromProxy = sourceItem.documentProxy();
-            int fromIndex = sourceItem.sceneIndex();
-            int toIndex = targetDocProxy->pageCount();
+            UBDocumentProxy *fromProxy = items.at(i).documentProxy();
+
+            QList<int> fromIndexes;
+            for (; i < items.size() && items.at(i).documentProxy() == fromProxy; i++)
+                fromIndexes << items.at(i).sceneIndex();
+
+            UBPersistenceManager::persistenceManager()->copyDocumentScenes(fromProxy, fromIndexes,
+                                                                           targetDocProxy, targetDocProxy->pageCount());
+        }
+
+        UBDocumentController *ctrl = UBApplication::documentController;
+        if (ctrl->selectedDocument() == targetDocProxy)
+        {
+            for (int i = firstNewIndex; i < targetDocProxy->pageCount(); i++)
+                ctrl->insertThumbPage(i);
 
-            UBPersistenceManager::persistenceManager()->copyDocumentScene(fromProxy, fromIndex,
-                                                                          targetDocProxy, toIndex);
+            emit ctrl->documentThumbnailsUpdated(ctrl);
         }
+        ctrl->TreeViewSelectionChanged(ctrl->firstSelectedTreeIndex(), QModelIndex());
 
         QApplication::restoreOverrideCursor();
 
@@ -1531,8 +1548,8 @@ void UBDocumentTreeView::dropEvent(QDropEvent *event)
 
                 UBPersistenceManager::persistenceManager()->insertDocumentSceneAt(targetDocProxy, sceneClone, targetDocProxy->pageCount());
 
-                QString thumbTmp(fromProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", fromIndex));
-                QString thumbTo(targetDocProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", toIndex));
+                QString thumbTmp(UBPageManifest::thumbnailFilePath(fromProxy->persistencePath(), fromIndex));
+                QString thumbTo(UBPageManifest::thumbnailFilePath(targetDocProxy->persistencePath(), toIndex));
 
                 QFile::remove(thumbTo);
                 QFile::copy(thumbTmp, thumbTo);
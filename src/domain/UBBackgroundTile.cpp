@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#include "UBBackgroundTile.h"
+
+#include "core/memcheck.h"
+
+const int UBBackgroundTile::sMaximumTileSide = 512;
+
+
+UBBackgroundTile::UBBackgroundTile()
+    : mBackground(UBPageBackground::plain)
+    , mGridSize(0)
+    , mColor(0)
+    , mIntermediateLines(false)
+    , mScaleX(0)
+    , mScaleY(0)
+{
+    // NOOP
+}
+
+
+void UBBackgroundTile::paint(QPainter* painter, const QRectF& rect, UBPageBackground background, int gridSize,
+                             const QColor& color, bool intermediateLines)
+{
+    if (background == UBPageBackground::plain || gridSize <= 0)
+        return;
+
+    QTransform deviceTransform = painter->deviceTransform();
+
+    // vector outputs (pdf export, printing) keep real lines
+    QPaintEngine* engine = painter->paintEngine();
+    bool rasterOutput = engine && (engine->type() == QPaintEngine::Raster || engine->type() == QPaintEngine::OpenGL2);
+
+    if (!rasterOutput || deviceTransform.type() > QTransform::TxScale)
+    {
+        paintLines(painter, rect, background, gridSize, color, intermediateLines);
+        return;
+    }
+
+    if (mTile.isNull()
+            || mBackground != background
+            || mGridSize != gridSize
+            || mColor != color.rgba()
+            || mIntermediateLines != intermediateLines
+            || !qFuzzyCompare(mScaleX, deviceTransform.m11())
+            || !qFuzzyCompare(mScaleY, deviceTransform.m22()))
+    {
+        mBackground = background;
+        mGridSize = gridSize;
+        mColor = color.rgba();
+        mIntermediateLines = intermediateLines;
+
+        if (!updateTile(deviceTransform.m11(), deviceTransform.m22()))
+            mTile = QPixmap();
+    }
+
+    if (mTile.isNull())
+    {
+        paintLines(painter, rect, background, gridSize, color, intermediateLines);
+        return;
+    }
+
+    QBrush tileBrush(mTile);
+    tileBrush.setTransform(mBrushTransform);
+
+    painter->fillRect(rect, tileBrush);
+}
+
+
+void UBBackgroundTile::paintLines(QPainter* painter, const QRectF& rect, UBPageBackground background, int gridSize,
+                                  const QColor& color, bool intermediateLines)
+{
+    if (background == UBPageBackground::plain || gridSize <= 0)
+        return;
+
+    painter->save();
+    painter->setPen(color);
+
+    qreal firstY = ((int) (rect.y () / gridSize)) * gridSize;
+
+    for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSize)
+    {
+        painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
+    }
+
+    qreal firstX = ((int) (rect.x () / gridSize)) * gridSize;
+
+    if (background == UBPageBackground::crossed)
+    {
+        for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += gridSize)
+        {
+            painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
+        }
+    }
+
+    if (intermediateLines)
+    {
+        QColor intermediateColor = color;
+        intermediateColor.setAlphaF(0.5 * color.alphaF());
+        painter->setPen(intermediateColor);
+
+        for (qreal yPos = firstY - gridSize/2; yPos < rect.y () + rect.height (); yPos += gridSize)
+        {
+            painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
+        }
+
+        if (background == UBPageBackground::crossed)
+        {
+            for (qreal xPos = firstX - gridSize/2; xPos < rect.x () + rect.width (); xPos += gridSize)
+            {
+                painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
+            }
+        }
+    }
+
+    painter->restore();
+}
+
+
+bool UBBackgroundTile::updateTile(qreal scaleX, qreal scaleY)
+{
+    mScaleX = scaleX;
+    mScaleY = scaleY;
+
+    qreal cellWidth = mGridSize * qAbs(scaleX);
+    qreal cellHeight = mGridSize * qAbs(scaleY);
+
+    if (cellWidth < 2 || cellHeight < 2 || cellWidth > sMaximumTileSide || cellHeight > sMaximumTileSide)
+        return false;
+
+    // the tile spans several cells so that its size in device pixels is close to an integer,
+    // the brush transform absorbs what is left so that the lines don't drift away from the grid
+    int columns = cellsPerTile(cellWidth);
+    int rows = cellsPerTile(cellHeight);
+
+    int tileWidth = qMax(1, qRound(columns * cellWidth));
+    int tileHeight = qMax(1, qRound(rows * cellHeight));
+
+    mTile = QPixmap(tileWidth, tileHeight);
+    mTile.fill(Qt::transparent);
+
+    QColor color = QColor::fromRgba(mColor);
+
+    QPainter tilePainter(&mTile);
+    tilePainter.setPen(color);
+
+    for (int row = 0; row < rows; row++)
+    {
+        int y = qRound(row * cellHeight);
+        tilePainter.drawLine(0, y, tileWidth, y);
+    }
+
+    if (mBackground == UBPageBackground::crossed)
+    {
+        for (int column = 0; column < columns; column++)
+        {
+            int x = qRound(column * cellWidth);
+            tilePainter.drawLine(x, 0, x, tileHeight);
+        }
+    }
+
+    if (mIntermediateLines)
+    {
+        QColor intermediateColor = color;
+        intermediateColor.setAlphaF(0.5 * color.alphaF());
+        tilePainter.setPen(intermediateColor);
+
+        for (int row = 0; row < rows; row++)
+        {
+            int y = qRound((row + 0.5) * cellHeight);
+            tilePainter.drawLine(0, y, tileWidth, y);
+        }
+
+        if (mBackground == UBPageBackground::crossed)
+        {
+            for (int column = 0; column < columns; column++)
+            {
+                int x = qRound((column + 0.5) * cellWidth);
+                tilePainter.drawLine(x, 0, x, tileHeight);
+            }
+        }
+    }
+
+    tilePainter.end();
+
+    mBrushTransform = QTransform::fromScale(columns * mGridSize / (qreal) tileWidth, rows * mGridSize / (qreal) tileHeight);
+
+    return true;
+}
+
+
+int UBBackgroundTile::cellsPerTile(qreal cellSize)
+{
+    int bestCount = 1;
+    qreal bestError = qAbs(cellSize - qRound(cellSize));
+
+    for (int count = 2; count * cellSize <= sMaximumTileSide && bestError > 0.01; count++)
+    {
+        qreal error = qAbs(count * cellSize - qRound(count * cellSize));
+        if (error < bestError)
+        {
+            bestCount = count;
+            bestError = error;
+        }
+    }
+
+    return bestCount;
+}
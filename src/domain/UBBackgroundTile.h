@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#ifndef UBBACKGROUNDTILE_H_
+#define UBBACKGROUNDTILE_H_
+
+#include <QtGui>
+
+#include "core/UB.h"
+
+/*
+ * Repeating tile for the crossed and ruled page backgrounds.
+ *
+ * The grid lines are rendered once into a pixmap at the device scale of the painter and the
+ * background is then filled with a texture brush. The tile is rendered again only when the style,
+ * grid size, color, intermediate lines flag or device scale changes. Rotated views and very
+ * large cells (high zoom) and vector outputs fall back to drawing the lines.
+ */
+class UBBackgroundTile
+{
+    public:
+
+        UBBackgroundTile();
+
+        void paint(QPainter* painter, const QRectF& rect, UBPageBackground background, int gridSize,
+                   const QColor& color, bool intermediateLines);
+
+        static void paintLines(QPainter* painter, const QRectF& rect, UBPageBackground background, int gridSize,
+                               const QColor& color, bool intermediateLines);
+
+    private:
+
+        bool updateTile(qreal scaleX, qreal scaleY);
+        static int cellsPerTile(qreal cellSize);
+
+        QPixmap mTile;
+        QTransform mBrushTransform;
+
+        UBPageBackground mBackground;
+        int mGridSize;
+        QRgb mColor;
+        bool mIntermediateLines;
+        qreal mScaleX;
+        qreal mScaleY;
+
+        static const int sMaximumTileSide;
+};
+
+#endif /* UBBACKGROUNDTILE_H_ */
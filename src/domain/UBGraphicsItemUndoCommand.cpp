@@ -41,6 +41,8 @@
 #include "domain/UBGraphicsGroupContainerItem.h"
 #include "domain/UBGraphicsPolygonItem.h"
 
+QHash<QGraphicsItem*, int> UBGraphicsItemUndoCommand::sItemReferences;
+
 UBGraphicsItemUndoCommand::UBGraphicsItemUndoCommand(UBGraphicsScene* pScene, const QSet<QGraphicsItem*>& pRemovedItems, const QSet<QGraphicsItem*>& pAddedItems, const GroupDataTable &groupsMap): UBUndoCommand()
     , mScene(pScene)
     , mRemovedItems(pRemovedItems - pAddedItems)
@@ -60,6 +62,8 @@ UBGraphicsItemUndoCommand::UBGraphicsItemUndoCommand(UBGraphicsScene* pScene, co
     {
         UBApplication::boardController->freezeW3CWidget(itRemoved.next(), false);
     }
+
+    retainItems();
 }
 
 UBGraphicsItemUndoCommand::UBGraphicsItemUndoCommand(UBGraphicsScene* pScene, QGraphicsItem* pRemovedItem, QGraphicsItem* pAddedItem) : UBUndoCommand()
@@ -78,11 +82,38 @@ UBGraphicsItemUndoCommand::UBGraphicsItemUndoCommand(UBGraphicsScene* pScene, QG
 
     mFirstRedo = true;
 
+    retainItems();
 }
 
 UBGraphicsItemUndoCommand::~UBGraphicsItemUndoCommand()
 {
-   //NOOP
+    releaseItems();
+}
+
+void UBGraphicsItemUndoCommand::retainItems()
+{
+    foreach (QGraphicsItem* item, mAddedItems)
+        sItemReferences[item]++;
+
+    foreach (QGraphicsItem* item, mRemovedItems)
+        sItemReferences[item]++;
+}
+
+void UBGraphicsItemUndoCommand::releaseItems()
+{
+    // the items may already be deleted, they are only used as keys here
+    foreach (QGraphicsItem* item, mAddedItems)
+        releaseItem(item);
+
+    foreach (QGraphicsItem* item, mRemovedItems)
+        releaseItem(item);
+}
+
+void UBGraphicsItemUndoCommand::releaseItem(QGraphicsItem* item)
+{
+    QHash<QGraphicsItem*, int>::iterator reference = sItemReferences.find(item);
+    if (reference != sItemReferences.end() && --reference.value() <= 0)
+        sItemReferences.erase(reference);
 }
 
 void UBGraphicsItemUndoCommand::undo()
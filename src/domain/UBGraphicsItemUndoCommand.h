@@ -56,11 +56,20 @@ class UBGraphicsItemUndoCommand : public UBUndoCommand
 
         virtual int getType() const { return UBUndoType::undotype_GRAPHICITEM; }
 
+        // items added or removed by any command still alive, kept up to date as commands are created and deleted
+        static QList<QGraphicsItem*> referencedItems() { return sItemReferences.keys(); }
+
     protected:
         virtual void undo();
         virtual void redo();
 
     private:
+        void retainItems();
+        void releaseItems();
+        static void releaseItem(QGraphicsItem* item);
+
+        static QHash<QGraphicsItem*, int> sItemReferences;
+
         UBGraphicsScene* mScene;
         QSet<QGraphicsItem*> mRemovedItems;
         QSet<QGraphicsItem*> mAddedItems;
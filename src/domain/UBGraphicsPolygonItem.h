@@ -134,6 +134,18 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
         void setStroke(UBGraphicsStroke* stroke);
         UBGraphicsStroke* stroke() const;
 
+        // SVG points attribute written for these points by the previous save, or a null string
+        QString serializedPoints(const QPolygonF& points) const
+        {
+            return points == mSerializedPoints ? mSerializedPointsAttribute : QString();
+        }
+
+        void setSerializedPoints(const QPolygonF& points, const QString& attribute)
+        {
+            mSerializedPoints = points;
+            mSerializedPointsAttribute = attribute;
+        }
+
     protected:
         void paint ( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget);
 
@@ -154,6 +166,9 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
         UBGraphicsStroke* mStroke;
         UBGraphicsStrokesGroup* mpGroup;
 
+        QPolygonF mSerializedPoints;
+        QString mSerializedPointsAttribute;
+
 };
 
 #endif // UBGRAPHICSPOLYGONITEM_H
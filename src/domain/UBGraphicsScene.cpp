@@ -43,6 +43,7 @@
 #include "core/UBDisplayManager.h"
 #include "core/UBPersistenceManager.h"
 #include "core/UBTextTools.h"
+#include "core/UBTrace.h"
 
 #include "gui/UBMagnifer.h"
 #include "gui/UBMainWindow.h"
@@ -338,6 +339,9 @@ UBGraphicsScene::UBGraphicsScene(UBDocumentProxy* parent, bool enableUndoRedoSta
     , mZLayerController(new UBZLayerController(this))
     , mpLastPolygon(NULL)
     , mTempPolygon(NULL)
+    , mTempPolygonIsPredicted(false)
+    , mBatchingInput(false)
+    , mHasBatchedSegmentEnd(false)
     , mDrawWithCompass(false)
     , mCurrentPolygon(0)
     , mSelectionFrame(0)
@@ -400,6 +404,8 @@ QPointF UBGraphicsScene::lastCenter()
 
 bool UBGraphicsScene::inputDevicePress(const QPointF& scenePos, const qreal& pressure)
 {
+    UB_TRACE_SCOPE("UBGraphicsScene::inputDevicePress");
+
     bool accepted = false;
 
     if (mInputDeviceIsPressed) {
@@ -408,6 +414,7 @@ bool UBGraphicsScene::inputDevicePress(const QPointF& scenePos, const qreal& pre
     }
     else {
         mInputDeviceIsPressed = true;
+        mLastInputSample.timestamp = 0;
 
         UBStylusTool::Enum currentTool = (UBStylusTool::Enum)UBDrawingController::drawingController()->stylusTool();
 
@@ -491,6 +498,8 @@ bool UBGraphicsScene::inputDevicePress(const QPointF& scenePos, const qreal& pre
 
 bool UBGraphicsScene::inputDeviceMove(const QPointF& scenePos, const qreal& pressure)
 {
+    UB_TRACE_SCOPE("UBGraphicsScene::inputDeviceMove");
+
     bool accepted = false;
 
     UBDrawingController *dc = UBDrawingController::drawingController();
@@ -584,8 +593,8 @@ bool UBGraphicsScene::inputDeviceMove(const QPointF& scenePos, const qreal& pres
             else {
                 bool interpolate = false;
 
-                if ((currentTool == UBStylusTool::Pen && UBSettings::settings()->boardInterpolatePenStrokes->get().toBool())
-                    || (currentTool == UBStylusTool::Marker && UBSettings::settings()->boardInterpolateMarkerStrokes->get().toBool()))
+                if ((currentTool == UBStylusTool::Pen && UBSettings::settings()->boardInterpolatePenStrokes->toBool())
+                    || (currentTool == UBStylusTool::Marker && UBSettings::settings()->boardInterpolateMarkerStrokes->toBool()))
                 {
                     interpolate = true;
                 }
@@ -602,8 +611,19 @@ bool UBGraphicsScene::inputDeviceMove(const QPointF& scenePos, const qreal& pres
 
                 if (mDistanceFromLastStrokePoint > MIN_DISTANCE) {
                     QList<QPair<QPointF, qreal> > newPoints = mCurrentStroke->addPoint(scenePos, width, interpolate);
-                    if (newPoints.length() > 1)
-                        drawCurve(newPoints);
+                    if (newPoints.length() > 1) {
+                        if (mBatchingInput) {
+                            // drawn as a single polygon at the end of the batch
+                            if (!mBatchedCurvePoints.isEmpty() && mBatchedCurvePoints.last() == newPoints.first())
+                                newPoints.removeFirst();
+
+                            mBatchedCurvePoints << newPoints;
+                            mPreviousPoint = mBatchedCurvePoints.last().first;
+                            mPreviousWidth = mBatchedCurvePoints.last().second;
+                        }
+                        else
+                            drawCurve(newPoints);
+                    }
 
                     mDistanceFromLastStrokePoint = 0;
                 }
@@ -614,18 +634,12 @@ bool UBGraphicsScene::inputDeviceMove(const QPointF& scenePos, const qreal& pres
                     // scenePos, to make the drawing feel more responsive. This line is then deleted if a new segment is
                     // added to the stroke. (Or it is added to the stroke when we stop drawing)
 
-                    if (mTempPolygon) {
-                        removeItem(mTempPolygon);
-                        mTempPolygon = NULL;
-                    }
-
-                    if (!mCurrentStroke->points().empty())
-                    {
-                        QPointF lastDrawnPoint = mCurrentStroke->points().last().first;
-
-                        mTempPolygon = lineToPolygonItem(QLineF(lastDrawnPoint, scenePos), mPreviousWidth, width);
-                        addItem(mTempPolygon);
+                    if (mBatchingInput) {
+                        mHasBatchedSegmentEnd = true;
+                        mBatchedSegmentEnd = QPair<QPointF, qreal>(scenePos, width);
                     }
+                    else
+                        drawTemporarySegment(scenePos, width, scenePos);
                 }
             }
         }
@@ -648,8 +662,78 @@ bool UBGraphicsScene::inputDeviceMove(const QPointF& scenePos, const qreal& pres
     return accepted;
 }
 
+/**
+ * @brief Handle all the samples the pen sent since the previous frame
+ *
+ * The samples are processed as individual moves, but the stroke points they produce are drawn as a single polygon
+ * and the temporary segment following the pen is updated once. If enabled, that segment is extended by the distance
+ * the pen is expected to travel in the next few milliseconds, to hide the display latency.
+ */
+bool UBGraphicsScene::inputDeviceMove(const QList<UBInputSample>& samples)
+{
+    UB_TRACE_SCOPE("UBGraphicsScene::inputDeviceMove (batch)");
+
+    if (samples.isEmpty())
+        return false;
+
+    UB_TRACE_COUNTER("tablet samples per batch", samples.size());
+
+    bool accepted = false;
+
+    mBatchingInput = true;
+    mHasBatchedSegmentEnd = false;
+
+    foreach(const UBInputSample& sample, samples)
+        accepted = inputDeviceMove(sample.position, sample.pressure) || accepted;
+
+    mBatchingInput = false;
+
+    if (!mBatchedCurvePoints.isEmpty()) {
+        if (mBatchedCurvePoints.size() > 1)
+            drawCurve(mBatchedCurvePoints);
+
+        mBatchedCurvePoints.clear();
+    }
+
+    UBInputSample lastSample = samples.last();
+    UBInputSample previousSample = samples.size() > 1 ? samples.at(samples.size() - 2) : mLastInputSample;
+    mLastInputSample = lastSample;
+
+    if (mHasBatchedSegmentEnd && mCurrentStroke) {
+        QPointF predictedPoint = mBatchedSegmentEnd.first;
+
+        if (UBSettings::settings()->boardPredictPenStrokes->toBool()
+                && previousSample.timestamp > 0 && previousSample.timestamp < lastSample.timestamp)
+        {
+            // milliseconds ahead, and maximum length in screen pixels, of the predicted segment
+            const qreal predictionInterval = 8;
+            const qreal maximumPredictionLength = 16;
+
+            QPointF velocity = (lastSample.position - previousSample.position) / (lastSample.timestamp - previousSample.timestamp);
+            QPointF offset = velocity * predictionInterval;
+
+            qreal antiScaleRatio = 1./(UBApplication::boardController->systemScaleFactor() * UBApplication::boardController->currentZoom());
+            qreal maximumLength = maximumPredictionLength * antiScaleRatio;
+            qreal length = QLineF(QPointF(), offset).length();
+
+            if (length > maximumLength)
+                offset *= maximumLength / length;
+
+            predictedPoint += offset;
+        }
+
+        drawTemporarySegment(mBatchedSegmentEnd.first, mBatchedSegmentEnd.second, predictedPoint);
+    }
+
+    mHasBatchedSegmentEnd = false;
+
+    return accepted;
+}
+
 bool UBGraphicsScene::inputDeviceRelease(int tool)
 {
+    UB_TRACE_SCOPE("UBGraphicsScene::inputDeviceRelease");
+
     bool accepted = false;
 
     if (mPointer)
@@ -702,6 +786,10 @@ bool UBGraphicsScene::inputDeviceRelease(int tool)
             mDrawWithCompass = false;
         }
         else if (mCurrentStroke){
+            // the predicted part of the segment is not kept
+            if (mTempPolygon && mTempPolygonIsPredicted)
+                drawTemporarySegment(mTempSegmentEnd.first, mTempSegmentEnd.second, mTempSegmentEnd.first);
+
             if (mTempPolygon) {
                 UBGraphicsPolygonItem * poly = dynamic_cast<UBGraphicsPolygonItem*>(mTempPolygon->deepCopy());
                 removeItem(mTempPolygon);
@@ -710,8 +798,8 @@ bool UBGraphicsScene::inputDeviceRelease(int tool)
             }
 
             // replace the stroke by a simplified version of it
-            if ((currentTool == UBStylusTool::Pen && UBSettings::settings()->boardSimplifyPenStrokes->get().toBool())
-                || (currentTool == UBStylusTool::Marker && UBSettings::settings()->boardSimplifyMarkerStrokes->get().toBool()))
+            if ((currentTool == UBStylusTool::Pen && UBSettings::settings()->boardSimplifyPenStrokes->toBool())
+                || (currentTool == UBStylusTool::Marker && UBSettings::settings()->boardSimplifyMarkerStrokes->toBool()))
             {
                 simplifyCurrentStroke();
             }
@@ -840,8 +928,8 @@ void UBGraphicsScene::drawMarkerCircle(const QPointF &pPoint)
 
 void UBGraphicsScene::drawPenCircle(const QPointF &pPoint)
 {
-    if (mPenCircle && UBSettings::settings()->showPenPreviewCircle->get().toBool() &&
-        UBSettings::settings()->currentPenWidth() >= UBSettings::settings()->penPreviewFromSize->get().toInt()) {
+    if (mPenCircle && UBSettings::settings()->showPenPreviewCircle->toBool() &&
+        UBSettings::settings()->currentPenWidth() >= UBSettings::settings()->penPreviewFromSize->toInt()) {
         qreal penDiameter = UBSettings::settings()->currentPenWidth();
         penDiameter /= UBApplication::boardController->systemScaleFactor();
         penDiameter /= UBApplication::boardController->currentZoom();
@@ -968,6 +1056,39 @@ void UBGraphicsScene::drawCurve(const QList<QPointF>& points, qreal startWidth,
     mPreviousPoint = points.last();
 }
 
+/**
+ * @brief Replace the segment drawn between the end of the current stroke and the pen position
+ * @param predictedPoint Where the pen is expected to be soon; the segment is extended there if it differs from endPoint
+ */
+void UBGraphicsScene::drawTemporarySegment(const QPointF& endPoint, qreal endWidth, const QPointF& predictedPoint)
+{
+    if (mTempPolygon) {
+        removeItem(mTempPolygon);
+        mTempPolygon = NULL;
+    }
+
+    if (!mCurrentStroke || mCurrentStroke->points().empty())
+        return;
+
+    QPointF lastDrawnPoint = mCurrentStroke->points().last().first;
+
+    mTempSegmentEnd = QPair<QPointF, qreal>(endPoint, endWidth);
+    mTempPolygonIsPredicted = (predictedPoint != endPoint);
+
+    if (mTempPolygonIsPredicted) {
+        QList<QPair<QPointF, qreal> > points;
+        points << QPair<QPointF, qreal>(lastDrawnPoint, mPreviousWidth)
+               << mTempSegmentEnd
+               << QPair<QPointF, qreal>(predictedPoint, endWidth);
+
+        mTempPolygon = curveToPolygonItem(points);
+    }
+    else
+        mTempPolygon = lineToPolygonItem(QLineF(lastDrawnPoint, endPoint), mPreviousWidth, endWidth);
+
+    addItem(mTempPolygon);
+}
+
 void UBGraphicsScene::addPolygonItemToCurrentStroke(UBGraphicsPolygonItem* polygonItem)
 {
     if (!polygonItem->brush().isOpaque())
@@ -1092,7 +1213,7 @@ void UBGraphicsScene::eraseLineTo(const QPointF &pEndPoint, const qreal &pWidth)
     }
 
     if (!intersectedItems.empty())
-        setModified(true);
+        setModified(eraserBoundingRect);
 }
 
 void UBGraphicsScene::drawArcTo(const QPointF& pCenterPoint, qreal pSpanAngle)
@@ -1321,7 +1442,8 @@ void UBGraphicsScene::updateSelectionFrame()
         mSelectionFrame = new UBSelectionFrame();
         bool sceneWasModified = isModified();
         addItem(mSelectionFrame);
-        setModified(sceneWasModified);
+        if (!sceneWasModified)
+            setModified(false);
     }
 
     QList<QGraphicsItem*> selItems = selectedItems();
@@ -2683,43 +2805,16 @@ void UBGraphicsScene::drawBackground(QPainter *painter, const QRectF &rect)
         QColor bgCrossColor;
 
         if (darkBackground)
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorDarkBackground->get().toString());
+            bgCrossColor = UBSettings::settings()->boardCrossColorDarkBackground->toColor();
         else
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorLightBackground->get().toString());
+            bgCrossColor = UBSettings::settings()->boardCrossColorLightBackground->toColor();
         if (mZoomFactor < 0.7)
         {
             int alpha = 255 * mZoomFactor / 2;
             bgCrossColor.setAlpha (alpha); // fade the crossing on small zooms
         }
 
-        painter->setPen (bgCrossColor);
-
-        if (mPageBackground == UBPageBackground::crossed)
-        {
-            qreal firstY = ((int) (rect.y () / backgroundGridSize())) * backgroundGridSize();
-
-            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += backgroundGridSize())
-            {
-                painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-            }
-
-            qreal firstX = ((int) (rect.x () / backgroundGridSize())) * backgroundGridSize();
-
-            for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += backgroundGridSize())
-            {
-                painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-            }
-        }
-
-        else if (mPageBackground == UBPageBackground::ruled)
-        {
-            qreal firstY = ((int) (rect.y () / backgroundGridSize())) * backgroundGridSize();
-
-            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += backgroundGridSize())
-            {
-                painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-            }
-        }
+        mBackgroundTile.paint(painter, rect, mPageBackground, backgroundGridSize(), bgCrossColor, false);
     }
 }
 
@@ -2865,7 +2960,7 @@ void UBGraphicsScene::setDocumentUpdated()
 
 void UBGraphicsScene::createEraiser()
 {
-    if (UBSettings::settings()->showEraserPreviewCircle->get().toBool()) {
+    if (UBSettings::settings()->showEraserPreviewCircle->toBool()) {
         mEraser = new QGraphicsEllipseItem(); // mem : owned and destroyed by the scene
         mEraser->setRect(QRect(0, 0, 0, 0));
         mEraser->setVisible(false);
@@ -2898,7 +2993,7 @@ void UBGraphicsScene::createPointer()
 
 void UBGraphicsScene::createMarkerCircle()
 {
-    if (UBSettings::settings()->showMarkerPreviewCircle->get().toBool()) {
+    if (UBSettings::settings()->showMarkerPreviewCircle->toBool()) {
         mMarkerCircle = new QGraphicsEllipseItem();
 
         mMarkerCircle->setRect(QRect(0, 0, 0, 0));
@@ -2917,7 +3012,7 @@ void UBGraphicsScene::createMarkerCircle()
 
 void UBGraphicsScene::createPenCircle()
 {
-    if (UBSettings::settings()->showPenPreviewCircle->get().toBool()) {
+    if (UBSettings::settings()->showPenPreviewCircle->toBool()) {
         mPenCircle = new QGraphicsEllipseItem();
 
         mPenCircle->setRect(QRect(0, 0, 0, 0));
@@ -35,6 +35,7 @@
 #include "core/UB.h"
 
 #include "UBItem.h"
+#include "UBBackgroundTile.h"
 #include "tools/UBGraphicsCurtainItem.h"
 
 class UBGraphicsPixmapItem;
@@ -141,8 +142,14 @@ class UBGraphicsScene: public UBCoreGraphicsScene, public UBItem
 
         bool inputDevicePress(const QPointF& scenePos, const qreal& pressure = 1.0);
         bool inputDeviceMove(const QPointF& scenePos, const qreal& pressure = 1.0);
+        bool inputDeviceMove(const QList<UBInputSample>& samples);
         bool inputDeviceRelease(int tool = -1);
 
+        bool isInputDevicePressed() const
+        {
+            return mInputDeviceIsPressed;
+        }
+
         void leaveEvent (QEvent* event);
 
         void addItem(QGraphicsItem* item);
@@ -202,6 +209,7 @@ class UBGraphicsScene: public UBCoreGraphicsScene, public UBItem
         void drawCurve(const QList<QPointF>& points, qreal startWidth, qreal endWidth);
 
         bool isEmpty() const;
+        int itemCount() const { return mItemCount; }
 
         void setDocument(UBDocumentProxy* pDocument);
 
@@ -398,6 +406,7 @@ public slots:
         UBGraphicsPolygonItem* arcToPolygonItem(const QLineF& pStartRadius, qreal pSpanAngle, qreal pWidth);
         UBGraphicsPolygonItem* curveToPolygonItem(const QList<QPair<QPointF, qreal> > &points);
         UBGraphicsPolygonItem* curveToPolygonItem(const QList<QPointF> &points, qreal startWidth, qreal endWidth);
+        void drawTemporarySegment(const QPointF& endPoint, qreal endWidth, const QPointF& predictedPoint);
         void addPolygonItemToCurrentStroke(UBGraphicsPolygonItem* polygonItem);
 
         void initPolygonItem(UBGraphicsPolygonItem*);
@@ -451,6 +460,7 @@ public slots:
         UBPageBackground mPageBackground;
         int mBackgroundGridSize;
         bool mIntermediateLines;
+        UBBackgroundTile mBackgroundTile;
 
         bool mIsDesktopMode;
         qreal mZoomFactor;
@@ -492,6 +502,14 @@ public slots:
         UBZLayerController *mZLayerController;
         UBGraphicsPolygonItem* mpLastPolygon;
         UBGraphicsPolygonItem* mTempPolygon;
+        QPair<QPointF, qreal> mTempSegmentEnd;
+        bool mTempPolygonIsPredicted;
+
+        bool mBatchingInput;
+        QList<QPair<QPointF, qreal> > mBatchedCurvePoints;
+        bool mHasBatchedSegmentEnd;
+        QPair<QPointF, qreal> mBatchedSegmentEnd;
+        UBInputSample mLastInputSample;
 
         bool mDrawWithCompass;
         UBGraphicsPolygonItem *mCurrentPolygon;
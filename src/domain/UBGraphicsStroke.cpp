@@ -129,7 +129,11 @@ QList<QPair<QPointF, qreal> > UBGraphicsStroke::addPoint(const QPointF& point, q
         QPointF startPoint = (p1+p0)/2.0;
         QPointF endPoint = (p2+p1)/2.0;
 
-        QList<QPointF> calculated = UBGeometryUtils::quadraticBezier(startPoint, p1, endPoint, 10);
+        // One interpolated point every few screen pixels is enough, slow strokes don't need the full 10 steps
+        qreal controlLength = (QLineF(startPoint, p1).length() + QLineF(p1, endPoint).length()) / mAntiScaleRatio;
+        int steps = qBound(2, qCeil(controlLength / 4), 10);
+
+        QList<QPointF> calculated = UBGeometryUtils::quadraticBezier(startPoint, p1, endPoint, steps);
         QList<strokePoint> newPoints;
 
         qreal startWidth = mDrawnPoints.last().second;
@@ -207,53 +211,15 @@ UBGraphicsStroke* UBGraphicsStroke::simplify()
         return NULL;
 
     UBGraphicsStroke* newStroke = new UBGraphicsStroke();
-    newStroke->mDrawnPoints = QList<strokePoint>(mDrawnPoints);
 
-    QList<strokePoint>& points = newStroke->mDrawnPoints;
-    //qDebug() << "Simplifying. Before: " << points.size() << " points and " << polygons().size() << " polygons";
-
-    /* Basic simplifying algorithm: consider A, B and C the current point and the two following ones.
-     * If the angle between (AB) and (BC) is lower than a certain threshold,
-     * the three points are considered to be aligned and the middle one (B) is removed.
-     *
-     * We then consider the two following points as the new B and C while keeping the same A, and
-     * test these three points. As long as they are aligned, B is erased and we start over.
-     * If not, the current B becomes the new A, and so on.
-     *
-     * In case the stroke thickness varies a lot between A and B, then B is not removed even if it
-     * should be according to the previous criteria.
-     *
-     * TODO: more advanced algorithm that could also simplify curved sections of the stroke
-     */
-
-    // angle difference in degrees between AB and BC below which the segments are considered colinear
-    qreal thresholdAngle = UBSettings::settings()->boardSimplifyPenStrokesThresholdAngle->get().toReal();
-
-    // Relative difference in thickness between two consecutive points (A and B) below which they are considered equal
-    qreal thresholdWidthDifference = UBSettings::settings()->boardSimplifyPenStrokesThresholdWidthDifference->get().toReal();
-
-    QList<strokePoint>::iterator it = points.begin();
-    QList<QList<strokePoint>::iterator> toDelete;
-
-    while (it+2 != points.end()) {
-        // it, b_it and (b_it+1) correspond to A, B and C respectively
-        QList<strokePoint>::iterator b_it(it+1);
-
-        while (b_it+1 != points.end()) {
-            qreal angle = qFabs(180-(UBGeometryUtils::angle(it->first, b_it->first, (b_it+1)->first)));
-            qreal widthRatio = qMax(it->second, b_it->second)/qMin(it->second, b_it->second);
-
-            if (angle < thresholdAngle && widthRatio < thresholdWidthDifference)
-                b_it = points.erase(b_it);
-            else
-                break;
-        }
+    // Maximum distance, in screen pixels at the zoom the stroke was drawn with, between the outline
+    // of the original stroke and the outline of the simplified one
+    qreal tolerance = UBSettings::settings()->boardSimplifyPenStrokesThresholdDistance->toReal() * mAntiScaleRatio;
 
-        if (b_it+1 == points.end())
-            break;
-        else
-            it = b_it;
-    }
+    newStroke->mDrawnPoints = simplifyPoints(mDrawnPoints, tolerance);
+
+    QList<strokePoint>& points = newStroke->mDrawnPoints;
+    //qDebug() << "Simplifying. Before: " << mDrawnPoints.size() << " points, after: " << points.size();
 
     // Next, we iterate over the new points to build the polygons that make up the stroke.
     // A new polygon is created every time drawCurve is true.
@@ -323,3 +289,71 @@ UBGraphicsStroke* UBGraphicsStroke::simplify()
 
     return newStroke;
 }
+
+/**
+ * @brief Ramer-Douglas-Peucker simplification of a list of points, the width being the third dimension
+ * @param points The points of the stroke
+ * @param tolerance Maximum error allowed on the outline of the stroke, in scene units
+ *
+ * The error of a removed point is its distance to the kept segment plus half of the difference between its
+ * width and the width interpolated on the segment, i.e how far the edge of the stroke moves.
+ */
+QList<QPair<QPointF, qreal> > UBGraphicsStroke::simplifyPoints(const QList<QPair<QPointF, qreal> >& points, qreal tolerance)
+{
+    int n = points.size();
+
+    if (n < 3 || tolerance <= 0)
+        return points;
+
+    QVector<bool> kept(n, false);
+    kept[0] = true;
+    kept[n - 1] = true;
+
+    QStack<QPair<int, int> > ranges;
+    ranges.push(QPair<int, int>(0, n - 1));
+
+    while (!ranges.isEmpty()) {
+        QPair<int, int> range = ranges.pop();
+
+        const strokePoint& a = points.at(range.first);
+        const strokePoint& b = points.at(range.second);
+
+        QPointF ab = b.first - a.first;
+        qreal squaredLength = QPointF::dotProduct(ab, ab);
+
+        qreal maxError = 0;
+        int maxIndex = -1;
+
+        for (int i = range.first + 1; i < range.second; ++i) {
+            const strokePoint& p = points.at(i);
+
+            qreal t = 0;
+            if (squaredLength > 0)
+                t = qBound(qreal(0), QPointF::dotProduct(p.first - a.first, ab) / squaredLength, qreal(1));
+
+            QPointF projection = a.first + t * ab;
+            qreal width = a.second + t * (b.second - a.second);
+
+            qreal error = QLineF(p.first, projection).length() + qAbs(p.second - width) / 2;
+
+            if (error > maxError) {
+                maxError = error;
+                maxIndex = i;
+            }
+        }
+
+        if (maxIndex != -1 && maxError > tolerance) {
+            kept[maxIndex] = true;
+            ranges.push(QPair<int, int>(range.first, maxIndex));
+            ranges.push(QPair<int, int>(maxIndex, range.second));
+        }
+    }
+
+    QList<strokePoint> result;
+    for (int i = 0; i < n; ++i) {
+        if (kept.at(i))
+            result << points.at(i);
+    }
+
+    return result;
+}
@@ -66,6 +66,8 @@ class UBGraphicsStroke
         UBGraphicsStroke* simplify();
 
     protected:
+        static QList<QPair<QPointF, qreal> > simplifyPoints(const QList<QPair<QPointF, qreal> >& points, qreal tolerance);
+
         void addPolygon(UBGraphicsPolygonItem* pol);
 
     private:
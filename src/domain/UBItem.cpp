@@ -45,6 +45,7 @@
 UBItem::UBItem()
     : mUuid(QUuid())
     , mRenderingQuality(UBItem::RenderingQualityNormal)
+    , mCacheBehavior(UBItem::CacheAllowed)
 {
     // NOOP
 }
@@ -78,6 +78,11 @@ class UBItem
             mRenderingQuality = pRenderingQuality;
         }
 
+        virtual CacheBehavior cacheBehavior() const
+        {
+            return mCacheBehavior;
+        }
+
         virtual void setCacheBehavior(CacheBehavior cacheBehavior)
         {
             mCacheBehavior = cacheBehavior;
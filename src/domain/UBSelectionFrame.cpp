@@ -28,6 +28,7 @@
 #include "UBSelectionFrame.h"
 
 #include <QtGui>
+#include <QStyleOptionGraphicsItem>
 
 #include "domain/UBItem.h"
 #include "domain/UBGraphicsItemZLevelUndoCommand.h"
@@ -41,9 +42,60 @@
 #include "board/UBBoardView.h"
 #include "board/UBDrawingController.h"
 
+#include "core/memcheck.h"
+
+static bool containsWidget(QGraphicsItem *pItem)
+{
+    if (pItem->isWidget())
+        return true;
+
+    foreach (QGraphicsItem *child, pItem->childItems()) {
+        if (containsWidget(child))
+            return true;
+    }
+
+    return false;
+}
+
+static bool zValueLessThan(QGraphicsItem *A, QGraphicsItem *B)
+{
+    return A->zValue() < B->zValue();
+}
+
+static void paintItemTree(QPainter *painter, QGraphicsItem *pItem, const QTransform &pLayerTransform)
+{
+    if (!pItem->isVisible() || pItem->data(UBGraphicsItemData::ItemLayerType).toInt() == UBItemLayerType::Control)
+        return;
+
+    QList<QGraphicsItem*> children = pItem->childItems();
+    std::stable_sort(children.begin(), children.end(), zValueLessThan);
+
+    foreach (QGraphicsItem *child, children) {
+        if (child->flags() & QGraphicsItem::ItemStacksBehindParent)
+            paintItemTree(painter, child, pLayerTransform);
+    }
+
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = pItem->boundingRect();
+
+    painter->save();
+    painter->setTransform(pItem->sceneTransform() * pLayerTransform);
+    painter->setOpacity(pItem->effectiveOpacity());
+    pItem->paint(painter, &option, 0);
+    painter->restore();
+
+    foreach (QGraphicsItem *child, children) {
+        if (!(child->flags() & QGraphicsItem::ItemStacksBehindParent))
+            paintItemTree(painter, child, pLayerTransform);
+    }
+}
+
 UBSelectionFrame::UBSelectionFrame()
     : mThickness(UBSettings::settings()->objectFrameWidth)
     , mAntiscaleRatio(1.0)
+    , mEnclosedItemsAreTopLevel(true)
+    , mEnclosedItemsMoveWithFrame(false)
+    , mDragLayerItem(0)
     , mRotationAngle(0)
     , mDeleteButton(0)
     , mDuplicateButton(0)
@@ -104,13 +156,15 @@ QPainterPath UBSelectionFrame::shape() const
 
 void UBSelectionFrame::setEnclosedItems(const QList<QGraphicsItem*> pGraphicsItems)
 {
+    endDragLayer();
+
     mButtons.clear();
     mButtons.append(mDeleteButton);
     mRotationAngle = 0;
 
-    QRegion resultRegion;
     UBGraphicsFlags resultFlags;
     mEnclosedtems.clear();
+    mEnclosedItemsAreTopLevel = true;
 
     // If at least one of the enclosed items is locked, the entire selection is
     // considered to be locked.
@@ -121,12 +175,12 @@ void UBSelectionFrame::setEnclosedItems(const QList<QGraphicsItem*> pGraphicsIte
         if (nextDelegate) {
             mIsLocked = (mIsLocked || nextDelegate->isLocked());
             mEnclosedtems.append(nextDelegate);
-            resultRegion |= nextItem->boundingRegion(nextItem->sceneTransform());
+            mEnclosedItemsAreTopLevel = (mEnclosedItemsAreTopLevel && !nextItem->parentItem());
             resultFlags |= nextDelegate->ubflags();
         }
     }
 
-    QRectF resultRect = resultRegion.boundingRect();
+    QRectF resultRect = enclosedItemsRect();
     setRect(resultRect);
 
     mButtons = buttonsForFlags(resultFlags);
@@ -147,21 +201,141 @@ void UBSelectionFrame::setEnclosedItems(const QList<QGraphicsItem*> pGraphicsIte
 
 void UBSelectionFrame::updateRect()
 {
-    QRegion resultRegion;
+    setFrameRect(enclosedItemsRect());
+}
+
+// a move offsets the item transforms, which maps to the same scene offset only for top level items
+// without their own rotation or scale (CFF imports are rotated, pdf pages scaled on load)
+bool UBSelectionFrame::enclosedItemsMoveWithFrame() const
+{
+    if (!mEnclosedItemsAreTopLevel)
+        return false;
+
     foreach (UBGraphicsItemDelegate *curDelegateItem, mEnclosedtems) {
-        resultRegion |= curDelegateItem->delegated()->boundingRegion(curDelegateItem->delegated()->sceneTransform());
+        QGraphicsItem *item = curDelegateItem->delegated();
+        if (item->rotation() != 0 || item->scale() != 1)
+            return false;
     }
 
-    QRectF result = resultRegion.boundingRect();
-    setRect(result);
+    return true;
+}
 
-    placeButtons();
+QRectF UBSelectionFrame::enclosedItemsRect() const
+{
+    QRectF result;
+    foreach (UBGraphicsItemDelegate *curDelegateItem, mEnclosedtems) {
+        result |= curDelegateItem->delegated()->sceneBoundingRect();
+    }
 
-    if (result.isEmpty()) {
+    return result;
+}
+
+void UBSelectionFrame::setFrameRect(const QRectF& pRect)
+{
+    if (pRect != rect()) {
+        setRect(pRect);
+        placeButtons();
+    }
+
+    if (pRect.isEmpty()) {
         setVisible(false);
     }
 }
 
+bool UBSelectionFrame::beginDragLayer()
+{
+    if (!mEnclosedItemsMoveWithFrame || mEnclosedtems.isEmpty() || rect().isEmpty())
+        return false;
+
+    // live content such as widgets and media is not drawn through paint(), those selections move item by item
+    foreach (UBGraphicsItemDelegate *curDelegate, mEnclosedtems) {
+        if (containsWidget(curDelegate->delegated()))
+            return false;
+    }
+
+    QRectF layerRect = rect();
+
+    // render at the view resolution, bounded to keep the layer reasonable on huge selections
+    const qreal maxLayerSide = 4096;
+    qreal layerScale = 1 / mAntiscaleRatio;
+    layerScale = qMin(layerScale, maxLayerSide / qMax(layerRect.width(), layerRect.height()));
+
+    QSize layerSize = (layerRect.size() * layerScale).toSize().expandedTo(QSize(1, 1));
+    QPixmap layer(layerSize);
+    layer.fill(Qt::transparent);
+
+    QTransform layerTransform;
+    layerTransform.scale(layerSize.width() / layerRect.width(), layerSize.height() / layerRect.height());
+    layerTransform.translate(-layerRect.left(), -layerRect.top());
+
+    QList<QGraphicsItem*> items = sortedByZ(enclosedGraphicsItems());
+
+    QPainter painter(&layer);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    foreach (QGraphicsItem *item, items) {
+        paintItemTree(&painter, item, layerTransform);
+    }
+    painter.end();
+
+    // the layer is drawn by an item of the selection's own layer and z value rather than by the frame,
+    // which is on the control layer, so the display view and podcasts show it as well
+    int layerType = UBItemLayerType::FixedBackground;
+    qreal layerZ = items.first()->zValue();
+    foreach (QGraphicsItem *item, items) {
+        layerType = qMax(layerType, item->data(UBGraphicsItemData::ItemLayerType).toInt());
+        layerZ = qMax(layerZ, item->zValue());
+    }
+
+    mDragLayerItem = new QGraphicsPixmapItem(layer);
+    mDragLayerItem->setTransformationMode(Qt::SmoothTransformation);
+    mDragLayerItem->setAcceptedMouseButtons(Qt::NoButton);
+    mDragLayerItem->setTransform(layerTransform.inverted());
+    mDragLayerItem->setZValue(layerZ);
+    mDragLayerItem->setData(UBGraphicsItemData::ItemLayerType, QVariant(layerType));
+
+    // not through UBGraphicsScene::addItem, the layer is not part of the page
+    scene()->QGraphicsScene::addItem(mDragLayerItem);
+
+    mDragLayerOffset = QPointF();
+    mDragLayerOpacities.clear();
+
+    // the items stay selected and in place, they are only made transparent while the layer stands in for them
+    foreach (UBGraphicsItemDelegate *curDelegate, mEnclosedtems) {
+        mDragLayerOpacities.append(curDelegate->delegated()->opacity());
+        curDelegate->delegated()->setOpacity(0);
+    }
+
+    return true;
+}
+
+void UBSelectionFrame::endDragLayer()
+{
+    if (!mDragLayerItem)
+        return;
+
+    for (int i = 0; i < mEnclosedtems.count(); i++) {
+        QGraphicsItem *item = mEnclosedtems.at(i)->delegated();
+
+        if (!mDragLayerOffset.isNull()) {
+            QTransform ownTransform = item->transform();
+            item->setTransform(QTransform(
+                        ownTransform.m11(), ownTransform.m12(), ownTransform.m13()
+                        , ownTransform.m21(), ownTransform.m22(), ownTransform.m23()
+                        , ownTransform.m31() + mDragLayerOffset.x(), ownTransform.m32() + mDragLayerOffset.y(), ownTransform.m33()));
+        }
+
+        item->setOpacity(mDragLayerOpacities.value(i, 1.0));
+    }
+
+    if (mDragLayerItem->scene())
+        mDragLayerItem->scene()->QGraphicsScene::removeItem(mDragLayerItem);
+    delete mDragLayerItem;
+    mDragLayerItem = 0;
+
+    mDragLayerOffset = QPointF();
+    mDragLayerOpacities.clear();
+}
+
 void UBSelectionFrame::updateScale()
 {
     setScale(-UBApplication::boardController->currentZoom());
@@ -172,6 +346,7 @@ void UBSelectionFrame::mousePressEvent(QGraphicsSceneMouseEvent *event)
     mPressedPos = mLastMovedPos = event->pos();
     mLastTranslateOffset = QPointF();
     mRotationAngle = 0;
+    mEnclosedItemsMoveWithFrame = enclosedItemsMoveWithFrame();
 
     if (scene()->itemAt(event->scenePos(), transform()) == mRotateButton) {
         mOperationMode = om_rotating;
@@ -187,6 +362,18 @@ void UBSelectionFrame::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 
     QPointF dp = event->pos() - mPressedPos;
     QPointF rotCenter = mapToScene(rect().center());
+    QPointF moveDelta = dp - mLastTranslateOffset;
+
+    if (mOperationMode == om_moving && (mDragLayerItem || beginDragLayer())) {
+        // the items get their transform once, on release
+        mDragLayerOffset += moveDelta;
+        mDragLayerItem->setPos(mDragLayerOffset);
+        setFrameRect(rect().translated(moveDelta));
+
+        mLastMovedPos = event->pos();
+        mLastTranslateOffset = dp;
+        return;
+    }
 
     foreach (UBGraphicsItemDelegate *curDelegate, mEnclosedtems) {
 
@@ -203,8 +390,8 @@ void UBSelectionFrame::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
                         , ownTransform.m22()
                         , ownTransform.m23()
 
-                        , ownTransform.m31() + (dp - mLastTranslateOffset).x()
-                        , ownTransform.m32() + (dp - mLastTranslateOffset).y()
+                        , ownTransform.m31() + moveDelta.x()
+                        , ownTransform.m32() + moveDelta.y()
                         , ownTransform.m33()
                         );
 
@@ -240,7 +427,12 @@ void UBSelectionFrame::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 
     }
 
-    updateRect();
+    // items moved by the same scene offset keep their union, translated by that offset
+    if (mOperationMode == om_moving && mEnclosedItemsMoveWithFrame)
+        setFrameRect(rect().translated(moveDelta));
+    else
+        updateRect();
+
     mLastMovedPos = event->pos();
     mLastTranslateOffset = dp;
 }
@@ -249,6 +441,8 @@ void UBSelectionFrame::mouseReleaseEvent(QGraphicsSceneMouseEvent */*event*/)
 {
     mPressedPos = mLastMovedPos = mLastTranslateOffset = QPointF();
 
+    endDragLayer();
+
     if (mOperationMode == om_moving || mOperationMode == om_rotating) {
         UBApplication::undoStack->beginMacro(UBSettings::undoCommandTransactionName);
         foreach (UBGraphicsItemDelegate *d, mEnclosedtems) {
@@ -90,17 +90,29 @@ private:
     QList<DelegateButton*> buttonsForFlags(UBGraphicsFlags fls);
 
     QList<QGraphicsItem*> enclosedGraphicsItems();
+    QRectF enclosedItemsRect() const;
+    bool enclosedItemsMoveWithFrame() const;
+    void setFrameRect(const QRectF& pRect);
+    bool beginDragLayer();
+    void endDragLayer();
 
 
 private:
     int mThickness;
     qreal mAntiscaleRatio;
     QList<UBGraphicsItemDelegate*> mEnclosedtems;
+    bool mEnclosedItemsAreTopLevel;
+    bool mEnclosedItemsMoveWithFrame;
     QBrush mLocalBrush;
 
     QPointF mPressedPos;
     QPointF mLastMovedPos;
     QPointF mLastTranslateOffset;
+
+    // while moving, the enclosed items are drawn from one cached layer standing in for them
+    QGraphicsPixmapItem *mDragLayerItem;
+    QPointF mDragLayerOffset;
+    QList<qreal> mDragLayerOpacities;
     qreal mRotationAngle;
 
     bool mIsLocked;
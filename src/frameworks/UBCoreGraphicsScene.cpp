@@ -38,6 +38,7 @@
 UBCoreGraphicsScene::UBCoreGraphicsScene(QObject * parent)
     : QGraphicsScene ( parent  )
     , mIsModified(true)
+    , mHasThumbnailDamage(true)
 {
     //NOOP
 }
@@ -73,18 +74,39 @@ void UBCoreGraphicsScene::addItem(QGraphicsItem* item)
     if (item->scene() != this)
         QGraphicsScene::addItem(item);
 
-    setModified(true);
+    setModified(item->sceneBoundingRect());
 }
 
 
 void UBCoreGraphicsScene::removeItem(QGraphicsItem* item, bool forceDelete)
 {
+    QRectF itemArea = item->sceneBoundingRect();
+
     QGraphicsScene::removeItem(item);
     if (forceDelete)
     {
         deleteItem(item);
     }
-    setModified(true);
+    setModified(itemArea);
+}
+
+void UBCoreGraphicsScene::setModified(const QRectF& changedArea)
+{
+    mIsModified = true;
+
+    // nothing visible changed, e.g. an item without geometry
+    if (changedArea.isNull())
+        return;
+
+    if (!mHasThumbnailDamage)
+    {
+        mHasThumbnailDamage = true;
+        mThumbnailDamage = changedArea;
+    }
+    else if (!mThumbnailDamage.isNull())
+    {
+        mThumbnailDamage = mThumbnailDamage.united(changedArea);
+    }
 }
 
 bool UBCoreGraphicsScene::deleteItem(QGraphicsItem* item)
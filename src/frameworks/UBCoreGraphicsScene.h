@@ -57,6 +57,33 @@ class UBCoreGraphicsScene : public QGraphicsScene
         void setModified(bool pModified)
         {
             mIsModified = pModified;
+
+            if (pModified)
+            {
+                mHasThumbnailDamage = true;
+                mThumbnailDamage = QRectF();
+            }
+        }
+
+        // marks the scene modified by a change confined to changedArea, in scene coordinates
+        void setModified(const QRectF& changedArea);
+
+        // whether the scene changed since its thumbnail was last generated
+        bool hasThumbnailDamage() const
+        {
+            return mHasThumbnailDamage;
+        }
+
+        // the area changed since the last thumbnail, a null rect when the whole scene may have changed
+        QRectF thumbnailDamage() const
+        {
+            return mThumbnailDamage;
+        }
+
+        void clearThumbnailDamage()
+        {
+            mHasThumbnailDamage = false;
+            mThumbnailDamage = QRectF();
         }
 
 
@@ -64,6 +91,9 @@ class UBCoreGraphicsScene : public QGraphicsScene
         QSet<QGraphicsItem*> mItemsToDelete;
 
         bool mIsModified;
+
+        bool mHasThumbnailDamage;
+        QRectF mThumbnailDamage;
 };
 
 #endif /* UBCOREGRAPHICSSCENE_H_ */
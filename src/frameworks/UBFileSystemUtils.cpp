@@ -32,9 +32,14 @@
 #include <QtGui>
 
 #include "core/UBApplication.h"
+#include "core/UBDocumentJournal.h"
+
+#include "frameworks/UBPlatformUtils.h"
 
 #include "globals/UBGlobals.h"
 
+#include <QtConcurrent>
+
 THIRD_PARTY_WARNINGS_DISABLE
 #ifdef Q_OS_OSX
     #include <quazipfile.h>
@@ -118,6 +123,43 @@ bool UBFileSystemUtils::copyFile(const QString &source, const QString &destinati
     return QFile::copy(source, normalizedDestination);
 }
 
+bool UBFileSystemUtils::shareOrCopyFile(const QString &source, const QString &destination)
+{
+    if (!QFile::exists(destination))
+    {
+        QDir().mkpath(QFileInfo(destination).absolutePath());
+
+        if (UBPlatformUtils::shareFile(source, destination))
+            return true;
+    }
+
+    return copyFile(source, destination);
+}
+
+bool UBFileSystemUtils::shareOrCopyDir(const QString& pSourceDirPath, const QString& pTargetDirPath)
+{
+    if (pSourceDirPath == "" || pSourceDirPath == "." || pSourceDirPath == "..")
+        return false;
+
+    QDir dirSource(pSourceDirPath);
+
+    if (!QDir().mkpath(pTargetDirPath))
+        return false;
+
+    foreach(QFileInfo dirContent, dirSource.entryInfoList(QDir::Files | QDir::Dirs
+            | QDir::NoDotAndDotDot | QDir::Hidden , QDir::Name))
+    {
+        QString source = pSourceDirPath + "/" + dirContent.fileName();
+        QString target = pTargetDirPath + "/" + dirContent.fileName();
+
+        bool success = dirContent.isDir() ? shareOrCopyDir(source, target) : shareOrCopyFile(source, target);
+        if (!success)
+            return false;
+    }
+
+    return true;
+}
+
 bool UBFileSystemUtils::copy(const QString &source, const QString &destination, bool overwrite)
 {
     if (QFileInfo(source).isDir()) {
@@ -642,16 +684,164 @@ QString UBFileSystemUtils::getFirstExistingFileFromList(const QString& path, con
 }
 
 
+// already compressed media are stored as is, deflating them again costs time for no gain
+static bool isCompressedFormat(const QString& suffix)
+{
+    static const QStringList compressedSuffixes = QStringList()
+            << "jpg" << "jpeg" << "png" << "gif" << "webp" << "pdf" << "zip" << "ubz" << "wgz"
+            << "mp4" << "m4v" << "mov" << "avi" << "flv" << "webm" << "ogv" << "ogg" << "mp3" << "m4a" << "swf";
+
+    return compressedSuffixes.contains(suffix.toLower());
+}
+
+// files up to this size are deflated in memory on the thread pool, bigger ones are streamed
+static const qint64 maxDeflatedInMemorySize = 16 * 1024 * 1024;
+static const qint64 zipChunkSize = 1024 * 1024;
+
+struct UBDeflatedFile
+{
+    bool ok;
+    QByteArray data; // raw deflate stream, as stored in the zip entry
+    quint32 crc;
+    qint64 size;
+};
+
+static UBDeflatedFile deflateFile(const QString& pFilePath)
+{
+    UBDeflatedFile deflated;
+    deflated.ok = false;
+    deflated.crc = 0;
+    deflated.size = 0;
+
+    QFile inFile(pFilePath);
+    if (!inFile.open(QIODevice::ReadOnly))
+        return deflated;
+
+    QByteArray data = inFile.readAll();
+    inFile.close();
+
+    deflated.size = data.size();
+    deflated.crc = crc32(0L, reinterpret_cast<const Bytef*>(data.constData()), data.size());
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return deflated;
+
+    deflated.data.resize(deflateBound(&stream, data.size()));
+
+    stream.next_in = reinterpret_cast<Bytef*>(data.data());
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(deflated.data.data());
+    stream.avail_out = deflated.data.size();
+
+    deflated.ok = (deflate(&stream, Z_FINISH) == Z_STREAM_END);
+    deflated.data.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    return deflated;
+}
+
+static bool writeFileInZip(const QFileInfo& file, const QString& pDestPath, QuaZipFile *pOutZipFile, QFuture<UBDeflatedFile> *deflating)
+{
+    QFile inFile(file.absoluteFilePath());
+    if(!inFile.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: inFile.open(): " << inFile.errorString();
+        return false;
+    }
+
+    qDebug() << "will open" << pDestPath << file.fileName() << inFile.fileName();
+
+    UBDeflatedFile deflated;
+    deflated.ok = false;
+    if (deflating)
+        deflated = deflating->result();
+
+    bool opened;
+    if (deflated.ok)
+    {
+        // written raw, the data is already deflated
+        QuaZipNewInfo info(pDestPath + file.fileName(), inFile.fileName());
+        info.uncompressedSize = deflated.size;
+        opened = pOutZipFile->open(QIODevice::WriteOnly, info, NULL, deflated.crc, Z_DEFLATED, Z_DEFAULT_COMPRESSION, true);
+    }
+    else
+    {
+        int method = isCompressedFormat(file.suffix()) ? 0 : Z_DEFLATED;
+        opened = pOutZipFile->open(QIODevice::WriteOnly, QuaZipNewInfo(pDestPath + file.fileName(), inFile.fileName()), NULL, 0, method);
+    }
+
+    if(!opened)
+    {
+        qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.open(): " << pOutZipFile->getZipError();
+        inFile.close();
+        return false;
+    }
+
+    if (deflated.ok)
+        pOutZipFile->write(deflated.data);
+    else
+        while (!inFile.atEnd() && pOutZipFile->getZipError() == UNZ_OK)
+            pOutZipFile->write(inFile.read(zipChunkSize));
+
+    if(pOutZipFile->getZipError() != UNZ_OK)
+    {
+        qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.write(): " << pOutZipFile->getZipError();
+
+        inFile.close();
+        pOutZipFile->close();
+        return false;
+    }
+
+    pOutZipFile->close();
+    if(pOutZipFile->getZipError() != UNZ_OK)
+    {
+        qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.close(): " << pOutZipFile->getZipError();
+
+        inFile.close();
+        return false;
+    }
+
+    inFile.close();
+
+    return true;
+}
+
 bool UBFileSystemUtils::compressDirInZip(const QDir& pDir, const QString& pDestPath, QuaZipFile *pOutZipFile, bool pRootDocumentFolder, UBProcessingProgressListener* progressListener)
 {
     QFileInfoList files = pDir.entryInfoList(QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
 
+    // a save interrupted or in progress leaves its journal files in the document folder
+    if (pRootDocumentFolder)
+    {
+        for (int i = files.size() - 1; i >= 0; i--)
+        {
+            if (files.at(i).isFile() && UBDocumentJournal::isJournalFile(files.at(i).fileName()))
+                files.removeAt(i);
+        }
+    }
+
     QStringList filters;
     filters << "*.svg";
     QFileInfoList pageFiles = pDir.entryInfoList(filters);
 
-    foreach (QFileInfo file, files)
+    // text files (pages, metadata, widgets) are deflated on the thread pool a few files ahead of being written
+    QMap<int, QFuture<UBDeflatedFile> > deflatingFiles;
+    int maxDeflatingFiles = 2 * QThread::idealThreadCount();
+    int nextFileToDeflate = 0;
+
+    for (int i = 0; i < files.size(); i++)
     {
+        const QFileInfo& file = files.at(i);
+
+        for (; nextFileToDeflate < files.size() && deflatingFiles.size() < maxDeflatingFiles; nextFileToDeflate++)
+        {
+            const QFileInfo& fileToDeflate = files.at(nextFileToDeflate);
+            if (fileToDeflate.isFile() && !isCompressedFormat(fileToDeflate.suffix()) && fileToDeflate.size() <= maxDeflatedInMemorySize)
+                deflatingFiles.insert(nextFileToDeflate, QtConcurrent::run(deflateFile, fileToDeflate.absoluteFilePath()));
+        }
+
         if (file.isDir())
         {
             QDir dir(file.absoluteFilePath());
@@ -676,7 +866,7 @@ bool UBFileSystemUtils::compressDirInZip(const QDir& pDir, const QString& pDestP
             if (!pRootDocumentFolder)
             {
                 if (progressListener)
-                    progressListener->processing(objectType, files.indexOf(file), files.size());
+                    progressListener->processing(objectType, i, files.size());
             }
             // we ignore thumbnails message because it is very fast.
             else if (progressListener && file.suffix() == "svg")
@@ -684,42 +874,10 @@ bool UBFileSystemUtils::compressDirInZip(const QDir& pDir, const QString& pDestP
                 progressListener->processing(objectType, pageFiles.indexOf(file), pageFiles.size());
             }
 
-            QFile inFile(file.absoluteFilePath());
-            if(!inFile.open(QIODevice::ReadOnly))
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: inFile.open(): " << inFile.errorString();
-                return false;
-            }
-
-            qDebug() << "will open" << pDestPath << file.fileName() << inFile.fileName();
-
-            if(!pOutZipFile->open(QIODevice::WriteOnly, QuaZipNewInfo(pDestPath + file.fileName(), inFile.fileName())))
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.open(): " << pOutZipFile->getZipError();
-                inFile.close();
-                return false;
-            }
-
-            pOutZipFile->write(inFile.readAll());
-            if(pOutZipFile->getZipError() != UNZ_OK)
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.write(): " << pOutZipFile->getZipError();
-
-                inFile.close();
-                pOutZipFile->close();
+            bool isDeflating = deflatingFiles.contains(i);
+            QFuture<UBDeflatedFile> deflating = deflatingFiles.take(i);
+            if (!writeFileInZip(file, pDestPath, pOutZipFile, isDeflating ? &deflating : 0))
                 return false;
-            }
-
-            pOutZipFile->close();
-            if(pOutZipFile->getZipError() != UNZ_OK)
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.close(): " << pOutZipFile->getZipError();
-
-                inFile.close();
-                return false;
-            }
-
-            inFile.close();
         }
     }
 
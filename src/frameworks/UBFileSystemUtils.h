@@ -68,6 +68,11 @@ class UBFileSystemUtils : public QObject
 
         static bool copyFile(const QString &source, const QString &destination, bool overwrite = false);
 
+        // for files that are never written in place: shares their content when the filesystem allows it, copies them otherwise
+        static bool shareOrCopyFile(const QString &source, const QString &destination);
+
+        static bool shareOrCopyDir(const QString& pSourceDirPath, const QString& pTargetDirPath);
+
         static bool copy(const QString &source, const QString &Destination, bool overwrite = false);
 
         static QString cleanName(const QString& name);
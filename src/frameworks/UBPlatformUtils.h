@@ -193,6 +193,9 @@ public:
         static QString applicationResourcesDirectory();
         static void hideFile(const QString &filePath);
         static void setFileType(const QString &filePath, unsigned long fileType);
+        // makes destination share the content of source (copy-on-write clone, or hard link) instead of copying it;
+        // only for files that are never written in place
+        static bool shareFile(const QString &source, const QString &destination);
         static void fadeDisplayOut();
         static void fadeDisplayIn();
         static QString translationPath(QString pFilePrefix, QString pLanguage);
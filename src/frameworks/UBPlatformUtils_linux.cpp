@@ -33,6 +33,9 @@
 #include <QApplication>
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 #include <X11/keysym.h>
 
 #include "frameworks/UBFileSystemUtils.h"
@@ -62,6 +65,38 @@ void UBPlatformUtils::setFileType(const QString &filePath, unsigned long fileTyp
     // No fileType equivalent on Linux
 }
 
+bool UBPlatformUtils::shareFile(const QString &source, const QString &destination)
+{
+    QByteArray sourcePath = QFile::encodeName(source);
+    QByteArray destinationPath = QFile::encodeName(destination);
+
+#ifdef FICLONE
+    // reflink on filesystems that support it (btrfs, xfs, ...)
+    int sourceFd = ::open(sourcePath.constData(), O_RDONLY);
+    if (sourceFd >= 0)
+    {
+        int destinationFd = ::open(destinationPath.constData(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (destinationFd >= 0)
+        {
+            bool cloned = ::ioctl(destinationFd, FICLONE, sourceFd) == 0;
+            ::close(destinationFd);
+            ::close(sourceFd);
+
+            if (cloned)
+                return true;
+
+            ::unlink(destinationPath.constData());
+        }
+        else
+        {
+            ::close(sourceFd);
+        }
+    }
+#endif
+
+    return ::link(sourcePath.constData(), destinationPath.constData()) == 0;
+}
+
 void UBPlatformUtils::fadeDisplayOut()
 {
     // NOOP
@@ -34,6 +34,9 @@
 
 #include <QWidget>
 
+#include <unistd.h>
+#include <sys/clonefile.h>
+
 #import <Foundation/NSAutoreleasePool.h>
 #import <Cocoa/Cocoa.h>
 #import <Carbon/Carbon.h>
@@ -187,6 +190,18 @@ void UBPlatformUtils::setFileType(const QString &filePath, unsigned long fileTyp
 
 static CGDisplayFadeReservationToken token = NULL;
 
+bool UBPlatformUtils::shareFile(const QString &source, const QString &destination)
+{
+    QByteArray sourcePath = QFile::encodeName(source);
+    QByteArray destinationPath = QFile::encodeName(destination);
+
+    // copy-on-write clone on APFS, hard link elsewhere
+    if (clonefile(sourcePath.constData(), destinationPath.constData(), 0) == 0)
+        return true;
+
+    return ::link(sourcePath.constData(), destinationPath.constData()) == 0;
+}
+
 void UBPlatformUtils::fadeDisplayOut()
 {
     if (CGAcquireDisplayFadeReservation(1.2, &token) == kCGErrorSuccess)
@@ -64,6 +64,12 @@ void UBPlatformUtils::setFileType(const QString &filePath, unsigned long fileTyp
     // Probably no fileType equivalent on Windows
 }
 
+bool UBPlatformUtils::shareFile(const QString &source, const QString &destination)
+{
+    return CreateHardLinkW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(destination).utf16()),
+                           reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(source).utf16()), NULL);
+}
+
 void UBPlatformUtils::fadeDisplayOut()
 {
     // NOOP
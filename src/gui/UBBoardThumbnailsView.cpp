@@ -80,6 +80,7 @@ UBBoardThumbnailsView::UBBoardThumbnailsView(QWidget *parent, const char *name)
     connect(this, SIGNAL(moveThumbnailRequired(int, int)), this, SLOT(moveThumbnail(int, int)), Qt::UniqueConnection);
     connect(UBApplication::boardController, SIGNAL(updateThumbnailsRequired()), this, SLOT(updateThumbnails()), Qt::UniqueConnection);
     connect(UBApplication::boardController, SIGNAL(removeThumbnailRequired(int)), this, SLOT(removeThumbnail(int)), Qt::UniqueConnection);
+    connect(UBApplication::boardController, SIGNAL(removeThumbnailsRequired(QList<int>)), this, SLOT(removeThumbnails(QList<int>)), Qt::UniqueConnection);
 
     connect(&mLongPressTimer, SIGNAL(timeout()), this, SLOT(longPressTimeout()), Qt::UniqueConnection);
 
@@ -113,6 +114,25 @@ void UBBoardThumbnailsView::removeThumbnail(int i)
     updateThumbnailsPos();
 }
 
+void UBBoardThumbnailsView::removeThumbnails(const QList<int>& indexes)
+{
+    // indexes refer to the pages before deletion, remove from the last one so they stay valid
+    QList<int> sortedIndexes = indexes.toSet().toList();
+    qSort(sortedIndexes.begin(), sortedIndexes.end(), qGreater<int>());
+
+    foreach(int i, sortedIndexes)
+    {
+        UBDraggableThumbnailView* item = mThumbnails.at(i);
+
+        scene()->removeItem(item->pageNumber());
+        scene()->removeItem(item);
+
+        mThumbnails.removeAt(i);
+    }
+
+    updateThumbnailsPos();
+}
+
 UBDraggableThumbnailView* UBBoardThumbnailsView::createThumbnail(UBDocumentContainer* source, int i)
 {
     UBApplication::showMessage(tr("Loading page (%1/%2)").arg(i+1).arg(source->selectedDocument()->pageCount()));
@@ -53,6 +53,7 @@ public slots:
     void addThumbnail(UBDocumentContainer* source, int i);
     void moveThumbnail(int from, int to);
     void removeThumbnail(int i);
+    void removeThumbnails(const QList<int>& indexes);
     void updateThumbnails();
 
     void longPressTimeout();
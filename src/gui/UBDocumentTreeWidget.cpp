@@ -32,6 +32,7 @@
 #include "core/UBSettings.h"
 #include "core/UBApplication.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBPageManifest.h"
 #include "core/UBMimeData.h"
 #include "core/UBApplicationController.h"
 #include "core/UBDocumentManager.h"
@@ -299,8 +300,8 @@ void UBDocumentTreeWidget::dropEvent(QDropEvent *event)
 
                             //due to incorrect generation of thumbnails of invisible scene I've used direct copying of thumbnail files
                             //it's not universal and good way but it's faster
-                            QString from = sourceItem.documentProxy()->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", sourceItem.sceneIndex());
-                            QString to  = targetDocProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", targetDocProxy->pageCount());
+                            QString from = UBPageManifest::thumbnailFilePath(sourceItem.documentProxy()->persistencePath(), sourceItem.sceneIndex());
+                            QString to  = UBPageManifest::thumbnailFilePath(targetDocProxy->persistencePath(), targetDocProxy->pageCount() - 1);
                             QFile::remove(to);
                             QFile::copy(from, to);
                           }
@@ -407,6 +407,11 @@ void UBFeaturesWidget::importImage(const QImage &image, const QString &fileName)
     controller->importImage(image, fileName);
 }
 
+void UBFeaturesWidget::importEncodedImage(const QByteArray &imageData, const QString &fileName)
+{
+    controller->importEncodedImage(imageData, fileName);
+}
+
 UBFeaturesListView::UBFeaturesListView( QWidget* parent, const char* name )
     : QListView(parent)
 {
@@ -95,6 +95,7 @@ public:
     }
     UBFeaturesController * getFeaturesController() const { return controller; }
     void importImage(const QImage &image, const QString &fileName = QString());
+    void importEncodedImage(const QByteArray &imageData, const QString &fileName);
 
     static const int minThumbnailSize = 20;
     static const int maxThumbnailSize = 100;
@@ -33,19 +33,40 @@
 #include "board/UBBoardController.h"
 #include "domain/UBGraphicsScene.h"
 #include "board/UBBoardView.h"
+#include "core/UBTrace.h"
 
 #include "core/memcheck.h"
 
+// side of a cached tile, in pixels
+static const int sTileSize = 256;
+// tile cache budget, in kilobytes
+static const int sMaxTileCacheCost = 48 * 1024;
+
+static quint64 tileKey(const QPoint &tile)
+{
+    return (quint64(quint32(tile.x())) << 32) | quint32(tile.y());
+}
+
+static QRectF tileSceneRect(quint64 key, qreal scale)
+{
+    qreal side = sTileSize / scale;
+    return QRectF(qint32(key >> 32) * side, qint32(key & 0xffffffff) * side, side, side);
+}
+
 
 UBMagnifier::UBMagnifier(QWidget *parent, bool isInteractive)
     : QWidget(parent, parent ? Qt::Widget : Qt::Tool | (Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::X11BypassWindowManagerHint))
     , mShouldMoveWidget(false)
     , mShouldResizeWidget(false)
     , borderPen(Qt::darkGray)
+    , mCacheScale(0)
+    , mSourceDamaged(true)
+    , mOutputOutdated(true)
     , gView(0)
     , mView(0)
 {
     isCusrsorAlreadyStored = false;
+    mTileCache.setMaxCost(sMaxTileCacheCost);
     setMouseTracking(true);
 
     //--------------------------------------------------//
@@ -172,14 +193,17 @@ void UBMagnifier::createMask()
 
     bmpMask = QBitmap::fromImage(mask_img);
 
-    pMap = QPixmap(width(), height());
+    if (pMap.size() != size())
+        pMap = QPixmap(width(), height());
     pMap.fill(Qt::transparent);
     pMap.setMask(bmpMask);
+    mOutputOutdated = true;
 }
 
 void UBMagnifier::setZoom(qreal zoom)
 {
     params.zoom = zoom;
+    mOutputOutdated = true;
 }
 
 
@@ -353,8 +377,9 @@ void UBMagnifier::mouseReleaseEvent(QMouseEvent * event)
 
 void UBMagnifier::slot_refresh()
 {
+    // cheap when neither the view nor the covered part of the scene changed
     if(!(updPointGrab.isNull()))
-        grabPoint(updPointGrab);
+        grab();
 
     if(isCusrsorAlreadyStored)
     {
@@ -372,68 +397,170 @@ void UBMagnifier::slot_refresh()
     }
 }
 
+bool UBMagnifier::eventFilter(QObject *object, QEvent *event)
+{
+    QGraphicsView *view = qobject_cast<QGraphicsView*>(gView);
+
+    // Any repaint of the grabbed view may come from a change of the scene, be it an edit, a video
+    // frame, an animated widget or a hover highlight. A magnifier update also repaints the view
+    // beneath it: the tiles rendered again then come out identical and no further update follows.
+    if (object == mGrabViewport && event->type() == QEvent::Paint && view && mCachedScene)
+    {
+        foreach (const QRect &rect, static_cast<QPaintEvent*>(event)->region().rects())
+            damage(view->mapToScene(rect).boundingRect());
+    }
+
+    return QWidget::eventFilter(object, event);
+}
+
+void UBMagnifier::damage(const QRectF &sceneRect)
+{
+    foreach (quint64 key, mTileCache.keys())
+    {
+        if (sceneRect.intersects(tileSceneRect(key, mCacheScale)))
+            mDamagedTiles.insert(key);
+    }
+
+    if (sceneRect.intersects(mLastSourceRect))
+        mSourceDamaged = true;
+}
+
 void UBMagnifier::grabPoint()
+{
+    mOutputOutdated = true;
+    grab();
+}
+
+void UBMagnifier::grabPoint(const QPoint &pGrab)
+{
+    updPointGrab = pGrab;
+    grab();
+}
+
+QRectF UBMagnifier::sourceRect(const QPoint &globalPoint) const
 {
     QMatrix transM = UBApplication::boardController->controlView()->matrix();
-    QPointF itemPos = gView->mapFromGlobal(updPointGrab);
+    QPointF itemPos = gView->mapFromGlobal(globalPoint);
 
     qreal zWidth = width() / (params.zoom * transM.m11());
-    qreal zWidthHalf = zWidth / 2;
     qreal zHeight = height() / (params.zoom * transM.m22());
-    qreal zHeightHalf = zHeight / 2;
-
 
     QPointF pfScLtF(UBApplication::boardController->controlView()->mapToScene(QPoint(itemPos.x(), itemPos.y())));
 
-    float x = pfScLtF.x() - zWidthHalf;
-    float y = pfScLtF.y() - zHeightHalf;
+    return QRectF(pfScLtF.x() - zWidth / 2, pfScLtF.y() - zHeight / 2, zWidth, zHeight);
+}
+
+QImage *UBMagnifier::cacheTile(const QPoint &tile, bool *changed)
+{
+    quint64 key = tileKey(tile);
+    QImage *image = mTileCache.object(key);
 
-    QPointF leftTop(x,y);
-    QPointF rightBottom(x + zWidth, y + zHeight);
-    QRectF srcRect(leftTop, rightBottom);
+    if (image && !mDamagedTiles.contains(key))
+        return image;
 
-    QPixmap newPixMap(QSize(width(), height()));
-    QPainter painter(&newPixMap);
+    UB_TRACE_SCOPE("UBMagnifier::renderTile");
 
-    UBApplication::boardController->activeScene()->render(&painter, QRectF(0,0,width(),height()), srcRect);
+    QImage rendered(sTileSize, sTileSize, QImage::Format_ARGB32_Premultiplied);
+    rendered.fill(Qt::transparent);
+    QPainter painter(&rendered);
+    mCachedScene->render(&painter, QRectF(0, 0, sTileSize, sTileSize), tileSceneRect(key, mCacheScale), Qt::IgnoreAspectRatio);
     painter.end();
 
-    pMap.fill(Qt::transparent);
-    pMap = newPixMap.scaled(QSize(width(), height()));
-    pMap.setMask(bmpMask);
+    mDamagedTiles.remove(key);
 
-    update();
+    if (!image)
+    {
+        image = new QImage(rendered);
+        mTileCache.insert(key, image, sTileSize * sTileSize * 4 / 1024);
+        *changed = true;
+    }
+    else if (*image != rendered)
+    {
+        *image = rendered;
+        *changed = true;
+    }
+
+    return image;
 }
 
-void UBMagnifier::grabPoint(const QPoint &pGrab)
+void UBMagnifier::grab()
 {
-    QMatrix transM = UBApplication::boardController->controlView()->matrix();
-    updPointGrab = pGrab;
-    QPointF itemPos = gView->mapFromGlobal(pGrab);
+    UBGraphicsScene *scene = UBApplication::boardController->activeScene();
+    if (!scene || !gView || size().isEmpty())
+        return;
 
-    qreal zWidth = width() / (params.zoom * transM.m11());
-    qreal zWidthHalf = zWidth / 2;
-    qreal zHeight = height() / (params.zoom * transM.m22());
-    qreal zHeightHalf = zHeight / 2;
+    UB_TRACE_SCOPE("UBMagnifier::grab");
 
+    // Tiles are rendered at the next power of two of the zoom, so zooming
+    // within a step scales the existing tiles down instead of rendering again.
+    qreal oversampling = 1;
+    while (oversampling < params.zoom)
+        oversampling *= 2;
+    qreal cacheScale = UBApplication::boardController->controlView()->matrix().m11() * oversampling;
 
-    QPointF pfScLtF(UBApplication::boardController->controlView()->mapToScene(QPoint(itemPos.x(), itemPos.y())));
+    if (scene != mCachedScene)
+    {
+        mCachedScene = scene;
+        mCacheScale = 0;
+    }
 
-    float x = pfScLtF.x() - zWidthHalf;
-    float y = pfScLtF.y() - zHeightHalf;
+    if (!qFuzzyCompare(cacheScale, mCacheScale))
+    {
+        mTileCache.clear();
+        mDamagedTiles.clear();
+        mCacheScale = cacheScale;
+        mOutputOutdated = true;
+    }
 
-    QPointF leftTop(x,y);
-    QPointF rightBottom(x + zWidth, y + zHeight);
-    QRectF srcRect(leftTop, rightBottom);
+    QRectF srcRect = sourceRect(updPointGrab);
+    bool moved = srcRect != mLastSourceRect;
+    if (!mSourceDamaged && !mOutputOutdated && !moved)
+        return;
 
-    QPixmap newPixMap(QSize(width(), height()));
-    QPainter painter(&newPixMap);
+    mLastSourceRect = srcRect;
+    mSourceDamaged = false;
+
+    // the covered area in cache pixels, snapped to whole pixels so that tiles
+    // are not resampled when the magnified image is drawn at the cache scale
+    QRectF cacheRect(QPointF(qRound(srcRect.left() * mCacheScale), qRound(srcRect.top() * mCacheScale)),
+                     srcRect.size() * mCacheScale);
+
+    int firstColumn = qFloor(cacheRect.left() / sTileSize);
+    int lastColumn = qFloor(cacheRect.right() / sTileSize);
+    int firstRow = qFloor(cacheRect.top() / sTileSize);
+    int lastRow = qFloor(cacheRect.bottom() / sTileSize);
+
+    // a damaged tile may render exactly as before, then there is nothing to update
+    bool tilesChanged = false;
+    QList<QPair<QPoint, QImage> > tiles;
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            QImage *tile = cacheTile(QPoint(column, row), &tilesChanged);
+            tiles << qMakePair(QPoint(column * sTileSize, row * sTileSize), *tile);
+        }
+    }
+
+    if (!tilesChanged && !mOutputOutdated && !moved)
+        return;
+
+    mOutputOutdated = false;
+
+    if (pMap.size() != size())
+        pMap = QPixmap(size());
+    pMap.fill(Qt::transparent);
+
+    QPainter painter(&pMap);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.scale(width() / cacheRect.width(), height() / cacheRect.height());
+    painter.translate(-cacheRect.topLeft());
+
+    for (int i = 0; i < tiles.size(); ++i)
+        painter.drawImage(tiles.at(i).first, tiles.at(i).second);
 
-    UBApplication::boardController->activeScene()->render(&painter, QRectF(0,0,width(),height()), srcRect);
     painter.end();
 
-   // pMap.fill(Qt::transparent);
-    pMap = newPixMap;
     pMap.setMask(bmpMask);
 
     update();
@@ -461,7 +588,16 @@ void UBMagnifier::grabNMove(const QPoint &pGrab, const QPoint &pMove, bool needG
 
 void UBMagnifier::setGrabView(QWidget *view)
 {
+    if (mGrabViewport)
+        mGrabViewport->removeEventFilter(this);
+
     gView = view;
+
+    // the repainted parts of the view tell which tiles may have changed
+    QGraphicsView *graphicsView = qobject_cast<QGraphicsView*>(view);
+    mGrabViewport = graphicsView ? graphicsView->viewport() : view;
+    mGrabViewport->installEventFilter(this);
+
     mRefreshTimer.setInterval(40);
     mRefreshTimer.start();
 }
@@ -32,6 +32,10 @@
 
 #include <QtGui>
 #include <QWidget>
+#include <QCache>
+#include <QPointer>
+
+class UBGraphicsScene;
 
 class UBMagnifierParams
 {
@@ -85,8 +89,14 @@ public slots:
 
 private:
     void calculateButtonsPositions();
+
+    QRectF sourceRect(const QPoint &globalPoint) const;
+    void grab();
+    void damage(const QRectF &sceneRect);
+    QImage *cacheTile(const QPoint &tile, bool *changed);
 protected:
     void paintEvent(QPaintEvent *);
+    bool eventFilter(QObject *object, QEvent *event);
 
     virtual void mousePressEvent ( QMouseEvent * event );
     virtual void mouseMoveEvent ( QMouseEvent * event );
@@ -126,7 +136,20 @@ private:
     QBitmap bmpMask;
     QPen borderPen;
 
+    // Raster of the grabbed view, kept as tiles in scene coordinates so that
+    // moving the magnifier only renders the tiles it has not seen yet.
+    // Tiles under a repainted part of the grabbed view are rendered again on
+    // their next use.
+    QCache<quint64, QImage> mTileCache;
+    QPointer<UBGraphicsScene> mCachedScene;
+    qreal mCacheScale;
+    QSet<quint64> mDamagedTiles;
+    QRectF mLastSourceRect;
+    bool mSourceDamaged;
+    bool mOutputOutdated;
+
     QWidget *gView;
+    QPointer<QWidget> mGrabViewport;
     QWidget *mView;
 };
 
@@ -27,6 +27,8 @@
 
 
 #include <QDesktopWidget>
+#include <QAbstractScrollArea>
+#include <QScrollBar>
 
 #include "UBScreenMirror.h"
 
@@ -34,6 +36,7 @@
 #include "core/UBSetting.h"
 #include "core/UBApplication.h"
 #include "board/UBBoardController.h"
+#include "core/UBTrace.h"
 
 #if defined(Q_OS_OSX)
 #include <ApplicationServices/ApplicationServices.h>
@@ -46,6 +49,7 @@ UBScreenMirror::UBScreenMirror(QWidget* parent)
     : QWidget(parent)
     , mScreenIndex(0)
     , mSourceWidget(0)
+    , mIsRenderingSource(false)
     , mTimerID(0)
 {
     // NOOP
@@ -71,7 +75,7 @@ void UBScreenMirror::paintEvent(QPaintEvent *event)
         int x = (width() - mLastPixmap.width()) / 2;
         int y = (height() - mLastPixmap.height()) / 2;
 
-        painter.drawPixmap(x, y, width(), height(), mLastPixmap);
+        painter.drawPixmap(x, y, mLastPixmap);
     }
 }
 
@@ -81,44 +85,249 @@ void UBScreenMirror::timerEvent(QTimerEvent *event)
     Q_UNUSED(event);
 
     grabPixmap();
+}
+
+
+bool UBScreenMirror::eventFilter(QObject *obj, QEvent *event)
+{
+    bool result = QWidget::eventFilter(obj, event);
+
+    if (!mSourceWidget || !obj->isWidgetType())
+        return result;
+
+    QWidget *widget = static_cast<QWidget*>(obj);
 
-    update();
+    if (event->type() == QEvent::Paint && !mIsRenderingSource)
+    {
+        QRegion region = static_cast<QPaintEvent*>(event)->region();
+
+        if (widget == mSourceWidget)
+            mDamage += region;
+        else if (!widget->isWindow())
+            mDamage += region.translated(widget->mapTo(mSourceWidget, QPoint(0, 0)));
+    }
+    else if (event->type() == QEvent::ChildAdded)
+    {
+        QObject *child = static_cast<QChildEvent*>(event)->child();
+
+        if (child->isWidgetType())
+            watchWidget(static_cast<QWidget*>(child), true);
+    }
+
+    return result;
 }
 
-void UBScreenMirror::grabPixmap()
+
+void UBScreenMirror::damageSource()
 {
     if (mSourceWidget)
+        mDamage = mSourceWidget->rect();
+}
+
+
+void UBScreenMirror::watchWidget(QWidget *widget, bool watch)
+{
+    QList<QWidget*> widgets = widget->findChildren<QWidget*>();
+    widgets << widget;
+
+    foreach (QWidget *watched, widgets)
     {
-        QPoint topLeft = mSourceWidget->mapToGlobal(mSourceWidget->geometry().topLeft());
-        QPoint bottomRight = mSourceWidget->mapToGlobal(mSourceWidget->geometry().bottomRight());
+        if (watch)
+            watched->installEventFilter(this);
+        else
+            watched->removeEventFilter(this);
+
+        // scrolled contents are blitted by QWidget::scroll() and only the exposed strip is painted
+        QAbstractScrollArea *scrollArea = qobject_cast<QAbstractScrollArea*>(watched);
 
-        mRect.setTopLeft(topLeft);
-        mRect.setBottomRight(bottomRight);
-        mLastPixmap = mSourceWidget->grab();
+        if (scrollArea)
+        {
+            QList<QScrollBar*> scrollBars;
+            scrollBars << scrollArea->horizontalScrollBar() << scrollArea->verticalScrollBar();
+
+            foreach (QScrollBar *scrollBar, scrollBars)
+            {
+                if (watch)
+                    connect(scrollBar, SIGNAL(valueChanged(int)), this, SLOT(damageSource()), Qt::UniqueConnection);
+                else
+                    disconnect(scrollBar, SIGNAL(valueChanged(int)), this, SLOT(damageSource()));
+            }
+        }
     }
-    else{
-        // WHY HERE?
-        // this is the case we are showing the desktop but the is no widget and we use the last widget rectagle to know
-        // what we have to grab. Not very good way of doing
-        QDesktopWidget * desktop = QApplication::desktop();
-        QScreen * screen = UBApplication::controlScreen();
-        mLastPixmap = screen->grabWindow(desktop->effectiveWinId(), mRect.x(), mRect.y(), mRect.width(), mRect.height());
+}
+
+
+QSize UBScreenMirror::outputSize() const
+{
+    return mSourcePixmap.size().scaled(size(), Qt::KeepAspectRatio);
+}
+
+
+void UBScreenMirror::grabPixmap()
+{
+    UB_TRACE_SCOPE("UBScreenMirror::grabPixmap");
+
+    if (!mSourceWidget)
+    {
+        grabScreen();
+        return;
     }
 
-    if (!mLastPixmap.isNull())
-        mLastPixmap = mLastPixmap.scaled(width(), height(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QPoint topLeft = mSourceWidget->mapToGlobal(mSourceWidget->geometry().topLeft());
+    QPoint bottomRight = mSourceWidget->mapToGlobal(mSourceWidget->geometry().bottomRight());
+
+    mRect.setTopLeft(topLeft);
+    mRect.setBottomRight(bottomRight);
+
+    qreal ratio = mSourceWidget->devicePixelRatioF();
+    QSize pixelSize = mSourceWidget->size() * ratio;
+
+    if (mSourcePixmap.size() != pixelSize)
+    {
+        mSourcePixmap = QPixmap(pixelSize);
+        mSourcePixmap.setDevicePixelRatio(ratio);
+        mSourcePixmap.fill(Qt::black);
+        mDamage = mSourceWidget->rect();
+    }
+
+    if (mLastPixmap.size() != outputSize())
+        mDamage = mSourceWidget->rect();
+
+    mDamage &= mSourceWidget->rect();
+
+    // nothing was painted since the last frame
+    if (mDamage.isEmpty())
+        return;
+
+    QVector<QRect> rects = mDamage.rectCount() > 16 ? QVector<QRect>() << mDamage.boundingRect() : mDamage.rects();
+    mDamage = QRegion();
+
+    // QWidget::render() sends paint events of its own, those are not damage
+    mIsRenderingSource = true;
+
+    QPainter painter(&mSourcePixmap);
+    foreach (const QRect &rect, rects)
+        mSourceWidget->render(&painter, rect.topLeft(), QRegion(rect));
+    painter.end();
+
+    mIsRenderingSource = false;
+
+    foreach (const QRect &rect, rects)
+        scaleToOutput(QRectF(rect.topLeft() * ratio, rect.size() * ratio).toAlignedRect());
+}
+
+
+void UBScreenMirror::grabScreen()
+{
+    // WHY HERE?
+    // this is the case we are showing the desktop but the is no widget and we use the last widget rectagle to know
+    // what we have to grab. Not very good way of doing
+    QDesktopWidget * desktop = QApplication::desktop();
+    QScreen * screen = UBApplication::controlScreen();
+    QPixmap pixmap = screen->grabWindow(desktop->effectiveWinId(), mRect.x(), mRect.y(), mRect.width(), mRect.height());
+
+    if (pixmap.isNull())
+        return;
+
+    // there is no damage information for other applications, so only the
+    // rows that differ from the previous grab are scaled again
+    QImage image = pixmap.toImage();
+    QRect changed = image.rect();
+
+    if (!mLastScreenImage.isNull() && mLastScreenImage.size() == image.size()
+            && mLastScreenImage.format() == image.format() && mLastPixmap.size() == outputSize())
+    {
+        int lineLength = image.width() * image.depth() / 8;
+        int top = 0;
+        int bottom = image.height() - 1;
+
+        while (top <= bottom && memcmp(mLastScreenImage.constScanLine(top), image.constScanLine(top), lineLength) == 0)
+            top++;
+
+        if (top > bottom)
+            return;
+
+        while (memcmp(mLastScreenImage.constScanLine(bottom), image.constScanLine(bottom), lineLength) == 0)
+            bottom--;
+
+        changed = QRect(0, top, image.width(), bottom - top + 1);
+    }
+
+    mSourcePixmap = pixmap;
+    mLastScreenImage = image;
+
+    scaleToOutput(changed);
+}
+
+
+void UBScreenMirror::scaleToOutput(const QRect &sourcePixels)
+{
+    QSize size = outputSize();
+
+    if (size.isEmpty())
+        return;
+
+    QRect target;
+
+    if (mLastPixmap.size() != size)
+    {
+        mLastPixmap = QPixmap(size);
+        target = mLastPixmap.rect();
+    }
+    else
+    {
+        qreal scaleX = (qreal)size.width() / mSourcePixmap.width();
+        qreal scaleY = (qreal)size.height() / mSourcePixmap.height();
+
+        target = QRectF(sourcePixels.x() * scaleX, sourcePixels.y() * scaleY,
+                        sourcePixels.width() * scaleX, sourcePixels.height() * scaleY).toAlignedRect() & mLastPixmap.rect();
+    }
+
+    if (target.isEmpty())
+        return;
+
+    qreal sourceScaleX = (qreal)mSourcePixmap.width() / size.width();
+    qreal sourceScaleY = (qreal)mSourcePixmap.height() / size.height();
+    QRectF source(target.x() * sourceScaleX, target.y() * sourceScaleY,
+                  target.width() * sourceScaleX, target.height() * sourceScaleY);
+
+    QPainter painter(&mLastPixmap);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawPixmap(target, mSourcePixmap, source);
+    painter.end();
+
+    update(target.translated((width() - size.width()) / 2, (height() - size.height()) / 2));
 }
 
 
 void UBScreenMirror::setSourceWidget(QWidget *sourceWidget)
 {
+    if (mSourceWidget)
+        watchWidget(mSourceWidget, false);
+
     mSourceWidget = sourceWidget;
 
     mScreenIndex = qApp->desktop()->screenNumber(sourceWidget);
 
+    if (mSourceWidget)
+    {
+        watchWidget(mSourceWidget, true);
+        mDamage = mSourceWidget->rect();
+    }
+
     grabPixmap();
+}
 
-    update();
+
+void UBScreenMirror::setSourceRect(const QRect& pRect)
+{
+    if (mSourceWidget)
+        watchWidget(mSourceWidget, false);
+
+    mRect = pRect;
+    mSourceWidget = 0;
+    mLastScreenImage = QImage();
 }
 
 
@@ -138,6 +347,9 @@ void UBScreenMirror::start()
             ms = 1000 / fps;
         }
 
+        if (mSourceWidget)
+            mDamage = mSourceWidget->rect();
+
         mTimerID = startTimer(ms);
     }
     else
@@ -32,6 +32,7 @@
 
 #include <QtGui>
 #include <QWidget>
+#include <QPointer>
 
 class UBScreenMirror : public QWidget
 {
@@ -43,31 +44,52 @@ class UBScreenMirror : public QWidget
 
         virtual void paintEvent (QPaintEvent * event);
         virtual void timerEvent(QTimerEvent *event);
+        virtual bool eventFilter(QObject *obj, QEvent *event);
 
     public slots:
 
         void setSourceWidget(QWidget *sourceWidget);
 
-        void setSourceRect(const QRect& pRect)
-        {
-            mRect = pRect;
-            mSourceWidget = 0;
-        }
+        void setSourceRect(const QRect& pRect);
 
         void start();
 
         void stop();
 
+    private slots:
+
+        void damageSource();
+
     private:
 
         void grabPixmap();
 
+        void grabScreen();
+
+        void watchWidget(QWidget* widget, bool watch);
+
+        void scaleToOutput(const QRect& sourcePixels);
+
+        QSize outputSize() const;
+
         int mScreenIndex;
 
-        QWidget* mSourceWidget;
+        QPointer<QWidget> mSourceWidget;
 
         QRect mRect;
 
+        // persistent copy of the source, updated only where it was repainted
+        QPixmap mSourcePixmap;
+
+        // last screen grab in desktop mode, compared against the next one
+        QImage mLastScreenImage;
+
+        // parts of the source, in source widget coordinates, painted since the last frame
+        QRegion mDamage;
+
+        bool mIsRenderingSource;
+
+        // scaled output, reused between frames
         QPixmap mLastPixmap;
 
         long mTimerID;
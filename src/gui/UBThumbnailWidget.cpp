@@ -29,6 +29,7 @@
 #include <QString>
 #include <QCursor>
 #include <QGraphicsRectItem>
+#include <QtMath>
 
 #include "UBThumbnailWidget.h"
 #include "UBRubberBand.h"
@@ -52,10 +53,13 @@ UBThumbnailWidget::UBThumbnailWidget(QWidget* parent)
     : QGraphicsView(parent)
     , mThumbnailWidth(UBSettings::defaultThumbnailWidth)
     , mSpacing(UBSettings::thumbnailSpacing)
+    , mThumbnailsLaidOut(false)
     , mLastSelectedThumbnail(0)
     , mSelectionSpan(0)
-    , mPrevLassoRect(QRect())
+    , mLassoCells(QRect())
     , mLassoRectItem(0)
+    , mDeferSelectionChanged(false)
+    , mSelectionChangedDeferred(false)
 
 {
     // By default, the drag is possible
@@ -68,6 +72,7 @@ UBThumbnailWidget::UBThumbnailWidget(QWidget* parent)
     setAlignment(Qt::AlignLeft | Qt::AlignTop);
 
     connect(&mThumbnailsScene, SIGNAL(selectionChanged()), this, SLOT(sceneSelectionChanged()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(layoutVisibleLabels()));
 }
 
 
@@ -117,102 +122,155 @@ void UBThumbnailWidget::setGraphicsItems(const QList<QGraphicsItem*>& pGraphicsI
         if (item->scene() != &mThumbnailsScene){
             mThumbnailsScene.addItem(item);
         }
+
+        item->setFlag(QGraphicsItem::ItemIsSelectable, true);
     }
 
     mLabelsItems.clear();
 
     foreach (const QString label, pLabels)
     {
-        QFontMetrics fm(font());
         UBThumbnailTextItem *labelItem =
             new UBThumbnailTextItem(label); // deleted while replace or by the scene destruction
 
+        // labels are elided and placed once their row is scrolled into view, see layoutVisibleLabels
+        labelItem->hide();
+
         mThumbnailsScene.addItem(labelItem);
         mLabelsItems << labelItem;
     }
 
+    mThumbnailsLaidOut = false;
+
     refreshScene();
 
     mLastSelectedThumbnail = 0;
 }
 
 
-void UBThumbnailWidget::refreshScene()
+UBThumbnailWidget::GridGeometry UBThumbnailWidget::gridGeometry() const
 {
-    int nbColumns = (geometry().width() - mSpacing) / (mThumbnailWidth + mSpacing);
+    GridGeometry grid;
 
-    int labelSpacing = 0;
+    grid.columns = qMax(1, (int)((geometry().width() - mSpacing) / (mThumbnailWidth + mSpacing)));
+    grid.cellWidth = mThumbnailWidth;
+    grid.cellHeight = mThumbnailWidth / UBSettings::minScreenRatio;
+    grid.spacing = mSpacing;
 
     if (mLabelsItems.size() > 0)
     {
         QFontMetrics fm(mLabelsItems.at(0)->font());
-        labelSpacing = UBSettings::thumbnailSpacing + fm.height();  // TODO UB 4.x where is 20 from ??? configure ?? compute based on mSpacing ?? JBA Is it the font height?
+        grid.labelSpacing = UBSettings::thumbnailSpacing + fm.height();  // TODO UB 4.x where is 20 from ??? configure ?? compute based on mSpacing ?? JBA Is it the font height?
     }
-    nbColumns = qMax(nbColumns, 1);
 
-    qreal thumbnailHeight = mThumbnailWidth / UBSettings::minScreenRatio;
+    return grid;
+}
+
 
-    for (int i = 0; i < mGraphicItems.size(); i++)
+void UBThumbnailWidget::refreshScene()
+{
+    GridGeometry grid = gridGeometry();
+
+    // a resize that keeps the column count does not move anything
+    if (!mThumbnailsLaidOut || !(grid == mGrid))
     {
-        QGraphicsItem* item = mGraphicItems.at(i);
+        mGrid = grid;
 
-        qreal scaleWidth = mThumbnailWidth / item->boundingRect().width();
-        qreal scaleHeight = thumbnailHeight / item->boundingRect().height();
+        for (int i = 0; i < mGraphicItems.size(); i++)
+            layoutThumbnail(i);
 
-        qreal scaleFactor = qMin(scaleWidth, scaleHeight);
+        // labels placed for the previous grid are stale, the visible ones are laid out again below
+        foreach (UBThumbnailTextItem* labelItem, mLabelsItems)
+            labelItem->hide();
 
-        //bitmap should not be stretched
-        UBThumbnail* pix = dynamic_cast<UBThumbnail*>(item);
-        if (pix)
-            scaleFactor = qMin(scaleFactor, 1.0);
+        mThumbnailsLaidOut = true;
+    }
 
-        QTransform transform;
-        transform.scale(scaleFactor, scaleFactor);
+    QScrollBar *vertScrollBar = verticalScrollBar();
+    int scrollBarThickness = 0;
+    if (vertScrollBar && vertScrollBar->isVisible())
+        scrollBarThickness = vertScrollBar->width();
 
-        item->setTransform(transform);
+    setSceneRect(0, 0,
+            geometry().width() - scrollBarThickness,
+            mGrid.spacing + ((((mGraphicItems.size() - 1) / mGrid.columns) + 1) * mGrid.rowHeight()));
 
-        item->setFlag(QGraphicsItem::ItemIsSelectable, true);
+    layoutVisibleLabels();
+}
 
-        int columnIndex = i % nbColumns;
-        int rowIndex = i / nbColumns;
 
-        if (pix)
-        {
-            pix->setColumn(columnIndex);
-            pix->setRow(rowIndex);
-        }
+void UBThumbnailWidget::layoutThumbnail(int index)
+{
+    QGraphicsItem* item = mGraphicItems.at(index);
 
-        int w = item->boundingRect().width();
-        int h = item->boundingRect().height();
-        QPointF pos(
-                mSpacing + (mThumbnailWidth - w * scaleFactor) / 2 + columnIndex * (mThumbnailWidth + mSpacing),
-                mSpacing + rowIndex * (thumbnailHeight + mSpacing + labelSpacing) + (thumbnailHeight - h * scaleFactor) / 2);
+    qreal scaleWidth = mGrid.cellWidth / item->boundingRect().width();
+    qreal scaleHeight = mGrid.cellHeight / item->boundingRect().height();
 
-        item->setPos(pos);
+    qreal scaleFactor = qMin(scaleWidth, scaleHeight);
 
-        if (mLabelsItems.size() > i)
-        {
-            QFontMetrics fm(mLabelsItems.at(i)->font(), this);
-            QString elidedText = fm.elidedText(mLabels.at(i), Qt::ElideRight, mThumbnailWidth);
+    //bitmap should not be stretched
+    UBThumbnail* pix = dynamic_cast<UBThumbnail*>(item);
+    if (pix)
+        scaleFactor = qMin(scaleFactor, 1.0);
+
+    QTransform transform;
+    transform.scale(scaleFactor, scaleFactor);
 
-            mLabelsItems.at(i)->setPlainText(elidedText);
-            mLabelsItems.at(i)->setWidth(fm.width(elidedText) + 2 * mLabelsItems.at(i)->document()->documentMargin());
+    if (item->transform() != transform)
+        item->setTransform(transform);
 
-            pos.setY(pos.y() + (thumbnailHeight + h * scaleFactor) / 2 + 5);
-            qreal labelWidth = fm.width(elidedText);
-            pos.setX(mSpacing + (mThumbnailWidth - labelWidth) / 2 + columnIndex * (mThumbnailWidth + mSpacing));
-            mLabelsItems.at(i)->setPos(pos);
-        }
+    int columnIndex = index % mGrid.columns;
+    int rowIndex = index / mGrid.columns;
+
+    if (pix)
+    {
+        pix->setColumn(columnIndex);
+        pix->setRow(rowIndex);
     }
 
-    QScrollBar *vertScrollBar = verticalScrollBar();
-    int scrollBarThickness = 0;
-    if (vertScrollBar && vertScrollBar->isVisible())
-        scrollBarThickness = vertScrollBar->width();
+    int w = item->boundingRect().width();
+    int h = item->boundingRect().height();
+    QPointF pos(
+            mGrid.spacing + (mGrid.cellWidth - w * scaleFactor) / 2 + columnIndex * mGrid.columnWidth(),
+            mGrid.spacing + rowIndex * mGrid.rowHeight() + (mGrid.cellHeight - h * scaleFactor) / 2);
 
-    setSceneRect(0, 0,
-            geometry().width() - scrollBarThickness,
-            mSpacing + ((((mGraphicItems.size() - 1) / nbColumns) + 1) * (thumbnailHeight + mSpacing + labelSpacing)));
+    item->setPos(pos);
+}
+
+
+void UBThumbnailWidget::layoutLabel(int index)
+{
+    UBThumbnailTextItem* labelItem = mLabelsItems.at(index);
+
+    labelItem->setMaximumWidth(mGrid.cellWidth);
+
+    int columnIndex = index % mGrid.columns;
+    int rowIndex = index / mGrid.columns;
+
+    labelItem->setPos(mGrid.spacing + (mGrid.cellWidth - labelItem->textWidth()) / 2 + columnIndex * mGrid.columnWidth(),
+                      mGrid.spacing + rowIndex * mGrid.rowHeight() + mGrid.cellHeight + 5);
+    labelItem->show();
+}
+
+
+void UBThumbnailWidget::layoutVisibleLabels()
+{
+    if (!mThumbnailsLaidOut || mLabelsItems.isEmpty())
+        return;
+
+    QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+
+    int firstRow = qMax(0, (int)((visibleRect.top() - mGrid.spacing) / mGrid.rowHeight()));
+    int lastRow = qMax(0, (int)((visibleRect.bottom() - mGrid.spacing) / mGrid.rowHeight()));
+
+    int firstIndex = firstRow * mGrid.columns;
+    int lastIndex = qMin(mLabelsItems.size(), (lastRow + 1) * mGrid.columns);
+
+    for (int i = firstIndex; i < lastIndex; i++)
+    {
+        if (!mLabelsItems.at(i)->isVisible())
+            layoutLabel(i);
+    }
 }
 
 
@@ -248,7 +306,7 @@ void UBThumbnailWidget::mousePressEvent(QMouseEvent *event)
         QStyleOption option;
         option.initFrom(&rubberBand);
 
-        mPrevLassoRect = QRect();
+        mLassoCells = QRect();
         mLassoRectItem = new QGraphicsRectItem(0);
         scene()->addItem(mLassoRectItem);
 
@@ -276,13 +334,11 @@ void UBThumbnailWidget::mousePressEvent(QMouseEvent *event)
 
         if (Qt::ControlModifier & event->modifiers() || Qt::ShiftModifier & event->modifiers())
         {
-           // mSelectedThumbnailItems = selectedItems().toSet();
+            mSelectedThumbnailItems = mThumbnailsScene.selectedItems().toSet();
             return;
         }
 
         mSelectedThumbnailItems.clear();
-        mPreviouslyIncrementalSelectedItemsX.clear();
-        mPreviouslyIncrementalSelectedItemsY.clear();
         QGraphicsView::mousePressEvent(event);
     }
     else if (Qt::ShiftModifier & event->modifiers())
@@ -335,101 +391,14 @@ void UBThumbnailWidget::mouseMoveEvent(QMouseEvent *event)
     if (mLassoRectItem)
     {
         bSelectionInProgress = true;
-        int incrementLassoMinWidth = 2;
         QPointF currentScenePos = mapToScene(event->pos());
         QRectF lassoRect(
             qMin(mMousePressScenePos.x(), currentScenePos.x()), qMin(mMousePressScenePos.y(), currentScenePos.y()),
             qAbs(mMousePressScenePos.x() - currentScenePos.x()), qAbs(mMousePressScenePos.y() - currentScenePos.y()));
-        if (QPoint() == prevMoveMousePos)
-            prevMoveMousePos = currentScenePos;
-        QRectF incrementXSelection(
-            qMin(prevMoveMousePos.x(), currentScenePos.x()), qMin(mMousePressScenePos.y(), currentScenePos.y()),
-            qAbs(prevMoveMousePos.x() - currentScenePos.x())+incrementLassoMinWidth, qAbs(mMousePressScenePos.y() - currentScenePos.y()));
-        QRectF incrementYSelection(
-            qMin(mMousePressScenePos.x(), currentScenePos.x()), qMin(prevMoveMousePos.y(), currentScenePos.y()),
-            qAbs(mMousePressScenePos.x() - currentScenePos.x()), qAbs(prevMoveMousePos.y() - currentScenePos.y())+incrementLassoMinWidth);
-
-        prevMoveMousePos = currentScenePos;
-        mLassoRectItem->setRect(lassoRect);
-
-        QSet<QGraphicsItem*> lassoSelectedThumbnailItems;
-
-        QSet<QGraphicsItem*> toUnset;
-        QSet<QGraphicsItem*> toSet;
 
-        // for horizontal moving
-        QSet<QGraphicsItem*> incSelectedItemsX = scene()->items(incrementXSelection, Qt::IntersectsItemBoundingRect).toSet();
-        foreach (QGraphicsItem *lassoSelectedItem, incSelectedItemsX)
-        {
-            if (lassoSelectedItem)
-            {
-                UBThumbnailPixmap *thumbnailItem = dynamic_cast<UBThumbnailPixmap*>(lassoSelectedItem);
-                if (thumbnailItem)
-                     lassoSelectedThumbnailItems += lassoSelectedItem;
-            }
-        }
-
-        if(lassoRect.width() < mPrevLassoRect.width())
-        {
-            if (!lassoSelectedThumbnailItems.contains(mPreviouslyIncrementalSelectedItemsX))
-                toUnset += mPreviouslyIncrementalSelectedItemsX - lassoSelectedThumbnailItems;
-
-        }
-        mPreviouslyIncrementalSelectedItemsX = lassoSelectedThumbnailItems;
-
-        toSet += lassoSelectedThumbnailItems + mPreviouslyIncrementalSelectedItemsX;
-
-
-        lassoSelectedThumbnailItems.clear();
-
-        // for vertical moving
-
-        QSet<QGraphicsItem*> incSelectedItemsY = scene()->items(incrementYSelection, Qt::IntersectsItemBoundingRect).toSet();
-        foreach (QGraphicsItem *lassoSelectedItem, incSelectedItemsY)
-        {
-            if (lassoSelectedItem)
-            {
-                UBThumbnailPixmap *thumbnailItem = dynamic_cast<UBThumbnailPixmap*>(lassoSelectedItem);
-
-                if (thumbnailItem)
-                    lassoSelectedThumbnailItems += lassoSelectedItem;
-            }
-        }
-
-        if(lassoRect.height() < mPrevLassoRect.height())
-        {
-            if (!lassoSelectedThumbnailItems.contains(mPreviouslyIncrementalSelectedItemsY))
-                toUnset += mPreviouslyIncrementalSelectedItemsY - lassoSelectedThumbnailItems;
-
-        }
-        mPreviouslyIncrementalSelectedItemsY = lassoSelectedThumbnailItems;
-
-
-        toSet += lassoSelectedThumbnailItems + mPreviouslyIncrementalSelectedItemsY;
-
-
-        toSet -= toUnset;
-
-        foreach (QGraphicsItem *item, toSet)
-        {
-            item->setSelected(true);
-        }
-
-        foreach (QGraphicsItem *item, toUnset)
-        {
-            item->setSelected(false);
-        }
-
-        mSelectedThumbnailItems += lassoSelectedThumbnailItems;
-        mPrevLassoRect = lassoRect;
+        mLassoRectItem->setRect(lassoRect);
 
-        if (Qt::ControlModifier & event->modifiers())
-        {
-            for (int i = 0; i < mSelectedThumbnailItems.count()-1; i++)
-            {
-                mSelectedThumbnailItems.values().at(i)->setSelected(true);
-            }
-        }
+        updateLassoSelection(cellsIntersecting(lassoRect));
     }
     else
     {
@@ -474,7 +443,7 @@ void UBThumbnailWidget::mouseMoveEvent(QMouseEvent *event)
 void UBThumbnailWidget::mouseReleaseEvent(QMouseEvent *event)
 {
     int elapsedTimeSincePress = mClickTime.elapsed();
-    prevMoveMousePos = QPoint();
+    mLassoCells = QRect();
     deleteLasso();
     QGraphicsView::mouseReleaseEvent(event);
 
@@ -651,7 +620,77 @@ void UBThumbnailWidget::resizeEvent(QResizeEvent *event)
 
 void UBThumbnailWidget::sceneSelectionChanged()
 {
-    emit selectionChanged();
+    if (mDeferSelectionChanged)
+        mSelectionChangedDeferred = true;
+    else
+        emit selectionChanged();
+}
+
+
+QRect UBThumbnailWidget::cellsIntersecting(const QRectF& sceneRect) const
+{
+    if (!mThumbnailsLaidOut || mGraphicItems.isEmpty())
+        return QRect();
+
+    // cell c spans [spacing + c * columnWidth, spacing + c * columnWidth + cellWidth], rows alike
+    int firstColumn = qCeil((sceneRect.left() - mGrid.spacing - mGrid.cellWidth) / mGrid.columnWidth());
+    int lastColumn = qFloor((sceneRect.right() - mGrid.spacing) / mGrid.columnWidth());
+    int firstRow = qCeil((sceneRect.top() - mGrid.spacing - mGrid.cellHeight) / mGrid.rowHeight());
+    int lastRow = qFloor((sceneRect.bottom() - mGrid.spacing) / mGrid.rowHeight());
+
+    firstColumn = qMax(firstColumn, 0);
+    lastColumn = qMin(lastColumn, mGrid.columns - 1);
+    firstRow = qMax(firstRow, 0);
+    lastRow = qMin(lastRow, rowCount() - 1);
+
+    if (firstColumn > lastColumn || firstRow > lastRow)
+        return QRect();
+
+    return QRect(QPoint(firstColumn, firstRow), QPoint(lastColumn, lastRow));
+}
+
+
+void UBThumbnailWidget::updateLassoSelection(const QRect& lassoCells)
+{
+    if (lassoCells == mLassoCells)
+        return;
+
+    mDeferSelectionChanged = true;
+
+    // only the cells entering or leaving the lasso change their selection
+    QRect changedCells = lassoCells.united(mLassoCells);
+
+    for (int row = changedCells.top(); row <= changedCells.bottom(); row++)
+    {
+        for (int column = changedCells.left(); column <= changedCells.right(); column++)
+        {
+            QPoint cell(column, row);
+            bool inLasso = lassoCells.contains(cell);
+
+            if (inLasso == mLassoCells.contains(cell))
+                continue;
+
+            int index = row * mGrid.columns + column;
+            if (index >= mGraphicItems.size())
+                continue;
+
+            QGraphicsItem* item = mGraphicItems.at(index);
+            if (!dynamic_cast<UBThumbnailPixmap*>(item))
+                continue;
+
+            // items selected before a Ctrl or Shift lasso stay selected
+            item->setSelected(inLasso || mSelectedThumbnailItems.contains(item));
+        }
+    }
+
+    mLassoCells = lassoCells;
+
+    mDeferSelectionChanged = false;
+    if (mSelectionChangedDeferred)
+    {
+        mSelectionChangedDeferred = false;
+        emit selectionChanged();
+    }
 }
 
 
@@ -706,17 +745,14 @@ void UBThumbnailWidget::selectAll()
 
 int UBThumbnailWidget::rowCount() const
 {
-    UBThumbnail *lastThumbnail = dynamic_cast<UBThumbnail*>(mGraphicItems.last());
-    return lastThumbnail ? lastThumbnail->row() + 1 : 0;
+    if (mGraphicItems.isEmpty() || mGrid.columns < 1) return 0;
+    return (mGraphicItems.count() - 1) / mGrid.columns + 1;
 }
 
 int UBThumbnailWidget::columnCount() const
 {
-    UBThumbnail *lastThumbnail = dynamic_cast<UBThumbnail*>(mGraphicItems.last());
-    if (!lastThumbnail) return 0;
-    int lastRow = lastThumbnail->row();
-    int lastColumn = lastThumbnail->column();
-    return lastRow > 0 ? (mGraphicItems.count() - lastColumn - 1) / lastRow : mGraphicItems.count();
+    if (mGraphicItems.isEmpty() || mGrid.columns < 1) return 0;
+    return qMin(mGraphicItems.count(), mGrid.columns);
 }
 
 
@@ -90,6 +90,9 @@ class UBThumbnailWidget : public QGraphicsView
         void mouseDoubleClick(QGraphicsItem* item, int index);
         void mouseClick(QGraphicsItem* item, int index);
 
+    private slots:
+        void layoutVisibleLabels();
+
 
     protected:
         virtual void mousePressEvent(QMouseEvent *event);
@@ -114,6 +117,33 @@ class UBThumbnailWidget : public QGraphicsView
         bool bCanDrag;
 
     private:
+        // the thumbnails sit in a regular grid: cells of the thumbnail size, one label line below each row
+        struct GridGeometry
+        {
+            GridGeometry() : columns(0), cellWidth(0), cellHeight(0), spacing(0), labelSpacing(0) {}
+
+            int columns;
+            qreal cellWidth;
+            qreal cellHeight;
+            qreal spacing;
+            qreal labelSpacing;
+
+            qreal rowHeight() const { return cellHeight + spacing + labelSpacing; }
+            qreal columnWidth() const { return cellWidth + spacing; }
+
+            bool operator==(const GridGeometry& other) const
+            {
+                return columns == other.columns && cellWidth == other.cellWidth && cellHeight == other.cellHeight
+                        && spacing == other.spacing && labelSpacing == other.labelSpacing;
+            }
+        };
+
+        GridGeometry gridGeometry() const;
+        void layoutThumbnail(int index);
+        void layoutLabel(int index);
+        QRect cellsIntersecting(const QRectF& sceneRect) const;
+        void updateLassoSelection(const QRect& lassoCells);
+
         void selectAll();
         void selectItems(int startIndex, int count);
         int rowCount() const;
@@ -127,19 +157,20 @@ class UBThumbnailWidget : public QGraphicsView
 
         QString mMimeType;
 
-        QPointF prevMoveMousePos;
-
         qreal mThumbnailWidth;
         qreal mThumbnailHeight;
         qreal mSpacing;
 
+        GridGeometry mGrid;
+        bool mThumbnailsLaidOut;
+
         UBThumbnail *mLastSelectedThumbnail;
         int mSelectionSpan;
-        QRectF mPrevLassoRect;
+        QRect mLassoCells;
         QGraphicsRectItem *mLassoRectItem;
         QSet<QGraphicsItem*> mSelectedThumbnailItems;
-        QSet<QGraphicsItem*> mPreviouslyIncrementalSelectedItemsX;
-        QSet<QGraphicsItem*> mPreviouslyIncrementalSelectedItemsY;
+        bool mDeferSelectionChanged;
+        bool mSelectionChangedDeferred;
         QTime mClickTime;
 };
 
@@ -217,6 +248,8 @@ class UBThumbnailTextItem : public QGraphicsTextItem
         UBThumbnailTextItem(int index)
             : QGraphicsTextItem(tr("Page %0").arg(index+1))
             , mWidth(0)
+            , mMaximumWidth(-1)
+            , mTextWidth(0)
             , mUnelidedText(toPlainText())
             , mIsHighlighted(false)
         {
@@ -226,6 +259,8 @@ class UBThumbnailTextItem : public QGraphicsTextItem
         UBThumbnailTextItem(const QString& text)
             : QGraphicsTextItem(text)
             , mWidth(0)
+            , mMaximumWidth(-1)
+            , mTextWidth(0)
             , mUnelidedText(text)
             , mIsHighlighted(false)
         {
@@ -246,6 +281,26 @@ class UBThumbnailTextItem : public QGraphicsTextItem
 
         qreal width() {return mWidth;}
 
+        // elides the text to pMaximumWidth and fits the item to it; the elided text is kept until the maximum width changes
+        void setMaximumWidth(qreal pMaximumWidth)
+        {
+            if (mMaximumWidth == pMaximumWidth)
+                return;
+
+            mMaximumWidth = pMaximumWidth;
+
+            QFontMetricsF fm(font());
+            QString elidedText = fm.elidedText(mUnelidedText, Qt::ElideRight, mMaximumWidth);
+            mTextWidth = fm.width(elidedText);
+
+            prepareGeometryChange();
+            mWidth = mTextWidth + 2 * document()->documentMargin();
+            computeText();
+        }
+
+        qreal maximumWidth() const { return mMaximumWidth; }
+        qreal textWidth() const { return mTextWidth; }
+
         void highlight()
         {
                 if (!mIsHighlighted)
@@ -272,6 +327,8 @@ class UBThumbnailTextItem : public QGraphicsTextItem
 
     private:
         qreal mWidth;
+        qreal mMaximumWidth;
+        qreal mTextWidth;
         QString mUnelidedText;
         bool mIsHighlighted;
 };
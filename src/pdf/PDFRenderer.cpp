@@ -77,6 +77,17 @@ PDFRenderer* PDFRenderer::rendererForUuid(const QUuid &uuid, const QString &file
     }
 }
 
+PDFRenderer* PDFRenderer::createUnsharedRenderer(const QString &filename)
+{
+    PDFRenderer *newRenderer = new XPDFRenderer(filename, true);
+
+    QDesktopWidget* desktop = UBApplication::desktop();
+    int dpiCommon = (desktop->physicalDpiX() + desktop->physicalDpiY()) / 2;
+    newRenderer->setDPI(dpiCommon);
+
+    return newRenderer;
+}
+
 void PDFRenderer::setRefCount(const QAtomicInt &refCount)
 {
     mRefCount = refCount;
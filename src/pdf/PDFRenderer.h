@@ -46,6 +46,10 @@ class PDFRenderer : public QObject
 
     public:
         static PDFRenderer* rendererForUuid(const QUuid &uuid, const QString &filename, bool importingFile = false);
+
+        // A renderer of its own, neither shared nor cached, for use on a worker thread; the caller deletes it.
+        static PDFRenderer* createUnsharedRenderer(const QString &filename);
+
         virtual ~PDFRenderer();
 
         virtual bool isValid() const = 0;
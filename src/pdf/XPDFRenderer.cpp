@@ -38,6 +38,7 @@
 
 #include "core/memcheck.h"
 #include "core/UBSettings.h"
+#include "core/UBTrace.h"
 
 
 QAtomicInt XPDFRenderer::sInstancesCount = 0;
@@ -229,6 +230,8 @@ int XPDFRenderer::pageRotation(int pageNumber) const
 
 QImage* XPDFRenderer::createPDFImageHistorical(int pageNumber, qreal xscale, qreal yscale, const QRectF &bounds)
 {
+    UB_TRACE_SCOPE("XPDFRenderer::createPDFImageHistorical");
+
     if (isValid())
     {
         if(mSplashHistorical)
@@ -277,6 +280,8 @@ void XPDFRenderer::OnThreadFinished()
 
 void XPDFRenderer::render(QPainter *p, int pageNumber, bool const cacheAllowed, const QRectF &bounds)
 {
+    UB_TRACE_SCOPE("XPDFRenderer::render");
+
     //qDebug() << "render enter";
     Q_UNUSED(bounds);
     if (isValid())
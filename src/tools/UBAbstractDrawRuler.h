@@ -33,6 +33,7 @@
 #include <QtGui>
 #include <QGraphicsItem>
 #include "frameworks/UBGeometryUtils.h"
+#include "tools/UBToolLayerCache.h"
 
 class UBGraphicsScene;
 class QGraphicsSvgItem;
@@ -69,6 +70,8 @@ protected:
 
     QPointF startDrawPosition;
 
+    UBToolLayerCache mLayerCache;
+
     QCursor moveCursor() const;
     QCursor rotateCursor() const;
     QCursor closeCursor() const;
@@ -162,10 +162,28 @@ void UBGraphicsAxes::paint(QPainter *painter, const QStyleOptionGraphicsItem *st
     qreal ratio = mAntiScaleRatio > 1.0 ? mAntiScaleRatio : 1.0;
     antiScaleTransform2.scale(ratio, 1.0);
 
+    // Update the width of one "centimeter" to correspond to the width of the background grid (whether it is displayed or not)
+    mPixelsPerCentimeter = UBApplication::boardController->activeScene()->backgroundGridSize();
+
+    painter->setRenderHint(QPainter::Antialiasing, true);
+
+    QString layerKey = QString("%1 %2 %3")
+            .arg(drawColor().name(QColor::HexArgb))
+            .arg(mPixelsPerCentimeter)
+            .arg(mShowNumbers);
+
+    mLayerCache.paint(painter, boundingRect(), layerKey, [this](QPainter* layerPainter)
+    {
+        paintAxes(layerPainter);
+    });
+}
+
+
+void UBGraphicsAxes::paintAxes(QPainter *painter)
+{
     QPen pen(drawColor());
     pen.setWidthF(2);
     painter->setPen(pen);
-    painter->setRenderHint(QPainter::Antialiasing, true);
     painter->drawLine(xAxis());
     painter->drawLine(yAxis());
 
@@ -209,9 +227,6 @@ void UBGraphicsAxes::paintGraduations(QPainter *painter)
     painter->setFont(font());
     QFontMetricsF fontMetrics(painter->font());
 
-    // Update the width of one "centimeter" to correspond to the width of the background grid (whether it is displayed or not)
-    mPixelsPerCentimeter = UBApplication::boardController->activeScene()->backgroundGridSize();
-
     // When a "centimeter" is too narrow, we only display every 5th number
     double numbersWidth = fontMetrics.boundingRect("-00").width();
     bool shouldDisplayAllNumbers = (numbersWidth <= (mPixelsPerCentimeter - 5));
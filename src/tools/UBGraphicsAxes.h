@@ -36,6 +36,7 @@
 
 #include "core/UB.h"
 #include "domain/UBItem.h"
+#include "tools/UBToolLayerCache.h"
 
 class UBGraphicsScene;
 
@@ -74,6 +75,7 @@ class UBGraphicsAxes : public QObject, public QGraphicsPolygonItem, public UBIte
 
         virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *styleOption, QWidget *widget);
         virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+        void paintAxes(QPainter *painter);
         void paintGraduations(QPainter *painter);
         void setRect(const QRectF &rect);
 
@@ -121,6 +123,8 @@ class UBGraphicsAxes : public QObject, public QGraphicsPolygonItem, public UBIte
         qreal mPixelsPerCentimeter;
         QRectF mBounds;
 
+        UBToolLayerCache mLayerCache;
+
         // Constants
         static const QRect     sDefaultRect;
 
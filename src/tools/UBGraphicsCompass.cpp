@@ -142,6 +142,23 @@ void UBGraphicsCompass::paint(QPainter *painter, const QStyleOptionGraphicsItem
         resizeButtonRect().center().y() - mResizeSvgItem->boundingRect().height() * mAntiScaleRatio / 2);
 
     painter->setPen(drawColor());
+
+    QString layerKey = QString("%1 %2").arg(drawColor().name(QColor::HexArgb)).arg(pencilColor().name(QColor::HexArgb));
+    mLayerCache.paint(painter, boundingRect(), layerKey, [this](QPainter* layerPainter)
+    {
+        paintBody(layerPainter);
+    });
+
+    if (mShowButtons)
+        paintAngleDisplay(painter);
+
+    if (mResizing || mRotating || mDrawing || (mShowButtons && rect().width() > sDisplayRadiusOnPencilArmMinLength))
+        paintRadiusDisplay(painter);
+}
+
+
+void UBGraphicsCompass::paintBody(QPainter *painter)
+{
     painter->drawRoundedRect(hingeRect(), sCornerRadius, sCornerRadius);
     painter->fillPath(hingeShape(), middleFillColor());
 
@@ -160,8 +177,6 @@ void UBGraphicsCompass::paint(QPainter *painter, const QStyleOptionGraphicsItem
 
     QRectF hingeGripRect(rect().center().x() - 16, rect().center().y() - 16, 32, 32);
     painter->drawEllipse(hingeGripRect);
-    if (mShowButtons)
-        paintAngleDisplay(painter);
 
     QLinearGradient pencilArmLinearGradient(
         QPointF(hingeRect().right(), rect().center().y()),
@@ -171,16 +186,19 @@ void UBGraphicsCompass::paint(QPainter *painter, const QStyleOptionGraphicsItem
     painter->fillPath(pencilArmShape(), pencilArmLinearGradient);
     painter->drawPath(pencilArmShape());
 
-    if (scene()->isDarkBackground())
-        painter->fillPath(pencilShape(), UBApplication::boardController->penColorOnDarkBackground());
-    else
-        painter->fillPath(pencilShape(), UBApplication::boardController->penColorOnLightBackground());
+    painter->fillPath(pencilShape(), pencilColor());
 
     painter->fillPath(pencilBaseShape(), middleFillColor());
     painter->drawPath(pencilBaseShape());
+}
 
-    if (mResizing || mRotating || mDrawing || (mShowButtons && rect().width() > sDisplayRadiusOnPencilArmMinLength))
-        paintRadiusDisplay(painter);
+
+QColor UBGraphicsCompass::pencilColor() const
+{
+    if (scene()->isDarkBackground())
+        return UBApplication::boardController->penColorOnDarkBackground();
+    else
+        return UBApplication::boardController->penColorOnLightBackground();
 }
 
 
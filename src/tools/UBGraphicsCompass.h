@@ -35,6 +35,7 @@
 
 #include "core/UB.h"
 #include "domain/UBItem.h"
+#include "tools/UBToolLayerCache.h"
 
 class UBGraphicsScene;
 
@@ -75,6 +76,7 @@ class UBGraphicsCompass: public QObject, public QGraphicsRectItem, public UBItem
 
     private:
         // Helpers
+        void                    paintBody(QPainter *painter);
         void            paintAngleDisplay(QPainter *painter);
         void           paintRadiusDisplay(QPainter *painter);
         void           rotateAroundNeedle(qreal angle);
@@ -105,6 +107,7 @@ class UBGraphicsCompass: public QObject, public QGraphicsRectItem, public UBItem
         QColor                  drawColor() const;
         QColor            middleFillColor() const;
         QColor              edgeFillColor() const;
+        QColor                pencilColor() const;
         QFont                        font() const;
         qreal              angleInDegrees() const;
 
@@ -124,6 +127,8 @@ class UBGraphicsCompass: public QObject, public QGraphicsRectItem, public UBItem
         qreal mAntiScaleRatio;
         bool mDrewCenterCross;
 
+        UBToolLayerCache mLayerCache;
+
         // Constants
         static const int                      sNeedleLength = 12;
         static const int                       sNeedleWidth = 3;
@@ -126,12 +126,21 @@ void UBGraphicsRuler::paint(QPainter *painter, const QStyleOptionGraphicsItem *s
 
 
 
+    // Update the width of one "centimeter" to correspond to the width of the background grid (whether it is displayed or not)
+    sPixelsPerCentimeter = UBApplication::boardController->activeScene()->backgroundGridSize();
+
     painter->setPen(drawColor());
     painter->setBrush(edgeFillColor());
     painter->setRenderHint(QPainter::Antialiasing, true);
-    painter->drawRoundedRect(rect(), sRoundingRadius, sRoundingRadius);
-    fillBackground(painter);
-    paintGraduations(painter);
+
+    QString layerKey = QString("%1 %2").arg(drawColor().name(QColor::HexArgb)).arg(sPixelsPerCentimeter);
+    mLayerCache.paint(painter, boundingRect(), layerKey, [this](QPainter* layerPainter)
+    {
+        layerPainter->drawRoundedRect(rect(), sRoundingRadius, sRoundingRadius);
+        fillBackground(layerPainter);
+        paintGraduations(layerPainter);
+    });
+
     if (mRotating)
         paintRotationCenter(painter);
 }
@@ -177,9 +186,6 @@ void UBGraphicsRuler::paintGraduations(QPainter *painter)
     painter->setFont(font());
     QFontMetricsF fontMetrics(painter->font());
 
-    // Update the width of one "centimeter" to correspond to the width of the background grid (whether it is displayed or not)
-    sPixelsPerCentimeter = UBApplication::boardController->activeScene()->backgroundGridSize();
-
     qreal pixelsPerMillimeter = sPixelsPerCentimeter/10.0;
     int rulerLengthInMillimeters = (rect().width() - sLeftEdgeMargin - sRoundingRadius)/pixelsPerMillimeter;
 
@@ -270,7 +270,53 @@ void UBGraphicsTriangle::calculatePoints(const QRectF& r)
 
 void UBGraphicsTriangle::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
+    // Update the width of one "centimeter" to correspond to the width of the background grid (whether it is displayed or not)
+    sPixelsPerCentimeter = UBApplication::boardController->activeScene()->backgroundGridSize();
+
+    QString layerKey = QString("%1 %2 %3 %4")
+            .arg(drawColor().name(QColor::HexArgb))
+            .arg(sPixelsPerCentimeter)
+            .arg(mOrientation)
+            .arg(mShouldPaintInnerTriangle);
+
+    mLayerCache.paint(painter, boundingRect(), layerKey, [this](QPainter* layerPainter)
+    {
+        paintBody(layerPainter);
+        paintGraduations(layerPainter);
+    });
+
+    painter->setPen(drawColor());
+
+    mAntiScaleRatio = 1 / (UBApplication::boardController->systemScaleFactor() * UBApplication::boardController->currentZoom());
+    QTransform antiScaleTransform;
+    antiScaleTransform.scale(mAntiScaleRatio, mAntiScaleRatio);
+
+    mCloseSvgItem->setTransform(antiScaleTransform);
+    mHFlipSvgItem->setTransform(antiScaleTransform);
+    mVFlipSvgItem->setTransform(antiScaleTransform);
+    mRotateSvgItem->setTransform(antiScaleTransform);
+
+    mCloseSvgItem->setPos(closeButtonRect().topLeft());
+
+    //qDebug() << "UBGraphicsTriangle Paint"<<"closeButtonRect().topLeft()="
+    //<<closeButtonRect().topLeft();
+
+    mHFlipSvgItem->setPos(hFlipRect().topLeft());
+    mVFlipSvgItem->setPos(vFlipRect().topLeft());
+    mRotateSvgItem->setPos(rotateRect().topLeft());
+
+    if (mShowButtons || mResizing1 || mResizing2)
+    {
+        painter->setBrush(QColor(0, 0, 0));
+        if (mShowButtons || mResizing1)
+            painter->drawPolygon(resize1Polygon());
+        if (mShowButtons || mResizing2)
+            painter->drawPolygon(resize2Polygon());
+    }
+}
 
+void UBGraphicsTriangle::paintBody(QPainter *painter)
+{
     painter->setPen(Qt::NoPen);
 
     QPolygonF polygon;
@@ -322,38 +368,6 @@ void UBGraphicsTriangle::paint(QPainter *painter, const QStyleOptionGraphicsItem
         painter->drawPolygon(polygon);
         polygon.clear();
     }
-
-
-    paintGraduations(painter);
-
-    mAntiScaleRatio = 1 / (UBApplication::boardController->systemScaleFactor() * UBApplication::boardController->currentZoom());
-    QTransform antiScaleTransform;
-    antiScaleTransform.scale(mAntiScaleRatio, mAntiScaleRatio);
-
-    mCloseSvgItem->setTransform(antiScaleTransform);
-    mHFlipSvgItem->setTransform(antiScaleTransform);
-    mVFlipSvgItem->setTransform(antiScaleTransform);
-    mRotateSvgItem->setTransform(antiScaleTransform);
-
-    mCloseSvgItem->setPos(closeButtonRect().topLeft());
-
-    //qDebug() << "UBGraphicsTriangle Paint"<<"closeButtonRect().topLeft()="
-    //<<closeButtonRect().topLeft();
-
-    mHFlipSvgItem->setPos(hFlipRect().topLeft());
-    mVFlipSvgItem->setPos(vFlipRect().topLeft());
-    mRotateSvgItem->setPos(rotateRect().topLeft());
-
-    if (mShowButtons || mResizing1 || mResizing2)
-    {
-        painter->setBrush(QColor(0, 0, 0));
-        if (mShowButtons || mResizing1)
-            painter->drawPolygon(resize1Polygon());
-        if (mShowButtons || mResizing2)
-            painter->drawPolygon(resize2Polygon());
-    }
-
-
 }
 
 QPainterPath UBGraphicsTriangle::shape() const
@@ -389,8 +403,6 @@ void UBGraphicsTriangle::paintGraduations(QPainter *painter)
     painter->setFont(font());
     QFontMetricsF fontMetrics(painter->font());
 
-    // Update the width of one "centimeter" to correspond to the width of the background grid (whether it is displayed or not)
-    sPixelsPerCentimeter = UBApplication::boardController->activeScene()->backgroundGridSize();
     double pixelsPerMillimeter = sPixelsPerCentimeter/10.0;
 
     // When a "centimeter" is too narrow, we only display every 5th number, and every 5th millimeter mark
@@ -141,6 +141,7 @@ class UBGraphicsTriangle : public UBAbstractDrawRuler, public QGraphicsPolygonIt
         virtual void    hoverLeaveEvent(QGraphicsSceneHoverEvent *event);
         virtual void    hoverMoveEvent(QGraphicsSceneHoverEvent *event);
         void paintGraduations(QPainter *painter);
+        void paintBody(QPainter *painter);
 
     private:
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#include "UBToolLayerCache.h"
+
+#include "core/memcheck.h"
+
+// beyond that, (very long axes at high zoom) the layer is painted directly
+const int UBToolLayerCache::sMaximumPixmapSide = 4096;
+
+
+UBToolLayerCache::UBToolLayerCache()
+    : mScale(0)
+{
+    // NOOP
+}
+
+
+void UBToolLayerCache::invalidate()
+{
+    mPixmap = QPixmap();
+}
+
+
+void UBToolLayerCache::paint(QPainter* painter, const QRectF& area, const QString& key, const std::function<void(QPainter*)>& paintLayer)
+{
+    QTransform deviceTransform = painter->deviceTransform();
+    qreal scale = qSqrt(deviceTransform.m11() * deviceTransform.m11() + deviceTransform.m12() * deviceTransform.m12());
+
+    QSize pixmapSize(qCeil(area.width() * scale), qCeil(area.height() * scale));
+
+    if (pixmapSize.isEmpty() || pixmapSize.width() > sMaximumPixmapSide || pixmapSize.height() > sMaximumPixmapSide)
+    {
+        invalidate();
+
+        painter->save();
+        paintLayer(painter);
+        painter->restore();
+        return;
+    }
+
+    if (mPixmap.isNull() || mArea != area || !qFuzzyCompare(mScale, scale) || mKey != key)
+    {
+        mPixmap = QPixmap(pixmapSize);
+        mPixmap.fill(Qt::transparent);
+
+        QPainter layerPainter(&mPixmap);
+        layerPainter.setRenderHints(painter->renderHints());
+        layerPainter.setPen(painter->pen());
+        layerPainter.setBrush(painter->brush());
+        layerPainter.setFont(painter->font());
+        layerPainter.scale(scale, scale);
+        layerPainter.translate(-area.topLeft());
+
+        paintLayer(&layerPainter);
+
+        mArea = area;
+        mScale = scale;
+        mKey = key;
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter->drawPixmap(QRectF(area.topLeft(), QSizeF(pixmapSize) / scale), mPixmap, QRectF(mPixmap.rect()));
+    painter->restore();
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2015-2018 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+#ifndef UBTOOLLAYERCACHE_H_
+#define UBTOOLLAYERCACHE_H_
+
+#include <functional>
+
+#include <QtGui>
+
+/*
+ * Raster cache for the part of a tool that doesn't change while it is dragged or rotated
+ * (body, graduations and their labels).
+ *
+ * The layer is rendered at the device scale of the painter, and only again when the painted area,
+ * the scale (zoom, screen) or the caller supplied key (colors, grid size, orientation...) changes.
+ * Moving or rotating the tool only blits the cached pixmap.
+ */
+class UBToolLayerCache
+{
+    public:
+
+        UBToolLayerCache();
+
+        void invalidate();
+
+        void paint(QPainter* painter, const QRectF& area, const QString& key, const std::function<void(QPainter*)>& paintLayer);
+
+    private:
+
+        QPixmap mPixmap;
+        QRectF mArea;
+        qreal mScale;
+        QString mKey;
+
+        static const int sMaximumPixmapSide;
+};
+
+#endif /* UBTOOLLAYERCACHE_H_ */